@@ -46,7 +46,7 @@ out = {}
 
 def get_check_output(exec: str, type: str, omp_nthreads: int = 1, mkl_nthreads: int = 1) -> tuple[bool, dict[str, list[float]]]:
     print(f"Run {exec} with OMP_NTHREADS={omp_nthreads}, MKL_NTHREADS={mkl_nthreads}")
-    out = subprocess.run(exec, capture_output=True, env=environ.update({"OMP_NUM_THREADS": str(omp_nthreads), "MKL_NUM_THREAD": str(mkl_nthreads)})).stderr.decode()
+    out = subprocess.run(exec, capture_output=True, env=environ.update({"OMP_NUM_THREADS": str(omp_nthreads), "MKL_NUM_THREADS": str(mkl_nthreads), "POLYBENCH_THREADS": str(omp_nthreads), "POLYBENCH_BLAS_THREADS": str(mkl_nthreads)})).stderr.decode()
     dump_region = re.search("(?<===BEGIN DUMP_ARRAYS==\n)(?s:.)*(?===END   DUMP_ARRAYS==)", out)
     if dump_region == None:
         print(f"Cannot find DUMP_ARRAYS region in {type}...")
@@ -66,7 +66,7 @@ def get_check_output(exec: str, type: str, omp_nthreads: int = 1, mkl_nthreads:
     return True, result
 
 def get_run_output(exec: str, omp_nthreads: int, mkl_nthreads: int) -> float:
-    out = subprocess.run(exec, capture_output=True, env=environ.update({"OMP_NUM_THREADS": str(omp_nthreads), "MKL_NUM_THREAD": str(mkl_nthreads)})).stdout.decode()
+    out = subprocess.run(exec, capture_output=True, env=environ.update({"OMP_NUM_THREADS": str(omp_nthreads), "MKL_NUM_THREADS": str(mkl_nthreads), "POLYBENCH_THREADS": str(omp_nthreads), "POLYBENCH_BLAS_THREADS": str(mkl_nthreads)})).stdout.decode()
     result = float("nan")
     try:
         result = float(out.strip())
@@ -153,7 +153,11 @@ if __name__ == "__main__":
         "intel": "intel",
         "polly": "polly",
         "pluto": "pluto",
-        "opt_cublas": "optimized_cublas"
+        "opt_cublas": "optimized_cublas",
+        "opt_openblas": "optimized_openblas",
+        "opt_blis": "optimized_blis",
+        "opt_cblas": "optimized_cblas",
+        "opt_builtin": "optimized_builtin"
     }
     from sys import argv
     from os import makedirs
@@ -0,0 +1,243 @@
+/*
+ * blas_batch.h: deferred execution of the independent BLAS calls of a
+ * batched loop in the optimized versions.
+ *
+ * The generated code redirects cblas_dgemm and cblas_dgemv to the
+ * recorders below while it runs a loop of independent calls and flushes
+ * the recorded calls after the loop. Calls of identical shape whose
+ * operands lie at constant distances become a single strided batch call
+ * of MKL, all other batches run the calls on OpenMP threads with one
+ * thread per call. Must be included after the CBLAS header of the library
+ * and thread_budget.h, if used.
+ */
+#ifndef BLAS_BATCH_H
+# define BLAS_BATCH_H
+
+# include <stdlib.h>
+
+# if defined(INTEL_MKL_VERSION) && INTEL_MKL_VERSION >= 20200002
+#  define BLAS_BATCH_DGEMM_STRIDED
+# endif
+# if defined(INTEL_MKL_VERSION) && INTEL_MKL_VERSION >= 20210001
+#  define BLAS_BATCH_DGEMV_STRIDED
+# endif
+
+/* Arguments of the recorded calls. The enums are kept as int, their type
+   names differ between the CBLAS headers. */
+typedef struct
+{
+  int layout, trans_a, trans_b;
+  long m, n, k;
+  double alpha;
+  const double* a;
+  long lda;
+  const double* b;
+  long ldb;
+  double beta;
+  double* c;
+  long ldc;
+} blas_batch_dgemm_call;
+
+typedef struct
+{
+  int layout, trans;
+  long m, n;
+  double alpha;
+  const double* a;
+  long lda;
+  const double* x;
+  long incx;
+  double beta;
+  double* y;
+  long incy;
+} blas_batch_dgemv_call;
+
+typedef struct
+{
+  blas_batch_dgemm_call* dgemm;
+  long dgemm_count, dgemm_capacity;
+  blas_batch_dgemv_call* dgemv;
+  long dgemv_count, dgemv_capacity;
+} blas_batch;
+
+/* Per thread, concurrent tasks of blas_tasks.h record their own batches. */
+static _Thread_local blas_batch blas_batch_current;
+
+static inline
+void* blas_batch_grow(void* calls, long* capacity, long count, size_t size)
+{
+  if (count < *capacity)
+    return calls;
+  *capacity = *capacity > 0 ? 2 * *capacity : 64;
+  calls = realloc (calls, *capacity * size);
+  if (calls == NULL)
+    abort ();
+  return calls;
+}
+
+static inline
+void polybench_blas_batch_begin()
+{
+  blas_batch_current.dgemm_count = 0;
+  blas_batch_current.dgemv_count = 0;
+}
+
+static inline
+void polybench_blas_batch_dgemm(int layout, int trans_a, int trans_b, long m, long n, long k,
+				double alpha, const double* a, long lda, const double* b,
+				long ldb, double beta, double* c, long ldc)
+{
+  blas_batch* batch = &blas_batch_current;
+  blas_batch_dgemm_call* call;
+  batch->dgemm = blas_batch_grow (batch->dgemm, &batch->dgemm_capacity, batch->dgemm_count,
+				  sizeof (blas_batch_dgemm_call));
+  call = &batch->dgemm[batch->dgemm_count++];
+  call->layout = layout;
+  call->trans_a = trans_a;
+  call->trans_b = trans_b;
+  call->m = m;
+  call->n = n;
+  call->k = k;
+  call->alpha = alpha;
+  call->a = a;
+  call->lda = lda;
+  call->b = b;
+  call->ldb = ldb;
+  call->beta = beta;
+  call->c = c;
+  call->ldc = ldc;
+}
+
+static inline
+void polybench_blas_batch_dgemv(int layout, int trans, long m, long n, double alpha,
+				const double* a, long lda, const double* x, long incx,
+				double beta, double* y, long incy)
+{
+  blas_batch* batch = &blas_batch_current;
+  blas_batch_dgemv_call* call;
+  batch->dgemv = blas_batch_grow (batch->dgemv, &batch->dgemv_capacity, batch->dgemv_count,
+				  sizeof (blas_batch_dgemv_call));
+  call = &batch->dgemv[batch->dgemv_count++];
+  call->layout = layout;
+  call->trans = trans;
+  call->m = m;
+  call->n = n;
+  call->alpha = alpha;
+  call->a = a;
+  call->lda = lda;
+  call->x = x;
+  call->incx = incx;
+  call->beta = beta;
+  call->y = y;
+  call->incy = incy;
+}
+
+/* Distance of the i-th pointer to the first one in elements, the batch is
+   strided if the distance grows by the same non-negative step. */
+static inline
+int blas_batch_strided(const double* first, const double* current, long i, long* stride)
+{
+  long distance = current - first;
+  if (i == 1)
+    *stride = distance;
+  return *stride >= 0 && distance == i * *stride;
+}
+
+static inline
+void blas_batch_flush_dgemm(const blas_batch_dgemm_call* calls, long count)
+{
+  long i;
+# ifdef BLAS_BATCH_DGEMM_STRIDED
+  const blas_batch_dgemm_call* first = &calls[0];
+  long stride_a = 0, stride_b = 0, stride_c = 0;
+  int uniform = count > 1;
+  for (i = 1; i < count && uniform; i++)
+    {
+      const blas_batch_dgemm_call* call = &calls[i];
+      uniform = call->layout == first->layout && call->trans_a == first->trans_a
+	&& call->trans_b == first->trans_b && call->m == first->m && call->n == first->n
+	&& call->k == first->k && call->alpha == first->alpha && call->lda == first->lda
+	&& call->ldb == first->ldb && call->beta == first->beta && call->ldc == first->ldc
+	&& blas_batch_strided (first->a, call->a, i, &stride_a)
+	&& blas_batch_strided (first->b, call->b, i, &stride_b)
+	&& blas_batch_strided (first->c, call->c, i, &stride_c);
+    }
+  if (uniform)
+    {
+      cblas_dgemm_batch_strided (first->layout, first->trans_a, first->trans_b, first->m,
+				 first->n, first->k, first->alpha, first->a, first->lda,
+				 stride_a, first->b, first->ldb, stride_b, first->beta,
+				 first->c, first->ldc, stride_c, count);
+      return;
+    }
+# endif
+# ifdef THREAD_BUDGET_H
+  int budget = polybench_thread_budget_nested_begin ();
+# endif
+  /* The libraries run sequentially inside a parallel region. */
+# pragma omp parallel for schedule(dynamic) if(count > 1)
+  for (i = 0; i < count; i++)
+    cblas_dgemm (calls[i].layout, calls[i].trans_a, calls[i].trans_b, calls[i].m, calls[i].n,
+		 calls[i].k, calls[i].alpha, calls[i].a, calls[i].lda, calls[i].b, calls[i].ldb,
+		 calls[i].beta, calls[i].c, calls[i].ldc);
+# ifdef THREAD_BUDGET_H
+  polybench_thread_budget_nested_end (budget);
+# endif
+}
+
+static inline
+void blas_batch_flush_dgemv(const blas_batch_dgemv_call* calls, long count)
+{
+  long i;
+# ifdef BLAS_BATCH_DGEMV_STRIDED
+  const blas_batch_dgemv_call* first = &calls[0];
+  long stride_a = 0, stride_x = 0, stride_y = 0;
+  int uniform = count > 1;
+  for (i = 1; i < count && uniform; i++)
+    {
+      const blas_batch_dgemv_call* call = &calls[i];
+      uniform = call->layout == first->layout && call->trans == first->trans
+	&& call->m == first->m && call->n == first->n && call->alpha == first->alpha
+	&& call->lda == first->lda && call->incx == first->incx && call->beta == first->beta
+	&& call->incy == first->incy
+	&& blas_batch_strided (first->a, call->a, i, &stride_a)
+	&& blas_batch_strided (first->x, call->x, i, &stride_x)
+	&& blas_batch_strided (first->y, call->y, i, &stride_y);
+    }
+  if (uniform)
+    {
+      cblas_dgemv_batch_strided (first->layout, first->trans, first->m, first->n,
+				 first->alpha, first->a, first->lda, stride_a, first->x,
+				 first->incx, stride_x, first->beta, first->y, first->incy,
+				 stride_y, count);
+      return;
+    }
+# endif
+# ifdef THREAD_BUDGET_H
+  int budget = polybench_thread_budget_nested_begin ();
+# endif
+# pragma omp parallel for schedule(dynamic) if(count > 1)
+  for (i = 0; i < count; i++)
+    cblas_dgemv (calls[i].layout, calls[i].trans, calls[i].m, calls[i].n, calls[i].alpha,
+		 calls[i].a, calls[i].lda, calls[i].x, calls[i].incx, calls[i].beta,
+		 calls[i].y, calls[i].incy);
+# ifdef THREAD_BUDGET_H
+  polybench_thread_budget_nested_end (budget);
+# endif
+}
+
+/* The recorded calls are independent of each other, their order does not
+   matter. */
+static inline
+void polybench_blas_batch_flush()
+{
+  blas_batch* batch = &blas_batch_current;
+  if (batch->dgemm_count > 0)
+    blas_batch_flush_dgemm (batch->dgemm, batch->dgemm_count);
+  if (batch->dgemv_count > 0)
+    blas_batch_flush_dgemv (batch->dgemv, batch->dgemv_count);
+  batch->dgemm_count = 0;
+  batch->dgemv_count = 0;
+}
+
+#endif /* !BLAS_BATCH_H */
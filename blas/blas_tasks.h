@@ -0,0 +1,130 @@
+/*
+ * blas_tasks.h: thread budgets of independent library calls that the
+ * optimized versions run concurrently as OpenMP tasks.
+ *
+ * The library budget of thread_budget.h is split evenly between the
+ * tasks of a region. A task hands its share to MKL and the built-in BLAS
+ * through their thread-local settings. Every other library gets the
+ * smallest share for the whole region through its global thread control,
+ * and the OpenMP thread count of the task. POLYBENCH_BLAS_TASKS=0 issues
+ * the tasks one after another with all threads each, the baseline of the
+ * comparison. Must be included after thread_budget.h.
+ */
+#ifndef BLAS_TASKS_H
+# define BLAS_TASKS_H
+
+# include <stdlib.h>
+# ifdef _OPENMP
+#  include <omp.h>
+# endif
+
+typedef struct
+{
+  int concurrent;
+  int tasks;
+  int threads;
+  int max_active_levels;
+  int mkl_dynamic;
+  int blas_budget;
+} blas_tasks;
+
+static blas_tasks blas_tasks_current;
+
+static inline
+void polybench_blas_tasks_begin(int tasks)
+{
+  blas_tasks* region = &blas_tasks_current;
+  const char* value = getenv ("POLYBENCH_BLAS_TASKS");
+  region->concurrent = tasks > 1 && (value == NULL || *value == '\0' || atoi (value) != 0);
+  region->tasks = tasks;
+# ifdef _OPENMP
+  region->threads = polybench_thread_budget_blas ();
+  /* Every task needs a thread of its own. */
+  if (region->threads < tasks)
+    region->concurrent = 0;
+  if (region->concurrent)
+    {
+      /* The library calls open a second level of parallelism, the
+	 budget keeps it closed elsewhere. */
+      region->max_active_levels = omp_get_max_active_levels ();
+      if (region->max_active_levels < 2)
+	omp_set_max_active_levels (2);
+    }
+# else
+  region->concurrent = 0;
+# endif
+# ifdef INTEL_MKL_VERSION
+  /* Otherwise MKL runs sequentially inside the parallel region. */
+  if (region->concurrent)
+    {
+      region->mkl_dynamic = mkl_get_dynamic ();
+      mkl_set_dynamic (0);
+    }
+# elif !defined(BUILTIN_BLAS_H)
+  if (region->concurrent)
+    {
+      region->blas_budget = polybench_thread_budget_nested_begin ();
+      thread_budget_set_blas (region->threads / tasks);
+    }
+# endif
+}
+
+static inline
+int polybench_blas_tasks_concurrent()
+{
+  return blas_tasks_current.concurrent;
+}
+
+static inline
+void polybench_blas_task_begin(int task)
+{
+  blas_tasks* region = &blas_tasks_current;
+  int budget;
+  if (!region->concurrent)
+    return;
+  /* The first tasks get the remaining threads. */
+  budget = region->threads / region->tasks + (task < region->threads % region->tasks);
+# ifdef _OPENMP
+  omp_set_num_threads (budget);
+# endif
+# ifdef INTEL_MKL_VERSION
+  mkl_set_num_threads_local (budget);
+# endif
+# ifdef BUILTIN_BLAS_H
+  builtin_blas_set_num_threads_local (budget);
+# endif
+}
+
+static inline
+void polybench_blas_task_end()
+{
+  if (!blas_tasks_current.concurrent)
+    return;
+  /* The thread may run other code after the task, 0 restores the global
+     settings. */
+# ifdef INTEL_MKL_VERSION
+  mkl_set_num_threads_local (0);
+# endif
+# ifdef BUILTIN_BLAS_H
+  builtin_blas_set_num_threads_local (0);
+# endif
+}
+
+static inline
+void polybench_blas_tasks_end()
+{
+  blas_tasks* region = &blas_tasks_current;
+  if (!region->concurrent)
+    return;
+# ifdef _OPENMP
+  omp_set_max_active_levels (region->max_active_levels);
+# endif
+# ifdef INTEL_MKL_VERSION
+  mkl_set_dynamic (region->mkl_dynamic);
+# elif !defined(BUILTIN_BLAS_H)
+  polybench_thread_budget_nested_end (region->blas_budget);
+# endif
+  region->concurrent = 0;
+}
+
+#endif /* !BLAS_TASKS_H */
@@ -0,0 +1,463 @@
+/*
+ * builtin_blas.h: header-only BLAS of the optimized versions on machines
+ * without a vendor library.
+ *
+ * Only double precision and the CBLAS entry points of the einsum lowering
+ * are provided. GEMM, SYMM and SYRK share one cache-blocked kernel: B is
+ * packed into KC x NR slivers, A into MC x KC blocks of MR-row slivers
+ * scaled by alpha, and an MR x NR register tile accumulates their product.
+ * The tile and block sizes are compile-time constants, e.g.
+ * -DBUILTIN_BLAS_NR=16 for AVX-512. Level 2 and level 3 calls run on
+ * OpenMP threads once their work exceeds BUILTIN_BLAS_PARALLEL_WORK.
+ */
+#ifndef BUILTIN_BLAS_H
+# define BUILTIN_BLAS_H
+
+# include <stdlib.h>
+# include <string.h>
+# ifdef _OPENMP
+#  include <omp.h>
+# endif
+
+/* Register tile of the micro-kernel, NR should be a multiple of the SIMD
+   width. */
+# ifndef BUILTIN_BLAS_MR
+#  define BUILTIN_BLAS_MR 4
+# endif
+# ifndef BUILTIN_BLAS_NR
+#  define BUILTIN_BLAS_NR 8
+# endif
+/* Cache blocks: a KC x NR sliver of B stays in L1, an MC x KC block of A
+   in L2 and a KC x NC panel of B in L3. */
+# ifndef BUILTIN_BLAS_KC
+#  define BUILTIN_BLAS_KC 256
+# endif
+# ifndef BUILTIN_BLAS_MC
+#  define BUILTIN_BLAS_MC 96
+# endif
+# ifndef BUILTIN_BLAS_NC
+#  define BUILTIN_BLAS_NC 4096
+# endif
+/* Tiles of C in SYRK, off-diagonal tiles are plain GEMMs. */
+# ifndef BUILTIN_BLAS_SYRK_TILE
+#  define BUILTIN_BLAS_SYRK_TILE 256
+# endif
+/* Multiply-adds below which a call stays sequential. */
+# ifndef BUILTIN_BLAS_PARALLEL_WORK
+#  define BUILTIN_BLAS_PARALLEL_WORK 65536
+# endif
+
+typedef enum { CblasRowMajor = 101, CblasColMajor = 102 } CBLAS_LAYOUT;
+typedef CBLAS_LAYOUT CBLAS_ORDER;
+typedef enum { CblasNoTrans = 111, CblasTrans = 112, CblasConjTrans = 113 } CBLAS_TRANSPOSE;
+typedef enum { CblasUpper = 121, CblasLower = 122 } CBLAS_UPLO;
+typedef enum { CblasNonUnit = 131, CblasUnit = 132 } CBLAS_DIAG;
+typedef enum { CblasLeft = 141, CblasRight = 142 } CBLAS_SIDE;
+
+/* Thread count of the calls, 0 uses all OpenMP threads. Weak, so that all
+   translation units including the header share it. */
+int builtin_blas_num_threads __attribute__((weak)) = 0;
+
+/* Thread count of the calls of the current thread, 0 falls back to the
+   global count. Concurrent tasks split the threads this way. */
+_Thread_local int builtin_blas_local_num_threads __attribute__((weak)) = 0;
+
+static inline
+void builtin_blas_set_num_threads(int threads)
+{
+  builtin_blas_num_threads = threads;
+}
+
+static inline
+void builtin_blas_set_num_threads_local(int threads)
+{
+  builtin_blas_local_num_threads = threads;
+}
+
+/* Threads of a call doing work multiply-adds. Without OpenMP the pragmas
+   taking the count vanish, the calls then cast it to void. */
+static inline
+int builtin_blas_threads(double work)
+{
+# ifdef _OPENMP
+  if (work < BUILTIN_BLAS_PARALLEL_WORK)
+    return 1;
+  if (builtin_blas_local_num_threads > 0)
+    return builtin_blas_local_num_threads;
+  return builtin_blas_num_threads > 0 ? builtin_blas_num_threads : omp_get_max_threads ();
+# else
+  (void) work;
+  return 1;
+# endif
+}
+
+static inline
+int builtin_blas_thread_id()
+{
+# ifdef _OPENMP
+  return omp_get_thread_num ();
+# else
+  return 0;
+# endif
+}
+
+/* Offset of the first element of a vector with a negative increment. */
+static inline
+long builtin_blas_start(long n, long inc)
+{
+  return inc < 0 ? (1 - n) * inc : 0;
+}
+
+/* Logical matrix operand: element (i,j) is data[i * rs + j * cs]. A
+   symmetric operand only stores the triangle given by uplo. */
+typedef struct
+{
+  const double* data;
+  long rs;
+  long cs;
+  int symmetric;
+  CBLAS_UPLO uplo;
+} builtin_blas_operand;
+
+static inline
+builtin_blas_operand builtin_blas_matrix(CBLAS_LAYOUT layout, CBLAS_TRANSPOSE trans,
+					 const double* data, long ld)
+{
+  builtin_blas_operand op;
+  long rs = layout == CblasRowMajor ? ld : 1;
+  long cs = layout == CblasRowMajor ? 1 : ld;
+  op.data = data;
+  op.rs = trans == CblasNoTrans ? rs : cs;
+  op.cs = trans == CblasNoTrans ? cs : rs;
+  op.symmetric = 0;
+  op.uplo = CblasUpper;
+  return op;
+}
+
+static inline
+double builtin_blas_at(const builtin_blas_operand* op, long i, long j)
+{
+  if (op->symmetric && (op->uplo == CblasLower ? j > i : j < i))
+    return op->data[j * op->rs + i * op->cs];
+  return op->data[i * op->rs + j * op->cs];
+}
+
+/* MR-row slivers of rows [i0, i0 + mc) and columns [p0, p0 + kc) of A,
+   scaled by alpha and padded with zeros. */
+static inline
+void builtin_blas_pack_a(const builtin_blas_operand* a, long i0, long mc, long p0, long kc,
+			 double alpha, double* buffer)
+{
+  long ir, p, r;
+  for (ir = 0; ir < mc; ir += BUILTIN_BLAS_MR)
+    {
+      double* sliver = buffer + ir * kc;
+      for (p = 0; p < kc; p++)
+	for (r = 0; r < BUILTIN_BLAS_MR; r++)
+	  sliver[p * BUILTIN_BLAS_MR + r] =
+	    ir + r < mc ? alpha * builtin_blas_at (a, i0 + ir + r, p0 + p) : 0.0;
+    }
+}
+
+/* NR-column sliver starting at column j of rows [p0, p0 + kc) of B. */
+static inline
+void builtin_blas_pack_b(const builtin_blas_operand* b, long n, long p0, long kc,
+			 long j, double* sliver)
+{
+  long p, c;
+  for (p = 0; p < kc; p++)
+    for (c = 0; c < BUILTIN_BLAS_NR; c++)
+      sliver[p * BUILTIN_BLAS_NR + c] = j + c < n ? builtin_blas_at (b, p0 + p, j + c) : 0.0;
+}
+
+/* C[0:mr, 0:nr] += A sliver * B sliver over kc. The constant trip counts
+   let the compiler keep the tile in vector registers. */
+static inline
+void builtin_blas_kernel(long kc, const double* restrict a, const double* restrict b,
+			 double* c, long rsc, long csc, long mr, long nr)
+{
+  double tile[BUILTIN_BLAS_MR][BUILTIN_BLAS_NR];
+  long p, i, j;
+  memset (tile, 0, sizeof(tile));
+  for (p = 0; p < kc; p++)
+    for (i = 0; i < BUILTIN_BLAS_MR; i++)
+      {
+	double a_ip = a[p * BUILTIN_BLAS_MR + i];
+#pragma omp simd
+	for (j = 0; j < BUILTIN_BLAS_NR; j++)
+	  tile[i][j] += a_ip * b[p * BUILTIN_BLAS_NR + j];
+      }
+  for (i = 0; i < mr; i++)
+    for (j = 0; j < nr; j++)
+      c[i * rsc + j * csc] += tile[i][j];
+}
+
+/* C = alpha * A * B + beta * C with A m x k and B k x n. */
+static inline
+void builtin_blas_gemm(long m, long n, long k, double alpha, const builtin_blas_operand* a,
+		       const builtin_blas_operand* b, double beta, double* c, long rsc,
+		       long csc, int threads)
+{
+  long i, j, jc, pc;
+  long panel = (BUILTIN_BLAS_NC + BUILTIN_BLAS_NR - 1) / BUILTIN_BLAS_NR * BUILTIN_BLAS_NR;
+  double* b_buffer;
+  double* a_buffers;
+
+  /* Zero beta overwrites, NaNs in C must not survive. */
+  if (beta != 1.0)
+    {
+#pragma omp parallel for num_threads(threads) if(threads > 1) private(j)
+      for (i = 0; i < m; i++)
+	for (j = 0; j < n; j++)
+	  c[i * rsc + j * csc] = beta == 0.0 ? 0.0 : beta * c[i * rsc + j * csc];
+    }
+  if (alpha == 0.0 || k == 0 || m == 0 || n == 0)
+    return;
+
+  b_buffer = (double*) malloc (BUILTIN_BLAS_KC * panel * sizeof(double));
+  a_buffers = (double*) malloc ((size_t) threads * BUILTIN_BLAS_KC * BUILTIN_BLAS_MC
+				* sizeof(double));
+  for (jc = 0; jc < n; jc += BUILTIN_BLAS_NC)
+    {
+      long nc = n - jc < BUILTIN_BLAS_NC ? n - jc : BUILTIN_BLAS_NC;
+      for (pc = 0; pc < k; pc += BUILTIN_BLAS_KC)
+	{
+	  long kc = k - pc < BUILTIN_BLAS_KC ? k - pc : BUILTIN_BLAS_KC;
+#pragma omp parallel num_threads(threads) if(threads > 1)
+	  {
+	    long ic, ir, jr;
+	    double* a_buffer = a_buffers
+	      + (size_t) builtin_blas_thread_id () * BUILTIN_BLAS_KC * BUILTIN_BLAS_MC;
+#pragma omp for schedule(static)
+	    for (jr = 0; jr < nc; jr += BUILTIN_BLAS_NR)
+	      builtin_blas_pack_b (b, n, pc, kc, jc + jr, b_buffer + jr * kc);
+#pragma omp for schedule(dynamic)
+	    for (ic = 0; ic < m; ic += BUILTIN_BLAS_MC)
+	      {
+		long mc = m - ic < BUILTIN_BLAS_MC ? m - ic : BUILTIN_BLAS_MC;
+		builtin_blas_pack_a (a, ic, mc, pc, kc, alpha, a_buffer);
+		for (jr = 0; jr < nc; jr += BUILTIN_BLAS_NR)
+		  for (ir = 0; ir < mc; ir += BUILTIN_BLAS_MR)
+		    builtin_blas_kernel (kc, a_buffer + ir * kc, b_buffer + jr * kc,
+					 c + (ic + ir) * rsc + (jc + jr) * csc, rsc, csc,
+					 mc - ir < BUILTIN_BLAS_MR ? mc - ir : BUILTIN_BLAS_MR,
+					 nc - jr < BUILTIN_BLAS_NR ? nc - jr : BUILTIN_BLAS_NR);
+	      }
+	  }
+	}
+    }
+  free (a_buffers);
+  free (b_buffer);
+}
+
+static inline
+void cblas_dgemm(const CBLAS_LAYOUT layout, const CBLAS_TRANSPOSE trans_a,
+		 const CBLAS_TRANSPOSE trans_b, const int m, const int n, const int k,
+		 const double alpha, const double* a, const int lda, const double* b,
+		 const int ldb, const double beta, double* c, const int ldc)
+{
+  builtin_blas_operand op_a = builtin_blas_matrix (layout, trans_a, a, lda);
+  builtin_blas_operand op_b = builtin_blas_matrix (layout, trans_b, b, ldb);
+  builtin_blas_operand op_c = builtin_blas_matrix (layout, CblasNoTrans, c, ldc);
+  builtin_blas_gemm (m, n, k, alpha, &op_a, &op_b, beta, c, op_c.rs, op_c.cs,
+		     builtin_blas_threads ((double) m * n * k));
+}
+
+static inline
+void cblas_dsymm(const CBLAS_LAYOUT layout, const CBLAS_SIDE side, const CBLAS_UPLO uplo,
+		 const int m, const int n, const double alpha, const double* a, const int lda,
+		 const double* b, const int ldb, const double beta, double* c, const int ldc)
+{
+  builtin_blas_operand op_a = builtin_blas_matrix (layout, CblasNoTrans, a, lda);
+  builtin_blas_operand op_b = builtin_blas_matrix (layout, CblasNoTrans, b, ldb);
+  builtin_blas_operand op_c = builtin_blas_matrix (layout, CblasNoTrans, c, ldc);
+  long k = side == CblasLeft ? m : n;
+  op_a.symmetric = 1;
+  op_a.uplo = uplo;
+  if (side == CblasLeft)
+    builtin_blas_gemm (m, n, k, alpha, &op_a, &op_b, beta, c, op_c.rs, op_c.cs,
+		       builtin_blas_threads ((double) m * n * k));
+  else
+    builtin_blas_gemm (m, n, k, alpha, &op_b, &op_a, beta, c, op_c.rs, op_c.cs,
+		       builtin_blas_threads ((double) m * n * k));
+}
+
+/* Triangle of C = alpha * A * A^T + beta * C, tile by tile. Only the
+   diagonal tiles go through a temporary. */
+static inline
+void cblas_dsyrk(const CBLAS_LAYOUT layout, const CBLAS_UPLO uplo, const CBLAS_TRANSPOSE trans,
+		 const int n, const int k, const double alpha, const double* a, const int lda,
+		 const double beta, double* c, const int ldc)
+{
+  builtin_blas_operand op_a = builtin_blas_matrix (layout, trans, a, lda);
+  builtin_blas_operand op_c = builtin_blas_matrix (layout, CblasNoTrans, c, ldc);
+  long tiles = (n + BUILTIN_BLAS_SYRK_TILE - 1) / BUILTIN_BLAS_SYRK_TILE;
+  int threads = builtin_blas_threads ((double) n * n * k / 2);
+  long t;
+  (void) threads;
+
+#pragma omp parallel for num_threads(threads) if(threads > 1) schedule(dynamic)
+  for (t = 0; t < tiles * tiles; t++)
+    {
+      long ti = t / tiles, tj = t % tiles;
+      long i0 = ti * BUILTIN_BLAS_SYRK_TILE, j0 = tj * BUILTIN_BLAS_SYRK_TILE;
+      long mi = n - i0 < BUILTIN_BLAS_SYRK_TILE ? n - i0 : BUILTIN_BLAS_SYRK_TILE;
+      long nj = n - j0 < BUILTIN_BLAS_SYRK_TILE ? n - j0 : BUILTIN_BLAS_SYRK_TILE;
+      builtin_blas_operand rows = op_a, columns = op_a;
+      double* c_tile = c + i0 * op_c.rs + j0 * op_c.cs;
+      if (uplo == CblasLower ? tj > ti : tj < ti)
+	continue;
+      /* A[i0:, :] times the transpose of A[j0:, :] */
+      rows.data = op_a.data + i0 * op_a.rs;
+      columns.data = op_a.data + j0 * op_a.rs;
+      columns.rs = op_a.cs;
+      columns.cs = op_a.rs;
+      if (ti != tj)
+	builtin_blas_gemm (mi, nj, k, alpha, &rows, &columns, beta, c_tile, op_c.rs, op_c.cs, 1);
+      else
+	{
+	  double* tile = (double*) malloc (mi * nj * sizeof(double));
+	  long i, j;
+	  builtin_blas_gemm (mi, nj, k, alpha, &rows, &columns, 0.0, tile, nj, 1, 1);
+	  for (i = 0; i < mi; i++)
+	    for (j = uplo == CblasLower ? 0 : i; j < (uplo == CblasLower ? i + 1 : nj); j++)
+	      {
+		double* element = c_tile + i * op_c.rs + j * op_c.cs;
+		*element = tile[i * nj + j] + (beta == 0.0 ? 0.0 : beta * *element);
+	      }
+	  free (tile);
+	}
+    }
+}
+
+/* y = alpha * op(A) * x + beta * y. Rows of op(A) that are contiguous are
+   dot products, otherwise blocks of y accumulate column by column. */
+static inline
+void cblas_dgemv(const CBLAS_LAYOUT layout, const CBLAS_TRANSPOSE trans, const int m,
+		 const int n, const double alpha, const double* a, const int lda,
+		 const double* x, const int incx, const double beta, double* y, const int incy)
+{
+  builtin_blas_operand op = builtin_blas_matrix (layout, trans, a, lda);
+  long rows = trans == CblasNoTrans ? m : n;
+  long columns = trans == CblasNoTrans ? n : m;
+  long x0 = builtin_blas_start (columns, incx), y0 = builtin_blas_start (rows, incy);
+  int threads = builtin_blas_threads ((double) m * n);
+  long i, j, ib;
+  (void) threads;
+
+  if (op.cs == 1)
+    {
+#pragma omp parallel for num_threads(threads) if(threads > 1) private(j)
+      for (i = 0; i < rows; i++)
+	{
+	  const double* row = op.data + i * op.rs;
+	  double* y_i = y + y0 + i * incy;
+	  double sum = 0.0;
+#pragma omp simd reduction(+:sum)
+	  for (j = 0; j < columns; j++)
+	    sum += row[j] * x[x0 + j * incx];
+	  *y_i = alpha * sum + (beta == 0.0 ? 0.0 : beta * *y_i);
+	}
+      return;
+    }
+
+#pragma omp parallel for num_threads(threads) if(threads > 1) private(i, j) schedule(static)
+  for (ib = 0; ib < rows; ib += BUILTIN_BLAS_MC * BUILTIN_BLAS_NR)
+    {
+      long size = rows - ib < BUILTIN_BLAS_MC * BUILTIN_BLAS_NR
+	? rows - ib : BUILTIN_BLAS_MC * BUILTIN_BLAS_NR;
+      double sum[BUILTIN_BLAS_MC * BUILTIN_BLAS_NR];
+      memset (sum, 0, size * sizeof(double));
+      for (j = 0; j < columns; j++)
+	{
+	  const double* column = op.data + ib * op.rs + j * op.cs;
+	  double x_j = x[x0 + j * incx];
+#pragma omp simd
+	  for (i = 0; i < size; i++)
+	    sum[i] += column[i * op.rs] * x_j;
+	}
+      for (i = 0; i < size; i++)
+	{
+	  double* y_i = y + y0 + (ib + i) * incy;
+	  *y_i = alpha * sum[i] + (beta == 0.0 ? 0.0 : beta * *y_i);
+	}
+    }
+}
+
+/* A += alpha * x * y^T */
+static inline
+void cblas_dger(const CBLAS_LAYOUT layout, const int m, const int n, const double alpha,
+		const double* x, const int incx, const double* y, const int incy, double* a,
+		const int lda)
+{
+  builtin_blas_operand op = builtin_blas_matrix (layout, CblasNoTrans, a, lda);
+  long x0 = builtin_blas_start (m, incx), y0 = builtin_blas_start (n, incy);
+  int threads = builtin_blas_threads ((double) m * n);
+  long i, j;
+  (void) threads;
+
+#pragma omp parallel for num_threads(threads) if(threads > 1) private(j)
+  for (i = 0; i < m; i++)
+    {
+      double scale = alpha * x[x0 + i * incx];
+      double* row = a + i * op.rs;
+#pragma omp simd
+      for (j = 0; j < n; j++)
+	row[j * op.cs] += scale * y[y0 + j * incy];
+    }
+}
+
+static inline
+double cblas_ddot(const int n, const double* x, const int incx, const double* y,
+		  const int incy)
+{
+  long x0 = builtin_blas_start (n, incx), y0 = builtin_blas_start (n, incy);
+  int threads = builtin_blas_threads (n);
+  double sum = 0.0;
+  long i;
+  (void) threads;
+
+#pragma omp parallel for simd num_threads(threads) if(threads > 1) reduction(+:sum)
+  for (i = 0; i < n; i++)
+    sum += x[x0 + i * incx] * y[y0 + i * incy];
+  return sum;
+}
+
+static inline
+void cblas_daxpy(const int n, const double alpha, const double* x, const int incx, double* y,
+		 const int incy)
+{
+  long x0 = builtin_blas_start (n, incx), y0 = builtin_blas_start (n, incy);
+  int threads = builtin_blas_threads (n);
+  long i;
+  (void) threads;
+
+#pragma omp parallel for simd num_threads(threads) if(threads > 1)
+  for (i = 0; i < n; i++)
+    y[y0 + i * incy] += alpha * x[x0 + i * incx];
+}
+
+static inline
+void cblas_dscal(const int n, const double alpha, double* x, const int incx)
+{
+  int threads = builtin_blas_threads (n);
+  long i;
+  (void) threads;
+
+  /* BLAS scales in place and never uses negative increments here. */
+#pragma omp parallel for simd num_threads(threads) if(threads > 1)
+  for (i = 0; i < n; i++)
+    x[i * incx] *= alpha;
+}
+
+static inline
+void cblas_dcopy(const int n, const double* x, const int incx, double* y, const int incy)
+{
+  long x0 = builtin_blas_start (n, incx), y0 = builtin_blas_start (n, incy);
+  long i;
+
+  for (i = 0; i < n; i++)
+    y[y0 + i * incy] = x[x0 + i * incx];
+}
+
+#endif /* !BUILTIN_BLAS_H */
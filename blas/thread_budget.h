@@ -0,0 +1,101 @@
+/*
+ * thread_budget.h: thread budgets of the regions of the optimized
+ * versions.
+ *
+ * The kernel owns polybench_threads () threads, one per physical core
+ * unless POLYBENCH_THREADS says otherwise. POLYBENCH_BLAS_THREADS sets
+ * the share of the library, it defaults to the same count. The generated
+ * code sets the budget of OpenMP and of the library in front of every
+ * region whose needs differ from the previous one: parallel loops and
+ * library calls of sequential code get all threads, calls on the threads
+ * of a parallel loop get one.
+ * Nested parallel regions are off, only the task regions of blas_tasks.h
+ * open a second level. Must be included after polybench.h and the header
+ * of the library, POLYBENCH_BLAS_SET_NUM_THREADS names the thread control
+ * of the library if it has one.
+ */
+#ifndef THREAD_BUDGET_H
+# define THREAD_BUDGET_H
+
+# ifdef _OPENMP
+#  include <omp.h>
+# endif
+
+/* The full budget of the kernel. */
+# define POLYBENCH_THREADS_ALL 0
+
+typedef struct
+{
+  int openmp;
+  int blas;
+  /* Last count handed to the library, 0 before the first region. */
+  int blas_current;
+} thread_budget;
+
+static thread_budget thread_budget_current;
+
+static inline
+void thread_budget_set_blas(int threads)
+{
+  /* The thread controls of the libraries are not free. */
+  if (threads == thread_budget_current.blas_current)
+    return;
+  thread_budget_current.blas_current = threads;
+# ifdef POLYBENCH_BLAS_SET_NUM_THREADS
+  POLYBENCH_BLAS_SET_NUM_THREADS (threads);
+# endif
+}
+
+static inline
+void polybench_thread_budget_init()
+{
+  thread_budget_current.openmp = polybench_threads ();
+  /* Library calls of sequential code do not run next to the OpenMP
+     loops, their share is independent of the OpenMP one. */
+  thread_budget_current.blas = polybench_blas_threads () > 0
+    ? polybench_blas_threads () : thread_budget_current.openmp;
+  thread_budget_current.blas_current = 0;
+# ifdef _OPENMP
+  omp_set_max_active_levels (1);
+  /* The first touch of the arrays runs with the threads of the loops. */
+  omp_set_num_threads (thread_budget_current.openmp);
+# endif
+}
+
+/* Budget of the next region, POLYBENCH_THREADS_ALL for the full share. */
+static inline
+void polybench_thread_budget(int openmp, int blas)
+{
+# ifdef _OPENMP
+  omp_set_num_threads (openmp == POLYBENCH_THREADS_ALL ? thread_budget_current.openmp : openmp);
+# endif
+  thread_budget_set_blas (blas == POLYBENCH_THREADS_ALL ? thread_budget_current.blas : blas);
+}
+
+static inline
+int polybench_thread_budget_blas()
+{
+  return thread_budget_current.blas;
+}
+
+/* Library calls on the threads of a parallel loop of the runtime, e.g. a
+   batch flush, run sequentially. The end restores the budget of the
+   region. */
+static inline
+int polybench_thread_budget_nested_begin()
+{
+  int previous = thread_budget_current.blas_current;
+  thread_budget_set_blas (1);
+  return previous;
+}
+
+static inline
+void polybench_thread_budget_nested_end(int previous)
+{
+  /* Before the first region the library gets the full share. */
+  int threads = previous > 0 ? previous : thread_budget_current.blas;
+  if (threads > 0)
+    thread_budget_set_blas (threads);
+}
+
+#endif /* !THREAD_BUDGET_H */
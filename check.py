@@ -9,7 +9,7 @@ def get_benchmark_output(exec: str, type: str, omp_nthreads: int = 1, mkl_nthrea
     if not isfile(exec):
         print(f"{exec} does not exist...")
         return False, {}
-    out = subprocess.run(exec, capture_output=True, env=environ.update({"OMP_NUM_THREADS": str(omp_nthreads), "MKL_NUM_THREAD": str(mkl_nthreads)})).stderr.decode()
+    out = subprocess.run(exec, capture_output=True, env=environ.update({"OMP_NUM_THREADS": str(omp_nthreads), "MKL_NUM_THREADS": str(mkl_nthreads), "POLYBENCH_THREADS": str(omp_nthreads), "POLYBENCH_BLAS_THREADS": str(mkl_nthreads)})).stderr.decode()
     dump_region = re.search("(?<===BEGIN DUMP_ARRAYS==\n)(?s:.)*(?===END   DUMP_ARRAYS==)", out)
     if dump_region == None:
         print(f"Cannot find DUMP_ARRAYS region in {type}...")
@@ -88,6 +88,7 @@ if __name__ == "__main__":
         "linear-algebra/kernels/bicg",
         "linear-algebra/kernels/doitgen",
         "linear-algebra/kernels/mvt",
+        "linear-algebra/solvers/durbin",
         "linear-algebra/solvers/gramschmidt",
         "linear-algebra/solvers/trisolv",
         "medley/deriche",
@@ -0,0 +1,248 @@
+/*
+ * cuda_residency.cuh: device residency of the arrays of the CUBLAS
+ * kernels.
+ *
+ * Every cuBLAS call of the generated code copies its operands into fresh
+ * device buffers and its results back. The header redirects those copies
+ * and frees: a buffer holding a host range stays alive, a later copy of
+ * the range to the device reads it on the device and a copy back is
+ * deferred until the host needs the data. The kernel registers the arrays
+ * of its calls, downloads an array before host code touches it, drops the
+ * device copies after host code wrote it and downloads the live-outs at
+ * the end of the timed region. Arrays are registered with their extent
+ * and copies of memory outside of all of them go through.
+ * POLYBENCH_CUDA_RESIDENCY=0 registers nothing, the baseline of the
+ * comparison. Must be included after the CUDA headers.
+ */
+#ifndef CUDA_RESIDENCY_CUH
+# define CUDA_RESIDENCY_CUH
+
+# include <cstddef>
+# include <cstdlib>
+# include <vector>
+
+struct cuda_resident
+{
+  const char* host;
+  size_t size;
+  char* device;
+  /* False while the device holds the newer data. */
+  bool host_valid;
+  /* Base of the registered array the range belongs to. */
+  const char* array;
+};
+
+struct cuda_array
+{
+  const char* base;
+  size_t size;
+};
+
+struct cuda_residency
+{
+  std::vector<cuda_array> arrays;
+  std::vector<cuda_resident> ranges;
+};
+
+static cuda_residency cuda_residency_current;
+
+/* Base of the registered array holding the address, NULL outside of
+   all of them. */
+static inline
+const char* cuda_residency_array(const void* ptr)
+{
+  const char* address = (const char*) ptr;
+  for (const cuda_array& array : cuda_residency_current.arrays)
+    if (array.base <= address && address < array.base + array.size)
+      return array.base;
+  return NULL;
+}
+
+static inline
+bool cuda_residency_overlap(const cuda_resident& range, const char* host, size_t size)
+{
+  return range.host < host + size && host < range.host + range.size;
+}
+
+static inline
+cudaError_t cuda_residency_download(cuda_resident& range)
+{
+  if (range.host_valid)
+    return cudaSuccess;
+  range.host_valid = true;
+  return cudaMemcpy ((void*) range.host, range.device, range.size, cudaMemcpyDeviceToHost);
+}
+
+/* Downloads and drops the ranges overlapping the host range, except the
+   kept one. */
+static inline
+cudaError_t cuda_residency_evict(const char* array, const char* host, size_t size,
+				 const char* keep)
+{
+  std::vector<cuda_resident>& ranges = cuda_residency_current.ranges;
+  for (size_t i = 0; i < ranges.size();)
+    {
+      if (ranges[i].array != array || ranges[i].device == keep
+	  || !cuda_residency_overlap (ranges[i], host, size))
+	{
+	  ++i;
+	  continue;
+	}
+      cudaError_t error = cuda_residency_download (ranges[i]);
+      if (error != cudaSuccess)
+	return error;
+      cudaFree (ranges[i].device);
+      ranges.erase (ranges.begin () + i);
+    }
+  return cudaSuccess;
+}
+
+static inline
+cudaError_t polybench_cuda_memcpy(void* dst, const void* src, size_t count, cudaMemcpyKind kind)
+{
+  std::vector<cuda_resident>& ranges = cuda_residency_current.ranges;
+  if (kind == cudaMemcpyHostToDevice)
+    {
+      const char* host = (const char*) src;
+      const char* array = cuda_residency_array (host);
+      if (array == NULL)
+	return cudaMemcpy (dst, src, count, kind);
+      for (cuda_resident& range : ranges)
+	if (range.array == array && range.host <= host && host + count <= range.host + range.size)
+	  return cudaMemcpy (dst, range.device + (host - range.host), count,
+			     cudaMemcpyDeviceToDevice);
+      /* Parts of the range may only be valid on the device. */
+      for (cuda_resident& range : ranges)
+	if (range.array == array && cuda_residency_overlap (range, host, count))
+	  {
+	    cudaError_t error = cuda_residency_download (range);
+	    if (error != cudaSuccess)
+	      return error;
+	  }
+      cudaError_t error = cudaMemcpy (dst, src, count, kind);
+      if (error != cudaSuccess)
+	return error;
+      ranges.push_back ({host, count, (char*) dst, true, array});
+      return cudaSuccess;
+    }
+  if (kind == cudaMemcpyDeviceToHost)
+    {
+      const char* host = (const char*) dst;
+      const char* device = (const char*) src;
+      const char* array = cuda_residency_array (host);
+      if (array == NULL)
+	return cudaMemcpy (dst, src, count, kind);
+      cuda_resident* target = NULL;
+      for (cuda_resident& range : ranges)
+	if (range.array == array && range.host <= host && host + count <= range.host + range.size
+	    && (target == NULL || range.device == device))
+	  target = &range;
+      const char* keep = target != NULL ? target->device : NULL;
+      cudaError_t error = cuda_residency_evict (array, host, count, keep);
+      if (error != cudaSuccess)
+	return error;
+      for (cuda_resident& range : ranges)
+	if (range.device == keep && keep != NULL)
+	  target = &range;
+      if (target == NULL)
+	{
+	  /* The buffer of the call becomes the device copy of the range. */
+	  ranges.push_back ({host, count, (char*) device, false, array});
+	  return cudaSuccess;
+	}
+      if (target->device == device)
+	;
+      else if (target->host == host && target->size == count)
+	{
+	  cudaFree (target->device);
+	  target->device = (char*) device;
+	}
+      else
+	{
+	  error = cudaMemcpy (target->device + (host - target->host), device, count,
+			      cudaMemcpyDeviceToDevice);
+	  if (error != cudaSuccess)
+	    return error;
+	}
+      target->host_valid = false;
+      return cudaSuccess;
+    }
+  return cudaMemcpy (dst, src, count, kind);
+}
+
+static inline
+cudaError_t polybench_cuda_memcpy_async(void* dst, const void* src, size_t count,
+					cudaMemcpyKind kind, cudaStream_t stream)
+{
+  cudaError_t error = cudaStreamSynchronize (stream);
+  if (error != cudaSuccess)
+    return error;
+  return polybench_cuda_memcpy (dst, src, count, kind);
+}
+
+/* The device copies of the ranges are freed with the residency. */
+static inline
+cudaError_t polybench_cuda_free(void* ptr)
+{
+  for (cuda_resident& range : cuda_residency_current.ranges)
+    if (range.device == ptr)
+      return cudaSuccess;
+  return cudaFree (ptr);
+}
+
+static inline
+void polybench_cuda_register(const void* array, size_t size)
+{
+  const char* value = getenv ("POLYBENCH_CUDA_RESIDENCY");
+  if (value != NULL && *value != '\0' && atoi (value) == 0)
+    return;
+  for (const cuda_array& registered : cuda_residency_current.arrays)
+    if (registered.base == (const char*) array)
+      return;
+  cuda_residency_current.arrays.push_back ({(const char*) array, size});
+}
+
+/* Before host code reads or writes the array. */
+static inline
+void polybench_cuda_download(const void* array)
+{
+  const char* base = cuda_residency_array (array);
+  for (cuda_resident& range : cuda_residency_current.ranges)
+    if (range.array == base)
+      CUDA_CHECK (cuda_residency_download (range));
+}
+
+/* After host code wrote the array. */
+static inline
+void polybench_cuda_host_write(const void* array)
+{
+  std::vector<cuda_resident>& ranges = cuda_residency_current.ranges;
+  const char* base = cuda_residency_array (array);
+  for (size_t i = 0; i < ranges.size();)
+    {
+      if (ranges[i].array != base)
+	{
+	  ++i;
+	  continue;
+	}
+      CUDA_CHECK (cuda_residency_download (ranges[i]));
+      CUDA_CHECK (cudaFree (ranges[i].device));
+      ranges.erase (ranges.begin () + i);
+    }
+}
+
+/* Drops all device copies, the live-outs must be downloaded before. */
+static inline
+void polybench_cuda_release()
+{
+  for (cuda_resident& range : cuda_residency_current.ranges)
+    CUDA_CHECK (cudaFree (range.device));
+  cuda_residency_current.ranges.clear ();
+  cuda_residency_current.arrays.clear ();
+}
+
+# define cudaMemcpy polybench_cuda_memcpy
+# define cudaMemcpyAsync polybench_cuda_memcpy_async
+# define cudaFree polybench_cuda_free
+
+#endif /* !CUDA_RESIDENCY_CUH */
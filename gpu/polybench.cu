@@ -44,6 +44,7 @@
 
 int polybench_papi_counters_threadid = POLYBENCH_THREAD_MONITOR;
 double polybench_program_total_flops = 0;
+double polybench_program_total_bytes = 0;
 
 #ifdef POLYBENCH_PAPI
 # include <papi.h>
@@ -385,8 +386,26 @@ void polybench_timer_stop()
 }
 
 
+static
+void print_roofline(double time)
+{
+  /* Stderr keeps stdout to the single number parsed by the scripts. */
+  if (polybench_program_total_flops == 0 || time <= 0)
+    return;
+  fprintf (stderr, "gflops %0.3f\n", polybench_program_total_flops / time / 1.0e9);
+  if (polybench_program_total_bytes == 0)
+    return;
+  fprintf (stderr, "gbs %0.3f\n", polybench_program_total_bytes / time / 1.0e9);
+  fprintf (stderr, "intensity %0.3f\n",
+	   polybench_program_total_flops / polybench_program_total_bytes);
+}
+
+
 void polybench_timer_print()
 {
+#ifndef POLYBENCH_CYCLE_ACCURATE_TIMER
+  print_roofline (polybench_t_end - polybench_t_start);
+#endif
 #ifdef POLYBENCH_GFLOPS
       if  (polybench_program_total_flops == 0)
 	{
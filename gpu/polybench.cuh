@@ -166,6 +166,10 @@
 #define POLYBENCH_DUMP_FINISH   fprintf(POLYBENCH_DUMP_TARGET, "==END   DUMP_ARRAYS==\n")
 #define POLYBENCH_DUMP_BEGIN(s) fprintf(POLYBENCH_DUMP_TARGET, "begin dump: %s", s)
 #define POLYBENCH_DUMP_END(s)   fprintf(POLYBENCH_DUMP_TARGET, "\nend   dump: %s\n", s)
+/* Text dumps only, binary dumps are provided by the CPU runtime. */
+#define POLYBENCH_DUMP_SHAPE(...) ((void) 0)
+#define POLYBENCH_DUMP_VALUE(x) fprintf(POLYBENCH_DUMP_TARGET, DATA_PRINTF_MODIFIER, x)
+#define POLYBENCH_DUMP_NEWLINE  fprintf(POLYBENCH_DUMP_TARGET, "\n")
 
 # define polybench_prevent_dce(func)		\
   POLYBENCH_DCE_ONLY_CODE			\
@@ -204,6 +208,13 @@ extern const unsigned int polybench_papi_eventlist[];
 # endif
 
 
+/* Work of the SCoP. With timing enabled, the achieved GFLOP/s, GB/s
+   and the arithmetic intensity are reported on stderr. */
+extern double polybench_program_total_flops;
+extern double polybench_program_total_bytes;
+# define polybench_set_program_flops(value) polybench_program_total_flops = (value)
+# define polybench_set_program_bytes(value) polybench_program_total_bytes = (value)
+
 /* Timing support. */
 # if defined(POLYBENCH_TIME) || defined(POLYBENCH_GFLOPS)
 #  undef polybench_start_instruments
@@ -212,7 +223,6 @@ extern const unsigned int polybench_papi_eventlist[];
 #  define polybench_start_instruments polybench_timer_start();
 #  define polybench_stop_instruments polybench_timer_stop();
 #  define polybench_print_instruments polybench_timer_print();
-extern double polybench_program_total_flops;
 extern void polybench_timer_start();
 extern void polybench_timer_stop();
 extern void polybench_timer_print();
@@ -0,0 +1,106 @@
+/*
+ * cublas_v2.h: host stub of cuBLAS for machines without a GPU.
+ *
+ * Column-major reference routines on the device memory of the runtime
+ * stub. Every matrix and vector operand must lie in a device allocation,
+ * scalars are read through host pointers.
+ */
+#ifndef CUBLAS_STUB_V2_H
+# define CUBLAS_STUB_V2_H
+
+# include "cuda_runtime.h"
+
+typedef enum
+{
+  CUBLAS_STATUS_SUCCESS = 0,
+  CUBLAS_STATUS_NOT_INITIALIZED = 1,
+  CUBLAS_STATUS_INVALID_VALUE = 7
+} cublasStatus_t;
+
+typedef enum
+{
+  CUBLAS_OP_N = 0,
+  CUBLAS_OP_T = 1,
+  CUBLAS_OP_C = 2
+} cublasOperation_t;
+
+typedef enum
+{
+  CUBLAS_FILL_MODE_LOWER = 0,
+  CUBLAS_FILL_MODE_UPPER = 1
+} cublasFillMode_t;
+
+typedef enum
+{
+  CUBLAS_DIAG_NON_UNIT = 0,
+  CUBLAS_DIAG_UNIT = 1
+} cublasDiagType_t;
+
+typedef enum
+{
+  CUBLAS_SIDE_LEFT = 0,
+  CUBLAS_SIDE_RIGHT = 1
+} cublasSideMode_t;
+
+typedef enum
+{
+  CUBLAS_POINTER_MODE_HOST = 0,
+  CUBLAS_POINTER_MODE_DEVICE = 1
+} cublasPointerMode_t;
+
+typedef struct cublasContext* cublasHandle_t;
+
+cublasStatus_t cublasCreate(cublasHandle_t* handle);
+cublasStatus_t cublasDestroy(cublasHandle_t handle);
+cublasStatus_t cublasSetStream(cublasHandle_t handle, cudaStream_t stream);
+cublasStatus_t cublasSetPointerMode(cublasHandle_t handle, cublasPointerMode_t mode);
+const char* cublasGetStatusString(cublasStatus_t status);
+
+cublasStatus_t cublasDdot(cublasHandle_t handle, int n, const double* x, int incx,
+			  const double* y, int incy, double* result);
+cublasStatus_t cublasDaxpy(cublasHandle_t handle, int n, const double* alpha, const double* x,
+			   int incx, double* y, int incy);
+cublasStatus_t cublasDscal(cublasHandle_t handle, int n, const double* alpha, double* x,
+			   int incx);
+cublasStatus_t cublasDcopy(cublasHandle_t handle, int n, const double* x, int incx, double* y,
+			   int incy);
+
+cublasStatus_t cublasDgemv(cublasHandle_t handle, cublasOperation_t trans, int m, int n,
+			   const double* alpha, const double* a, int lda, const double* x,
+			   int incx, const double* beta, double* y, int incy);
+cublasStatus_t cublasDsymv(cublasHandle_t handle, cublasFillMode_t uplo, int n,
+			   const double* alpha, const double* a, int lda, const double* x,
+			   int incx, const double* beta, double* y, int incy);
+cublasStatus_t cublasDger(cublasHandle_t handle, int m, int n, const double* alpha,
+			  const double* x, int incx, const double* y, int incy, double* a,
+			  int lda);
+cublasStatus_t cublasDtrmv(cublasHandle_t handle, cublasFillMode_t uplo,
+			   cublasOperation_t trans, cublasDiagType_t diag, int n,
+			   const double* a, int lda, double* x, int incx);
+cublasStatus_t cublasDtrsv(cublasHandle_t handle, cublasFillMode_t uplo,
+			   cublasOperation_t trans, cublasDiagType_t diag, int n,
+			   const double* a, int lda, double* x, int incx);
+
+cublasStatus_t cublasDgemm(cublasHandle_t handle, cublasOperation_t trans_a,
+			   cublasOperation_t trans_b, int m, int n, int k, const double* alpha,
+			   const double* a, int lda, const double* b, int ldb,
+			   const double* beta, double* c, int ldc);
+cublasStatus_t cublasDsymm(cublasHandle_t handle, cublasSideMode_t side, cublasFillMode_t uplo,
+			   int m, int n, const double* alpha, const double* a, int lda,
+			   const double* b, int ldb, const double* beta, double* c, int ldc);
+cublasStatus_t cublasDsyrk(cublasHandle_t handle, cublasFillMode_t uplo,
+			   cublasOperation_t trans, int n, int k, const double* alpha,
+			   const double* a, int lda, const double* beta, double* c, int ldc);
+cublasStatus_t cublasDsyr2k(cublasHandle_t handle, cublasFillMode_t uplo,
+			    cublasOperation_t trans, int n, int k, const double* alpha,
+			    const double* a, int lda, const double* b, int ldb,
+			    const double* beta, double* c, int ldc);
+cublasStatus_t cublasDtrmm(cublasHandle_t handle, cublasSideMode_t side, cublasFillMode_t uplo,
+			   cublasOperation_t trans, cublasDiagType_t diag, int m, int n,
+			   const double* alpha, const double* a, int lda, const double* b,
+			   int ldb, double* c, int ldc);
+cublasStatus_t cublasDtrsm(cublasHandle_t handle, cublasSideMode_t side, cublasFillMode_t uplo,
+			   cublasOperation_t trans, cublasDiagType_t diag, int m, int n,
+			   const double* alpha, const double* a, int lda, double* b, int ldb);
+
+#endif /* !CUBLAS_STUB_V2_H */
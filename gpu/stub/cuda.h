@@ -0,0 +1,9 @@
+/*
+ * cuda.h: host stub, the generated code only uses the runtime API.
+ */
+#ifndef CUDA_STUB_H
+# define CUDA_STUB_H
+
+# include "cuda_runtime.h"
+
+#endif /* !CUDA_STUB_H */
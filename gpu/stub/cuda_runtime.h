@@ -0,0 +1,57 @@
+/*
+ * cuda_runtime.h: host stub of the CUDA runtime for machines without a
+ * GPU.
+ *
+ * Device memory is host memory from a registry of allocations. Copies
+ * check that their pointers lie on the side the kind names and count the
+ * bytes per kind, POLYBENCH_CUDA_TRANSFERS=1 prints the counts at exit.
+ * Only the entry points of the generated CUBLAS code are provided.
+ */
+#ifndef CUDA_STUB_RUNTIME_H
+# define CUDA_STUB_RUNTIME_H
+
+# include <cstddef>
+
+typedef enum cudaError
+{
+  cudaSuccess = 0,
+  cudaErrorInvalidValue = 1,
+  cudaErrorMemoryAllocation = 2
+} cudaError_t;
+
+enum cudaMemcpyKind
+{
+  cudaMemcpyHostToHost = 0,
+  cudaMemcpyHostToDevice = 1,
+  cudaMemcpyDeviceToHost = 2,
+  cudaMemcpyDeviceToDevice = 3,
+  cudaMemcpyDefault = 4
+};
+
+typedef struct CUstream_st* cudaStream_t;
+
+cudaError_t cudaMalloc(void** ptr, size_t size);
+cudaError_t cudaFree(void* ptr);
+cudaError_t cudaMemcpy(void* dst, const void* src, size_t count, cudaMemcpyKind kind);
+cudaError_t cudaMemcpyAsync(void* dst, const void* src, size_t count, cudaMemcpyKind kind,
+			    cudaStream_t stream = 0);
+cudaError_t cudaMemset(void* ptr, int value, size_t count);
+cudaError_t cudaDeviceSynchronize();
+cudaError_t cudaStreamCreate(cudaStream_t* stream);
+cudaError_t cudaStreamDestroy(cudaStream_t stream);
+cudaError_t cudaStreamSynchronize(cudaStream_t stream);
+cudaError_t cudaGetLastError();
+const char* cudaGetErrorString(cudaError_t error);
+
+template <class T>
+cudaError_t cudaMalloc(T** ptr, size_t size)
+{
+  return cudaMalloc ((void**) ptr, size);
+}
+
+/* Stub only: whether the range lies in one device allocation, and the
+   bytes copied so far with the given kind. */
+bool cuda_stub_device(const void* ptr, size_t size);
+size_t cuda_stub_transferred(cudaMemcpyKind kind);
+
+#endif /* !CUDA_STUB_RUNTIME_H */
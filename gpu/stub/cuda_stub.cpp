@@ -0,0 +1,602 @@
+/*
+ * cuda_stub.cpp: host stub of the CUDA runtime and cuBLAS, see
+ * cuda_runtime.h and cublas_v2.h.
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include "cuda_runtime.h"
+#include "cublas_v2.h"
+
+struct CUstream_st
+{
+  int unused;
+};
+
+struct cublasContext
+{
+  cublasPointerMode_t pointer_mode;
+};
+
+namespace {
+
+struct stub_state
+{
+  std::map<const char*, size_t> allocations;
+  size_t transferred[5] = {0, 0, 0, 0, 0};
+
+  ~stub_state ()
+  {
+    const char* report = getenv ("POLYBENCH_CUDA_TRANSFERS");
+    if (report == NULL || atoi (report) == 0)
+      return;
+    fprintf (stderr, "[CUDA stub] host to device: %zu bytes\n",
+	     transferred[cudaMemcpyHostToDevice]);
+    fprintf (stderr, "[CUDA stub] device to host: %zu bytes\n",
+	     transferred[cudaMemcpyDeviceToHost]);
+    fprintf (stderr, "[CUDA stub] device to device: %zu bytes\n",
+	     transferred[cudaMemcpyDeviceToDevice]);
+  }
+};
+
+stub_state&
+state ()
+{
+  static stub_state current;
+  return current;
+}
+
+/* Extent of a column-major matrix and of a strided vector in bytes. */
+size_t
+matrix_bytes (int rows, int cols, int ld)
+{
+  if (rows <= 0 || cols <= 0)
+    return 0;
+  return ((size_t) (cols - 1) * ld + rows) * sizeof (double);
+}
+
+size_t
+vector_bytes (int n, int inc)
+{
+  if (n <= 0)
+    return 0;
+  return ((size_t) (n - 1) * (inc < 0 ? -inc : inc) + 1) * sizeof (double);
+}
+
+bool
+on_device (const double* ptr, size_t bytes)
+{
+  return bytes == 0 || cuda_stub_device (ptr, bytes);
+}
+
+/* Negative increments walk the vector backwards. */
+size_t
+at (int i, int n, int inc)
+{
+  return inc >= 0 ? (size_t) i * inc : (size_t) (n - 1 - i) * -inc;
+}
+
+double
+element (const double* a, int lda, bool trans, int i, int j)
+{
+  return trans ? a[j + (size_t) i * lda] : a[i + (size_t) j * lda];
+}
+
+double
+symmetric (const double* a, int lda, cublasFillMode_t uplo, int i, int j)
+{
+  bool stored = uplo == CUBLAS_FILL_MODE_LOWER ? i >= j : i <= j;
+  return stored ? a[i + (size_t) j * lda] : a[j + (size_t) i * lda];
+}
+
+double
+triangular (const double* a, int lda, cublasFillMode_t uplo, cublasDiagType_t diag, int i, int j)
+{
+  if (i == j && diag == CUBLAS_DIAG_UNIT)
+    return 1.0;
+  bool stored = uplo == CUBLAS_FILL_MODE_LOWER ? i >= j : i <= j;
+  return stored ? a[i + (size_t) j * lda] : 0.0;
+}
+
+/* Dense op(T) of a triangular matrix, and whether it is lower
+   triangular. */
+bool
+dense_triangular (const double* a, int lda, cublasFillMode_t uplo, cublasOperation_t trans,
+		  cublasDiagType_t diag, int n, std::vector<double>& t)
+{
+  t.assign ((size_t) n * n, 0.0);
+  for (int j = 0; j < n; j++)
+    for (int i = 0; i < n; i++)
+      t[i + (size_t) j * n] = trans == CUBLAS_OP_N ? triangular (a, lda, uplo, diag, i, j)
+					       : triangular (a, lda, uplo, diag, j, i);
+  return (uplo == CUBLAS_FILL_MODE_LOWER) == (trans == CUBLAS_OP_N);
+}
+
+/* Solves t x = b in place by substitution. */
+void
+substitute (const std::vector<double>& t, int n, bool lower, double* x)
+{
+  if (lower)
+    for (int i = 0; i < n; i++)
+      {
+	double sum = x[i];
+	for (int j = 0; j < i; j++)
+	  sum -= t[i + (size_t) j * n] * x[j];
+	x[i] = sum / t[i + (size_t) i * n];
+      }
+  else
+    for (int i = n - 1; i >= 0; i--)
+      {
+	double sum = x[i];
+	for (int j = i + 1; j < n; j++)
+	  sum -= t[i + (size_t) j * n] * x[j];
+	x[i] = sum / t[i + (size_t) i * n];
+      }
+}
+
+double
+scaled (double beta, double c)
+{
+  /* beta = 0 ignores the previous contents, like BLAS. */
+  return beta == 0.0 ? 0.0 : beta * c;
+}
+
+}  // namespace
+
+bool
+cuda_stub_device (const void* ptr, size_t size)
+{
+  const char* address = (const char*) ptr;
+  auto& allocations = state ().allocations;
+  auto allocation = allocations.upper_bound (address);
+  if (allocation == allocations.begin ())
+    return false;
+  --allocation;
+  return address + size <= allocation->first + allocation->second;
+}
+
+size_t
+cuda_stub_transferred (cudaMemcpyKind kind)
+{
+  return state ().transferred[kind];
+}
+
+cudaError_t
+cudaMalloc (void** ptr, size_t size)
+{
+  char* allocation = (char*) malloc (size > 0 ? size : 1);
+  if (allocation == NULL)
+    return cudaErrorMemoryAllocation;
+  state ().allocations[allocation] = size;
+  *ptr = allocation;
+  return cudaSuccess;
+}
+
+cudaError_t
+cudaFree (void* ptr)
+{
+  if (ptr == NULL)
+    return cudaSuccess;
+  if (state ().allocations.erase ((const char*) ptr) == 0)
+    return cudaErrorInvalidValue;
+  free (ptr);
+  return cudaSuccess;
+}
+
+cudaError_t
+cudaMemcpy (void* dst, const void* src, size_t count, cudaMemcpyKind kind)
+{
+  bool dst_device = cuda_stub_device (dst, count);
+  bool src_device = cuda_stub_device (src, count);
+  if (kind == cudaMemcpyDefault)
+    kind = (cudaMemcpyKind) ((src_device ? 2 : 0) + (dst_device ? 1 : 0));
+  bool expected_dst = kind == cudaMemcpyHostToDevice || kind == cudaMemcpyDeviceToDevice;
+  bool expected_src = kind == cudaMemcpyDeviceToHost || kind == cudaMemcpyDeviceToDevice;
+  if (count > 0 && (dst_device != expected_dst || src_device != expected_src))
+    return cudaErrorInvalidValue;
+  memmove (dst, src, count);
+  state ().transferred[kind] += count;
+  return cudaSuccess;
+}
+
+cudaError_t
+cudaMemcpyAsync (void* dst, const void* src, size_t count, cudaMemcpyKind kind,
+		 cudaStream_t stream)
+{
+  return cudaMemcpy (dst, src, count, kind);
+}
+
+cudaError_t
+cudaMemset (void* ptr, int value, size_t count)
+{
+  if (!cuda_stub_device (ptr, count))
+    return cudaErrorInvalidValue;
+  memset (ptr, value, count);
+  return cudaSuccess;
+}
+
+cudaError_t
+cudaDeviceSynchronize ()
+{
+  return cudaSuccess;
+}
+
+cudaError_t
+cudaStreamCreate (cudaStream_t* stream)
+{
+  *stream = new CUstream_st ();
+  return cudaSuccess;
+}
+
+cudaError_t
+cudaStreamDestroy (cudaStream_t stream)
+{
+  delete stream;
+  return cudaSuccess;
+}
+
+cudaError_t
+cudaStreamSynchronize (cudaStream_t stream)
+{
+  return cudaSuccess;
+}
+
+cudaError_t
+cudaGetLastError ()
+{
+  return cudaSuccess;
+}
+
+const char*
+cudaGetErrorString (cudaError_t error)
+{
+  switch (error)
+    {
+    case cudaSuccess:
+      return "no error";
+    case cudaErrorInvalidValue:
+      return "invalid argument";
+    case cudaErrorMemoryAllocation:
+      return "out of memory";
+    }
+  return "unknown error";
+}
+
+cublasStatus_t
+cublasCreate (cublasHandle_t* handle)
+{
+  *handle = new cublasContext ();
+  (*handle)->pointer_mode = CUBLAS_POINTER_MODE_HOST;
+  return CUBLAS_STATUS_SUCCESS;
+}
+
+cublasStatus_t
+cublasDestroy (cublasHandle_t handle)
+{
+  delete handle;
+  return CUBLAS_STATUS_SUCCESS;
+}
+
+cublasStatus_t
+cublasSetStream (cublasHandle_t handle, cudaStream_t stream)
+{
+  return handle != NULL ? CUBLAS_STATUS_SUCCESS : CUBLAS_STATUS_NOT_INITIALIZED;
+}
+
+cublasStatus_t
+cublasSetPointerMode (cublasHandle_t handle, cublasPointerMode_t mode)
+{
+  if (handle == NULL)
+    return CUBLAS_STATUS_NOT_INITIALIZED;
+  /* Scalars on the device are not supported. */
+  if (mode != CUBLAS_POINTER_MODE_HOST)
+    return CUBLAS_STATUS_INVALID_VALUE;
+  handle->pointer_mode = mode;
+  return CUBLAS_STATUS_SUCCESS;
+}
+
+const char*
+cublasGetStatusString (cublasStatus_t status)
+{
+  switch (status)
+    {
+    case CUBLAS_STATUS_SUCCESS:
+      return "CUBLAS_STATUS_SUCCESS";
+    case CUBLAS_STATUS_NOT_INITIALIZED:
+      return "CUBLAS_STATUS_NOT_INITIALIZED";
+    case CUBLAS_STATUS_INVALID_VALUE:
+      return "CUBLAS_STATUS_INVALID_VALUE";
+    }
+  return "CUBLAS_STATUS_UNKNOWN";
+}
+
+cublasStatus_t
+cublasDdot (cublasHandle_t handle, int n, const double* x, int incx, const double* y, int incy,
+	    double* result)
+{
+  if (!on_device (x, vector_bytes (n, incx)) || !on_device (y, vector_bytes (n, incy)))
+    return CUBLAS_STATUS_INVALID_VALUE;
+  double sum = 0.0;
+  for (int i = 0; i < n; i++)
+    sum += x[at (i, n, incx)] * y[at (i, n, incy)];
+  *result = sum;
+  return CUBLAS_STATUS_SUCCESS;
+}
+
+cublasStatus_t
+cublasDaxpy (cublasHandle_t handle, int n, const double* alpha, const double* x, int incx,
+	     double* y, int incy)
+{
+  if (!on_device (x, vector_bytes (n, incx)) || !on_device (y, vector_bytes (n, incy)))
+    return CUBLAS_STATUS_INVALID_VALUE;
+  for (int i = 0; i < n; i++)
+    y[at (i, n, incy)] += *alpha * x[at (i, n, incx)];
+  return CUBLAS_STATUS_SUCCESS;
+}
+
+cublasStatus_t
+cublasDscal (cublasHandle_t handle, int n, const double* alpha, double* x, int incx)
+{
+  if (!on_device (x, vector_bytes (n, incx)))
+    return CUBLAS_STATUS_INVALID_VALUE;
+  for (int i = 0; i < n; i++)
+    x[at (i, n, incx)] *= *alpha;
+  return CUBLAS_STATUS_SUCCESS;
+}
+
+cublasStatus_t
+cublasDcopy (cublasHandle_t handle, int n, const double* x, int incx, double* y, int incy)
+{
+  if (!on_device (x, vector_bytes (n, incx)) || !on_device (y, vector_bytes (n, incy)))
+    return CUBLAS_STATUS_INVALID_VALUE;
+  for (int i = 0; i < n; i++)
+    y[at (i, n, incy)] = x[at (i, n, incx)];
+  return CUBLAS_STATUS_SUCCESS;
+}
+
+cublasStatus_t
+cublasDgemv (cublasHandle_t handle, cublasOperation_t trans, int m, int n, const double* alpha,
+	     const double* a, int lda, const double* x, int incx, const double* beta, double* y,
+	     int incy)
+{
+  bool t = trans != CUBLAS_OP_N;
+  int rows = t ? n : m, cols = t ? m : n;
+  if (!on_device (a, matrix_bytes (m, n, lda)) || !on_device (x, vector_bytes (cols, incx))
+      || !on_device (y, vector_bytes (rows, incy)))
+    return CUBLAS_STATUS_INVALID_VALUE;
+  for (int i = 0; i < rows; i++)
+    {
+      double sum = 0.0;
+      for (int j = 0; j < cols; j++)
+	sum += element (a, lda, t, i, j) * x[at (j, cols, incx)];
+      double& yi = y[at (i, rows, incy)];
+      yi = *alpha * sum + scaled (*beta, yi);
+    }
+  return CUBLAS_STATUS_SUCCESS;
+}
+
+cublasStatus_t
+cublasDsymv (cublasHandle_t handle, cublasFillMode_t uplo, int n, const double* alpha,
+	     const double* a, int lda, const double* x, int incx, const double* beta, double* y,
+	     int incy)
+{
+  if (!on_device (a, matrix_bytes (n, n, lda)) || !on_device (x, vector_bytes (n, incx))
+      || !on_device (y, vector_bytes (n, incy)))
+    return CUBLAS_STATUS_INVALID_VALUE;
+  for (int i = 0; i < n; i++)
+    {
+      double sum = 0.0;
+      for (int j = 0; j < n; j++)
+	sum += symmetric (a, lda, uplo, i, j) * x[at (j, n, incx)];
+      double& yi = y[at (i, n, incy)];
+      yi = *alpha * sum + scaled (*beta, yi);
+    }
+  return CUBLAS_STATUS_SUCCESS;
+}
+
+cublasStatus_t
+cublasDger (cublasHandle_t handle, int m, int n, const double* alpha, const double* x, int incx,
+	    const double* y, int incy, double* a, int lda)
+{
+  if (!on_device (a, matrix_bytes (m, n, lda)) || !on_device (x, vector_bytes (m, incx))
+      || !on_device (y, vector_bytes (n, incy)))
+    return CUBLAS_STATUS_INVALID_VALUE;
+  for (int j = 0; j < n; j++)
+    for (int i = 0; i < m; i++)
+      a[i + (size_t) j * lda] += *alpha * x[at (i, m, incx)] * y[at (j, n, incy)];
+  return CUBLAS_STATUS_SUCCESS;
+}
+
+cublasStatus_t
+cublasDtrmv (cublasHandle_t handle, cublasFillMode_t uplo, cublasOperation_t trans,
+	     cublasDiagType_t diag, int n, const double* a, int lda, double* x, int incx)
+{
+  if (!on_device (a, matrix_bytes (n, n, lda)) || !on_device (x, vector_bytes (n, incx)))
+    return CUBLAS_STATUS_INVALID_VALUE;
+  std::vector<double> t, result (n, 0.0);
+  dense_triangular (a, lda, uplo, trans, diag, n, t);
+  for (int i = 0; i < n; i++)
+    for (int j = 0; j < n; j++)
+      result[i] += t[i + (size_t) j * n] * x[at (j, n, incx)];
+  for (int i = 0; i < n; i++)
+    x[at (i, n, incx)] = result[i];
+  return CUBLAS_STATUS_SUCCESS;
+}
+
+cublasStatus_t
+cublasDtrsv (cublasHandle_t handle, cublasFillMode_t uplo, cublasOperation_t trans,
+	     cublasDiagType_t diag, int n, const double* a, int lda, double* x, int incx)
+{
+  if (!on_device (a, matrix_bytes (n, n, lda)) || !on_device (x, vector_bytes (n, incx)))
+    return CUBLAS_STATUS_INVALID_VALUE;
+  std::vector<double> t, b (n);
+  bool lower = dense_triangular (a, lda, uplo, trans, diag, n, t);
+  for (int i = 0; i < n; i++)
+    b[i] = x[at (i, n, incx)];
+  substitute (t, n, lower, b.data ());
+  for (int i = 0; i < n; i++)
+    x[at (i, n, incx)] = b[i];
+  return CUBLAS_STATUS_SUCCESS;
+}
+
+cublasStatus_t
+cublasDgemm (cublasHandle_t handle, cublasOperation_t trans_a, cublasOperation_t trans_b, int m,
+	     int n, int k, const double* alpha, const double* a, int lda, const double* b, int ldb,
+	     const double* beta, double* c, int ldc)
+{
+  bool ta = trans_a != CUBLAS_OP_N, tb = trans_b != CUBLAS_OP_N;
+  if (!on_device (a, ta ? matrix_bytes (k, m, lda) : matrix_bytes (m, k, lda))
+      || !on_device (b, tb ? matrix_bytes (n, k, ldb) : matrix_bytes (k, n, ldb))
+      || !on_device (c, matrix_bytes (m, n, ldc)))
+    return CUBLAS_STATUS_INVALID_VALUE;
+  for (int j = 0; j < n; j++)
+    for (int i = 0; i < m; i++)
+      {
+	double sum = 0.0;
+	for (int l = 0; l < k; l++)
+	  sum += element (a, lda, ta, i, l) * element (b, ldb, tb, l, j);
+	double& cij = c[i + (size_t) j * ldc];
+	cij = *alpha * sum + scaled (*beta, cij);
+      }
+  return CUBLAS_STATUS_SUCCESS;
+}
+
+cublasStatus_t
+cublasDsymm (cublasHandle_t handle, cublasSideMode_t side, cublasFillMode_t uplo, int m, int n,
+	     const double* alpha, const double* a, int lda, const double* b, int ldb,
+	     const double* beta, double* c, int ldc)
+{
+  bool left = side == CUBLAS_SIDE_LEFT;
+  int order = left ? m : n;
+  if (!on_device (a, matrix_bytes (order, order, lda)) || !on_device (b, matrix_bytes (m, n, ldb))
+      || !on_device (c, matrix_bytes (m, n, ldc)))
+    return CUBLAS_STATUS_INVALID_VALUE;
+  for (int j = 0; j < n; j++)
+    for (int i = 0; i < m; i++)
+      {
+	double sum = 0.0;
+	for (int l = 0; l < order; l++)
+	  sum += left ? symmetric (a, lda, uplo, i, l) * b[l + (size_t) j * ldb]
+		      : b[i + (size_t) l * ldb] * symmetric (a, lda, uplo, l, j);
+	double& cij = c[i + (size_t) j * ldc];
+	cij = *alpha * sum + scaled (*beta, cij);
+      }
+  return CUBLAS_STATUS_SUCCESS;
+}
+
+cublasStatus_t
+cublasDsyrk (cublasHandle_t handle, cublasFillMode_t uplo, cublasOperation_t trans, int n, int k,
+	     const double* alpha, const double* a, int lda, const double* beta, double* c, int ldc)
+{
+  bool t = trans != CUBLAS_OP_N;
+  if (!on_device (a, t ? matrix_bytes (k, n, lda) : matrix_bytes (n, k, lda))
+      || !on_device (c, matrix_bytes (n, n, ldc)))
+    return CUBLAS_STATUS_INVALID_VALUE;
+  for (int j = 0; j < n; j++)
+    for (int i = 0; i < n; i++)
+      {
+	if (uplo == CUBLAS_FILL_MODE_LOWER ? i < j : i > j)
+	  continue;
+	double sum = 0.0;
+	for (int l = 0; l < k; l++)
+	  sum += element (a, lda, t, i, l) * element (a, lda, t, j, l);
+	double& cij = c[i + (size_t) j * ldc];
+	cij = *alpha * sum + scaled (*beta, cij);
+      }
+  return CUBLAS_STATUS_SUCCESS;
+}
+
+cublasStatus_t
+cublasDsyr2k (cublasHandle_t handle, cublasFillMode_t uplo, cublasOperation_t trans, int n,
+	      int k, const double* alpha, const double* a, int lda, const double* b, int ldb,
+	      const double* beta, double* c, int ldc)
+{
+  bool t = trans != CUBLAS_OP_N;
+  if (!on_device (a, t ? matrix_bytes (k, n, lda) : matrix_bytes (n, k, lda))
+      || !on_device (b, t ? matrix_bytes (k, n, ldb) : matrix_bytes (n, k, ldb))
+      || !on_device (c, matrix_bytes (n, n, ldc)))
+    return CUBLAS_STATUS_INVALID_VALUE;
+  for (int j = 0; j < n; j++)
+    for (int i = 0; i < n; i++)
+      {
+	if (uplo == CUBLAS_FILL_MODE_LOWER ? i < j : i > j)
+	  continue;
+	double sum = 0.0;
+	for (int l = 0; l < k; l++)
+	  sum += element (a, lda, t, i, l) * element (b, ldb, t, j, l)
+		 + element (b, ldb, t, i, l) * element (a, lda, t, j, l);
+	double& cij = c[i + (size_t) j * ldc];
+	cij = *alpha * sum + scaled (*beta, cij);
+      }
+  return CUBLAS_STATUS_SUCCESS;
+}
+
+cublasStatus_t
+cublasDtrmm (cublasHandle_t handle, cublasSideMode_t side, cublasFillMode_t uplo,
+	     cublasOperation_t trans, cublasDiagType_t diag, int m, int n, const double* alpha,
+	     const double* a, int lda, const double* b, int ldb, double* c, int ldc)
+{
+  bool left = side == CUBLAS_SIDE_LEFT;
+  int order = left ? m : n;
+  if (!on_device (a, matrix_bytes (order, order, lda)) || !on_device (b, matrix_bytes (m, n, ldb))
+      || !on_device (c, matrix_bytes (m, n, ldc)))
+    return CUBLAS_STATUS_INVALID_VALUE;
+  /* C may be B. */
+  std::vector<double> t, result ((size_t) m * n, 0.0);
+  dense_triangular (a, lda, uplo, trans, diag, order, t);
+  for (int j = 0; j < n; j++)
+    for (int i = 0; i < m; i++)
+      {
+	double sum = 0.0;
+	for (int l = 0; l < order; l++)
+	  sum += left ? t[i + (size_t) l * order] * b[l + (size_t) j * ldb]
+		      : b[i + (size_t) l * ldb] * t[l + (size_t) j * order];
+	result[i + (size_t) j * m] = *alpha * sum;
+      }
+  for (int j = 0; j < n; j++)
+    for (int i = 0; i < m; i++)
+      c[i + (size_t) j * ldc] = result[i + (size_t) j * m];
+  return CUBLAS_STATUS_SUCCESS;
+}
+
+cublasStatus_t
+cublasDtrsm (cublasHandle_t handle, cublasSideMode_t side, cublasFillMode_t uplo,
+	     cublasOperation_t trans, cublasDiagType_t diag, int m, int n, const double* alpha,
+	     const double* a, int lda, double* b, int ldb)
+{
+  bool left = side == CUBLAS_SIDE_LEFT;
+  int order = left ? m : n;
+  if (!on_device (a, matrix_bytes (order, order, lda)) || !on_device (b, matrix_bytes (m, n, ldb)))
+    return CUBLAS_STATUS_INVALID_VALUE;
+  std::vector<double> t, x (order);
+  if (left)
+    {
+      bool lower = dense_triangular (a, lda, uplo, trans, diag, order, t);
+      for (int j = 0; j < n; j++)
+	{
+	  for (int i = 0; i < m; i++)
+	    x[i] = *alpha * b[i + (size_t) j * ldb];
+	  substitute (t, order, lower, x.data ());
+	  for (int i = 0; i < m; i++)
+	    b[i + (size_t) j * ldb] = x[i];
+	}
+    }
+  else
+    {
+      /* X op(T) = B is op(T)^T X^T = B^T row by row. */
+      cublasOperation_t transposed = trans == CUBLAS_OP_N ? CUBLAS_OP_T : CUBLAS_OP_N;
+      bool lower = dense_triangular (a, lda, uplo, transposed, diag, order, t);
+      for (int i = 0; i < m; i++)
+	{
+	  for (int j = 0; j < n; j++)
+	    x[j] = *alpha * b[i + (size_t) j * ldb];
+	  substitute (t, order, lower, x.data ());
+	  for (int j = 0; j < n; j++)
+	    b[i + (size_t) j * ldb] = x[j];
+	}
+    }
+  return CUBLAS_STATUS_SUCCESS;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "optimize.h"
+
+struct TunerOptions {
+    BLASImplementation impl = MKL;
+    // Benchmark names without the category
+    std::vector<std::string> benchmarks;
+    size_t reps = 5;
+    size_t omp_threads = 4;
+    size_t mkl_threads = 24;
+    std::string tuning_database = "tuning/db.json";
+};
+
+// Measures the alternatives of the EinsumPipeline per benchmark and stores the fastest correct
+// configuration in the tuning database, later runs of optimize pick it up
+int autotune(int argc, char* argv[]);
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "optimize.h"
+
+// Library behind the BLAS library nodes of the generated code
+struct BLASBackend {
+    // Suffix of optimize_<name>, optimized_<name> and the opt_<name> version
+    std::string name;
+    // Headers of the generated code, in order
+    std::vector<std::string> headers;
+    // Sets the thread count of the library for the thread budgets, empty if the library is
+    // sequential
+    std::string set_num_threads;
+};
+
+const std::vector<BLASImplementation> BLAS_IMPLEMENTATIONS = {MKL,  MKL3,  CUBLAS, OPENBLAS,
+                                                              BLIS, CBLAS, BUILTIN};
+
+const BLASBackend& blas_backend(BLASImplementation impl);
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <sdfg/codegen/dispatchers/node_dispatcher.h>
+#include <sdfg/codegen/dispatchers/node_dispatcher_registry.h>
+#include <sdfg/codegen/instrumentation/instrumentation.h>
+#include <sdfg/codegen/language_extension.h>
+#include <sdfg/codegen/utils.h>
+#include <sdfg/structured_control_flow/map.h>
+#include <sdfg/structured_sdfg.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sdfg {
+namespace codegen {
+
+inline structured_control_flow::ScheduleType ScheduleType_BLASBatch("BLAS_BATCH");
+
+// CBLAS calls of a batched map are recorded while the map runs and executed together after it,
+// see blas/blas_batch.h
+const std::vector<std::string> BATCHED_BLAS_CALLS = {"cblas_dgemm", "cblas_dgemv"};
+
+class BLASBatchMapDispatcher : public NodeDispatcher {
+    structured_control_flow::Map& node_;
+
+   public:
+    BLASBatchMapDispatcher(LanguageExtension& language_extension, StructuredSDFG& sdfg,
+                           structured_control_flow::Map& node, Instrumentation& instrumentation);
+
+    virtual void dispatch_node(PrettyPrinter& main_stream, PrettyPrinter& globals_stream,
+                               PrettyPrinter& library_stream) override;
+};
+
+inline void register_blas_batch_dispatcher() {
+    MapDispatcherRegistry::instance().register_map_dispatcher(
+        ScheduleType_BLASBatch.value(),
+        [](LanguageExtension& language_extension, StructuredSDFG& sdfg,
+           structured_control_flow::Map& node, Instrumentation& instrumentation) {
+            return std::make_unique<BLASBatchMapDispatcher>(language_extension, sdfg, node,
+                                                            instrumentation);
+        });
+}
+
+}  // namespace codegen
+}  // namespace sdfg
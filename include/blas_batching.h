@@ -0,0 +1,51 @@
+#pragma once
+
+#include <sdfg/analysis/analysis.h>
+#include <sdfg/builder/structured_sdfg_builder.h>
+#include <sdfg/data_flow/library_node.h>
+#include <sdfg/data_flow/memlet.h>
+#include <sdfg/structured_control_flow/block.h>
+#include <sdfg/symbolic/symbolic.h>
+
+#include <functional>
+#include <nlohmann/json_fwd.hpp>
+#include <string>
+#include <vector>
+
+#include "sdfg/structured_control_flow/structured_loop.h"
+#include "sdfg/transformations/transformation.h"
+
+namespace sdfg {
+namespace transformations {
+
+// Batches the BLAS calls of a perfect loop nest around a single BLAS library node. Every
+// iteration must write its own slice of the outputs, the calls then run together after the loop.
+class BLASBatching : public Transformation {
+    structured_control_flow::StructuredLoop& loop_;
+
+    std::vector<std::reference_wrapper<structured_control_flow::StructuredLoop>> loop_nest();
+
+    data_flow::LibraryNode* blas_node(structured_control_flow::Block& block);
+
+    bool selects_slice(const data_flow::Subset& begin_subset, const data_flow::Subset& end_subset,
+                       const symbolic::Symbol& indvar, const symbolic::SymbolSet& indvars);
+
+   public:
+    BLASBatching(structured_control_flow::StructuredLoop& loop);
+
+    virtual std::string name() const override;
+
+    virtual bool can_be_applied(builder::StructuredSDFGBuilder& builder,
+                                analysis::AnalysisManager& analysis_manager) override;
+
+    virtual void apply(builder::StructuredSDFGBuilder& builder,
+                       analysis::AnalysisManager& analysis_manager) override;
+
+    virtual void to_json(nlohmann::json& j) const override;
+
+    static BLASBatching from_json(builder::StructuredSDFGBuilder& builder,
+                                  const nlohmann::json& j);
+};
+
+}  // namespace transformations
+}  // namespace sdfg
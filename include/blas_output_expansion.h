@@ -0,0 +1,60 @@
+#pragma once
+
+#include <sdfg/analysis/analysis.h>
+#include <sdfg/builder/structured_sdfg_builder.h>
+#include <sdfg/data_flow/library_node.h>
+#include <sdfg/structured_control_flow/block.h>
+#include <sdfg/structured_control_flow/control_flow_node.h>
+#include <sdfg/structured_control_flow/sequence.h>
+#include <sdfg/symbolic/symbolic.h>
+
+#include <cstddef>
+#include <nlohmann/json_fwd.hpp>
+#include <string>
+
+#include "sdfg/structured_control_flow/structured_loop.h"
+#include "sdfg/transformations/transformation.h"
+
+namespace sdfg {
+namespace transformations {
+
+// Gives every iteration of a loop its own row of the output of a BLAS call, e.g. sum of
+// doitgen, and distributes the call into a loop of its own. The initializations of the output
+// move into a loop in front of it, the code reading the output stays in the loop and first copies
+// the row of its iteration back. The loop of the call can then be batched by BLASBatching.
+class BLASOutputExpansion : public Transformation {
+    structured_control_flow::StructuredLoop& loop_;
+
+    data_flow::LibraryNode* blas_node(structured_control_flow::Block& block);
+
+    size_t blas_index();
+
+    bool initializes(structured_control_flow::ControlFlowNode& node, const std::string& container,
+                     const symbolic::Expression& begin, const symbolic::Expression& end);
+
+    void expand(builder::StructuredSDFGBuilder& builder, structured_control_flow::Block& block,
+                const std::string& container, const std::string& expanded_container,
+                const symbolic::Expression& row);
+
+    void distribute(builder::StructuredSDFGBuilder& builder,
+                    structured_control_flow::Sequence& parent, size_t count);
+
+   public:
+    BLASOutputExpansion(structured_control_flow::StructuredLoop& loop);
+
+    virtual std::string name() const override;
+
+    virtual bool can_be_applied(builder::StructuredSDFGBuilder& builder,
+                                analysis::AnalysisManager& analysis_manager) override;
+
+    virtual void apply(builder::StructuredSDFGBuilder& builder,
+                       analysis::AnalysisManager& analysis_manager) override;
+
+    virtual void to_json(nlohmann::json& j) const override;
+
+    static BLASOutputExpansion from_json(builder::StructuredSDFGBuilder& builder,
+                                         const nlohmann::json& j);
+};
+
+}  // namespace transformations
+}  // namespace sdfg
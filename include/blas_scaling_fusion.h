@@ -0,0 +1,49 @@
+#pragma once
+
+#include <sdfg/analysis/analysis.h>
+#include <sdfg/builder/structured_sdfg_builder.h>
+#include <sdfg/data_flow/library_node.h>
+#include <sdfg/data_flow/tasklet.h>
+#include <sdfg/structured_control_flow/block.h>
+#include <sdfg/symbolic/symbolic.h>
+
+#include <functional>
+#include <nlohmann/json_fwd.hpp>
+#include <string>
+#include <vector>
+
+#include "sdfg/structured_control_flow/structured_loop.h"
+#include "sdfg/transformations/transformation.h"
+
+namespace sdfg {
+namespace transformations {
+
+// Folds a loop nest scaling the output of a BLAS call (C *= s) into the beta of that call
+class BLASScalingFusion : public Transformation {
+    structured_control_flow::StructuredLoop& loop_;
+    data_flow::LibraryNode& blas_node_;
+
+    std::vector<std::reference_wrapper<structured_control_flow::StructuredLoop>> loop_nest();
+
+    data_flow::Tasklet* scaling_tasklet(structured_control_flow::Block& block);
+
+   public:
+    BLASScalingFusion(structured_control_flow::StructuredLoop& loop,
+                      data_flow::LibraryNode& blas_node);
+
+    virtual std::string name() const override;
+
+    virtual bool can_be_applied(builder::StructuredSDFGBuilder& builder,
+                                analysis::AnalysisManager& analysis_manager) override;
+
+    virtual void apply(builder::StructuredSDFGBuilder& builder,
+                       analysis::AnalysisManager& analysis_manager) override;
+
+    virtual void to_json(nlohmann::json& j) const override;
+
+    static BLASScalingFusion from_json(builder::StructuredSDFGBuilder& builder,
+                                       const nlohmann::json& j);
+};
+
+}  // namespace transformations
+}  // namespace sdfg
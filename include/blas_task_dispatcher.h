@@ -0,0 +1,47 @@
+#pragma once
+
+#include <sdfg/codegen/dispatchers/node_dispatcher.h>
+#include <sdfg/codegen/dispatchers/node_dispatcher_registry.h>
+#include <sdfg/codegen/instrumentation/instrumentation.h>
+#include <sdfg/codegen/language_extension.h>
+#include <sdfg/codegen/utils.h>
+#include <sdfg/structured_control_flow/control_flow_node.h>
+#include <sdfg/structured_control_flow/map.h>
+#include <sdfg/structured_sdfg.h>
+
+#include <memory>
+#include <set>
+#include <string>
+
+namespace sdfg {
+namespace codegen {
+
+// A map of a single iteration whose body holds one sequence per task, see blas/blas_tasks.h
+inline structured_control_flow::ScheduleType ScheduleType_BLASTasks("BLAS_TASKS");
+
+class BLASTaskMapDispatcher : public NodeDispatcher {
+    structured_control_flow::Map& node_;
+
+    void loop_indvars(structured_control_flow::ControlFlowNode& node,
+                      std::set<std::string>& result) const;
+
+   public:
+    BLASTaskMapDispatcher(LanguageExtension& language_extension, StructuredSDFG& sdfg,
+                          structured_control_flow::Map& node, Instrumentation& instrumentation);
+
+    virtual void dispatch_node(PrettyPrinter& main_stream, PrettyPrinter& globals_stream,
+                               PrettyPrinter& library_stream) override;
+};
+
+inline void register_blas_task_dispatcher() {
+    MapDispatcherRegistry::instance().register_map_dispatcher(
+        ScheduleType_BLASTasks.value(),
+        [](LanguageExtension& language_extension, StructuredSDFG& sdfg,
+           structured_control_flow::Map& node, Instrumentation& instrumentation) {
+            return std::make_unique<BLASTaskMapDispatcher>(language_extension, sdfg, node,
+                                                           instrumentation);
+        });
+}
+
+}  // namespace codegen
+}  // namespace sdfg
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <sdfg/analysis/analysis.h>
+#include <sdfg/analysis/users.h>
+#include <sdfg/builder/structured_sdfg_builder.h>
+#include <sdfg/passes/pass.h>
+#include <sdfg/structured_control_flow/control_flow_node.h>
+#include <sdfg/structured_control_flow/sequence.h>
+#include <sdfg/structured_sdfg.h>
+
+#include <cstddef>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace sdfg {
+namespace passes {
+
+/// Runs independent library calls of the timed region concurrently. The top-level children are
+/// leveled by their dependences, library calls of the same level move into a BLAS_TASKS map in
+/// front of the last of them and become OpenMP tasks with a share of the BLAS threads each.
+class BLASTaskScheduling : public Pass {
+    struct Accesses {
+        std::set<std::string> reads;
+        std::set<std::string> writes;
+    };
+
+    Accesses accesses(const StructuredSDFG& sdfg, analysis::Users& users,
+                      structured_control_flow::ControlFlowNode& node) const;
+
+    bool independent(const Accesses& first, const Accesses& second) const;
+
+    // Element ids of the children of the root that form the next task group, in order
+    std::vector<size_t> task_group(builder::StructuredSDFGBuilder& builder,
+                                   analysis::AnalysisManager& analysis_manager) const;
+
+   public:
+    BLASTaskScheduling();
+
+    virtual std::string name() override;
+
+    virtual bool run_pass(builder::StructuredSDFGBuilder& builder,
+                          analysis::AnalysisManager& analysis_manager) override;
+};
+
+}  // namespace passes
+}  // namespace sdfg
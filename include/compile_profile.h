@@ -0,0 +1,75 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <map>
+#include <nlohmann/json_fwd.hpp>
+#include <string>
+#include <vector>
+
+struct TransformationProfile {
+    size_t attempts = 0;
+    size_t applied = 0;
+    double can_be_applied_seconds = 0.0;
+    double apply_seconds = 0.0;
+};
+
+struct AnalysisProfile {
+    size_t requests = 0;
+    // Requests after an applied transformation, those rebuild the analysis
+    size_t recomputations = 0;
+    double seconds = 0.0;
+};
+
+struct StageProfile {
+    std::string name;
+    long parent;
+    double seconds = 0.0;
+    long peak_rss_kb = 0;
+    std::map<std::string, TransformationProfile> transformations;
+    std::map<std::string, AnalysisProfile> analyses;
+
+    StageProfile(const std::string& name, long parent) : name(name), parent(parent) {}
+};
+
+double elapsed_seconds(std::chrono::steady_clock::time_point start);
+
+// Compile-time profile of the optimizer. Stages nest, transformation attempts and analysis
+// requests are attributed to the innermost open stage.
+class CompileProfile {
+    std::vector<StageProfile> stages_;
+    std::vector<size_t> open_stages_;
+    std::chrono::steady_clock::time_point start_;
+    std::map<std::string, bool> analyses_valid_;
+
+    CompileProfile();
+
+    StageProfile& current();
+
+    nlohmann::json stage_json(size_t stage) const;
+
+   public:
+    CompileProfile(const CompileProfile&) = delete;
+    CompileProfile& operator=(const CompileProfile&) = delete;
+
+    static CompileProfile& instance();
+
+    class Stage {
+        std::chrono::steady_clock::time_point start_;
+        size_t index_;
+
+       public:
+        Stage(const std::string& name);
+        ~Stage();
+    };
+
+    void record_check(const std::string& transformation, double seconds);
+    void record_apply(const std::string& transformation, double seconds);
+    void record_analysis(const std::string& analysis, double seconds);
+
+    // Called whenever the SDFG changed outside of record_apply
+    void invalidate_analyses();
+
+    bool write(const std::filesystem::path& path) const;
+};
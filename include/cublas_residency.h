@@ -0,0 +1,54 @@
+#pragma once
+
+#include <sdfg/analysis/analysis.h>
+#include <sdfg/builder/structured_sdfg_builder.h>
+#include <sdfg/passes/pass.h>
+#include <sdfg/structured_control_flow/control_flow_node.h>
+#include <sdfg/structured_control_flow/sequence.h>
+#include <sdfg/structured_sdfg.h>
+
+#include <set>
+#include <string>
+
+#include "benchmarks.h"
+
+namespace sdfg {
+namespace passes {
+
+/// Keeps the arrays of the cuBLAS calls on the device between calls. The kernel registers the
+/// arrays of its library nodes, downloads an array before host code touches it, drops the device
+/// copies after host code wrote it and downloads the live-outs at the end of the timed region.
+/// cuda_residency.cuh turns the transfers of the generated calls into device copies.
+class CUBLASResidency : public Pass {
+    const Benchmark& benchmark_;
+    // Dataset of the SDFG, the arrays are registered with their size
+    const bool check_;
+
+    struct Accesses {
+        std::set<std::string> reads;
+        std::set<std::string> writes;
+        // Arrays of the library nodes
+        std::set<std::string> device;
+        // Host code and library calls share a block or a parallel loop
+        bool mixed = false;
+    };
+
+    std::string array_bytes(const StructuredSDFG& sdfg, const std::string& container) const;
+
+    void accesses(const StructuredSDFG& sdfg, structured_control_flow::ControlFlowNode& node,
+                  Accesses& result) const;
+
+    void guard(builder::StructuredSDFGBuilder& builder, structured_control_flow::Sequence& sequence,
+               const std::set<std::string>& device) const;
+
+   public:
+    CUBLASResidency(const Benchmark& benchmark, bool check);
+
+    virtual std::string name() override;
+
+    virtual bool run_pass(builder::StructuredSDFGBuilder& builder,
+                          analysis::AnalysisManager& analysis_manager) override;
+};
+
+}  // namespace passes
+}  // namespace sdfg
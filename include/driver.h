@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dump.h"
+
+struct Version {
+    // Name of the result file, e.g. opt_mkl
+    std::string short_name;
+    // Folder of the binaries below bin/, e.g. optimized_mkl
+    std::string long_name;
+};
+
+enum PinPolicy { CompactPinning, ScatterPinning };
+
+struct DriverOptions {
+    std::vector<Version> versions;
+    std::vector<std::string> benchmarks;
+    size_t reps = 5;
+    size_t omp_threads = 4;
+    size_t mkl_threads = 24;
+    // CPUs the binaries are pinned to, empty leaves the affinity untouched
+    std::vector<int> cpus;
+    std::string out_path = "results";
+    // Compare full precision binary dumps instead of the text dumps on stderr
+    bool binary_dumps = false;
+    Tolerance tolerance;
+    // Strong-scaling sweep over the thread counts instead of the fixed thread settings, an empty
+    // ladder sweeps powers of two up to all CPUs
+    bool sweep = false;
+    std::vector<size_t> thread_ladder;
+    // Compact fills the CPU list from the front, scatter spreads the threads evenly over it
+    PinPolicy pinning = CompactPinning;
+    // Extra variables of every run, e.g. POLYBENCH_BLAS_TASKS=0
+    std::vector<std::pair<std::string, std::string>> environment;
+};
+
+int drive(int argc, char* argv[]);
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+struct DumpArray {
+    std::vector<uint64_t> shape;
+    std::vector<double> values;
+};
+
+// Absolute tolerance of text dumps, they only carry two decimals
+const double TEXT_TOLERANCE = 0.011;
+
+// Live-out arrays of one run by name
+typedef std::map<std::string, DumpArray> Dump;
+
+struct Tolerance {
+    // An element matches if any of the bounds holds
+    double absolute = 1e-9;
+    double relative = 1e-6;
+    uint64_t ulps = 4;
+};
+
+struct ArrayComparison {
+    std::string name;
+    bool match = true;
+    size_t mismatches = 0;
+    size_t first_mismatch = 0;
+    double max_absolute_error = 0.0;
+    double max_relative_error = 0.0;
+    uint64_t max_ulps = 0;
+};
+
+// Text dump of POLYBENCH_DUMP_ARRAYS, the arrays are one-dimensional
+bool parse_text_dump(const std::string& text, Dump& dump);
+
+// Binary dump of POLYBENCH_DUMP_BINARY, see polybench_dump_begin
+bool read_binary_dump(const std::filesystem::path& path, Dump& dump);
+
+// FNV-1a over the bit patterns, equal only for bitwise identical arrays
+uint64_t checksum(const std::vector<double>& values);
+
+uint64_t ulp_distance(double a, double b);
+
+// Compares every array of the reference, returns whether all of them match
+bool compare_dumps(const Dump& reference, const Dump& dump, const Tolerance& tolerance,
+                   std::vector<ArrayComparison>& comparisons);
+
+int dump_compare(int argc, char* argv[]);
@@ -2,6 +2,7 @@
 
 #include <sdfg/analysis/analysis.h>
 #include <sdfg/builder/structured_sdfg_builder.h>
+#include <sdfg/data_flow/library_node.h>
 #include <sdfg/einsum/einsum_node.h>
 #include <sdfg/passes/pass.h>
 #include <sdfg/structured_control_flow/block.h>
@@ -9,17 +10,23 @@
 #include <sdfg/structured_control_flow/structured_loop.h>
 
 #include <functional>
+#include <nlohmann/json.hpp>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "optimize.h"
+#include "tuning.h"
 
 namespace sdfg {
 namespace passes {
 
 class EinsumPipeline : public Pass {
     BLASImplementation impl_;
+    PipelineConfig config_;
+    // Applied transformations and passes in order, see recipe()
+    nlohmann::json recipe_;
+    bool replay_;
 
     std::vector<
         std::pair<std::vector<std::reference_wrapper<structured_control_flow::StructuredLoop>>,
@@ -32,18 +39,43 @@ class EinsumPipeline : public Pass {
     std::vector<std::reference_wrapper<einsum::EinsumNode>> get_einsum_nodes(
         builder::StructuredSDFGBuilder& builder);
 
+    std::vector<std::pair<structured_control_flow::StructuredLoop&, data_flow::LibraryNode&>>
+    get_library_node_predecessor_loops(builder::StructuredSDFGBuilder& builder);
+
+    std::vector<std::pair<structured_control_flow::StructuredLoop&,
+                          structured_control_flow::StructuredLoop&>>
+    get_adjacent_loops(builder::StructuredSDFGBuilder& builder);
+
+    // Outer loops come before the loops they contain
+    std::vector<std::reference_wrapper<structured_control_flow::StructuredLoop>> get_loops(
+        builder::StructuredSDFGBuilder& builder);
+
     void block_fusion(builder::StructuredSDFGBuilder& builder,
                       analysis::AnalysisManager& analysis_manager,
                       structured_control_flow::Sequence& parent,
                       structured_control_flow::Sequence& node);
 
+    bool search(builder::StructuredSDFGBuilder& builder,
+                analysis::AnalysisManager& analysis_manager);
+
+    bool replay(builder::StructuredSDFGBuilder& builder,
+                analysis::AnalysisManager& analysis_manager);
+
    public:
     EinsumPipeline(BLASImplementation impl);
 
+    // Searches with the choices of a tuned configuration instead of the defaults
+    EinsumPipeline(BLASImplementation impl, const PipelineConfig& config);
+
+    // Applies a recorded recipe instead of searching for applicable transformations
+    EinsumPipeline(BLASImplementation impl, const nlohmann::json& recipe);
+
     virtual std::string name() override;
 
     virtual bool run_pass(builder::StructuredSDFGBuilder& builder,
                           analysis::AnalysisManager& analysis_manager) override;
+
+    const nlohmann::json& recipe() const;
 };
 
 }  // namespace passes
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <sdfg/analysis/analysis.h>
+#include <sdfg/builder/structured_sdfg_builder.h>
+#include <sdfg/passes/pass.h>
+#include <sdfg/structured_control_flow/control_flow_node.h>
+#include <sdfg/structured_control_flow/map.h>
+#include <sdfg/structured_sdfg.h>
+#include <sdfg/symbolic/symbolic.h>
+
+#include <string>
+#include <unordered_set>
+
+namespace sdfg {
+namespace passes {
+
+/// Runs the initialization loop nests in front of the timed region in parallel. Each iteration
+/// of an outermost map must only write its own slice of the arrays.
+class InitParallelization : public Pass {
+    bool independent(structured_control_flow::ControlFlowNode& node,
+                     const symbolic::Symbol& indvar, const StructuredSDFG& sdfg,
+                     std::unordered_set<std::string>& written) const;
+
+    bool parallelizable(structured_control_flow::Map& map, const StructuredSDFG& sdfg) const;
+
+   public:
+    InitParallelization();
+
+    virtual std::string name() override;
+
+    virtual bool run_pass(builder::StructuredSDFGBuilder& builder,
+                          analysis::AnalysisManager& analysis_manager) override;
+};
+
+}  // namespace passes
+}  // namespace sdfg
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <sdfg/analysis/analysis.h>
+#include <sdfg/builder/structured_sdfg_builder.h>
+#include <sdfg/data_flow/memlet.h>
+#include <sdfg/symbolic/symbolic.h>
+
+#include <nlohmann/json_fwd.hpp>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "sdfg/structured_control_flow/control_flow_node.h"
+#include "sdfg/structured_control_flow/structured_loop.h"
+#include "sdfg/transformations/transformation.h"
+
+namespace sdfg {
+namespace transformations {
+
+class LoopFusion : public Transformation {
+    structured_control_flow::StructuredLoop& first_loop_;
+    structured_control_flow::StructuredLoop& second_loop_;
+
+    // container -> [(subset, is write)]
+    typedef std::unordered_map<std::string, std::vector<std::pair<data_flow::Subset, bool>>>
+        Accesses;
+
+    bool collect_accesses(structured_control_flow::ControlFlowNode& node, Accesses& accesses,
+                          symbolic::SymbolSet& indvars);
+
+    bool conflicting(const Accesses& first, const Accesses& second, const std::string& container,
+                     const symbolic::SymbolSet& indvars);
+
+   public:
+    LoopFusion(structured_control_flow::StructuredLoop& first_loop,
+               structured_control_flow::StructuredLoop& second_loop);
+
+    virtual std::string name() const override;
+
+    virtual bool can_be_applied(builder::StructuredSDFGBuilder& builder,
+                                analysis::AnalysisManager& analysis_manager) override;
+
+    virtual void apply(builder::StructuredSDFGBuilder& builder,
+                       analysis::AnalysisManager& analysis_manager) override;
+
+    virtual void to_json(nlohmann::json& j) const override;
+
+    static LoopFusion from_json(builder::StructuredSDFGBuilder& builder, const nlohmann::json& j);
+};
+
+}  // namespace transformations
+}  // namespace sdfg
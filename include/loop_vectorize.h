@@ -0,0 +1,40 @@
+#pragma once
+
+#include <sdfg/analysis/analysis.h>
+#include <sdfg/builder/structured_sdfg_builder.h>
+#include <sdfg/data_flow/memlet.h>
+#include <sdfg/symbolic/symbolic.h>
+
+#include <nlohmann/json_fwd.hpp>
+#include <string>
+
+#include "sdfg/structured_control_flow/structured_loop.h"
+#include "sdfg/transformations/transformation.h"
+
+namespace sdfg {
+namespace transformations {
+
+class LoopVectorize : public Transformation {
+    structured_control_flow::StructuredLoop& loop_;
+
+    bool unit_stride(const data_flow::Subset& subset, const symbolic::Symbol& indvar);
+
+   public:
+    LoopVectorize(structured_control_flow::StructuredLoop& loop);
+
+    virtual std::string name() const override;
+
+    virtual bool can_be_applied(builder::StructuredSDFGBuilder& builder,
+                                analysis::AnalysisManager& analysis_manager) override;
+
+    virtual void apply(builder::StructuredSDFGBuilder& builder,
+                       analysis::AnalysisManager& analysis_manager) override;
+
+    virtual void to_json(nlohmann::json& j) const override;
+
+    static LoopVectorize from_json(builder::StructuredSDFGBuilder& builder,
+                                   const nlohmann::json& j);
+};
+
+}  // namespace transformations
+}  // namespace sdfg
@@ -1,5 +1,38 @@
 #pragma once
 
-enum BLASImplementation { MKL, MKL3, CUBLAS };
+#include <cstddef>
+#include <string>
+
+// MKL3 lowers to the level 3 calls Gemm, Symm and Syrk, the others use Einsum2BLAS. OPENBLAS,
+// BLIS and CBLAS (the reference implementation) differ from MKL only in the library. BUILTIN
+// (blas/builtin_blas.h) tries the level 3 lowerings of MKL3 before Einsum2BLAS.
+enum BLASImplementation { MKL, MKL3, CUBLAS, OPENBLAS, BLIS, CBLAS, BUILTIN };
+
+enum AllocationMode { DefaultAllocation, AlignedAllocation, HugePageAllocation };
+
+enum NUMAPlacement { DefaultPlacement, InterleavePlacement, LocalPlacement };
+
+struct MainOptions {
+    AllocationMode allocation = DefaultAllocation;
+    // Shift between consecutive arrays in bytes, keeps aligned bases out of the same cache sets
+    size_t inter_array_offset = 0;
+    NUMAPlacement numa = DefaultPlacement;
+    // Time every loop nest and library call of the SCoP separately
+    bool regions = false;
+    // Read hardware counters around the SCoP and the timing regions
+    bool counters = false;
+    // Measured in-process repetitions of the kernel, none keeps the single timed call
+    size_t runs = 0;
+    size_t warmup = 0;
+    bool flush_cache = true;
+    // Write the compile-time profile of the optimizer next to the generated sources
+    bool profile = false;
+    // Recipe of a previous run to replay, empty searches and records a new recipe
+    std::string replay_recipe;
+    // Pipeline configuration to search with, empty consults the tuning database
+    std::string pipeline_config;
+    std::string tuning_database = "tuning/db.json";
+    bool tuning = true;
+};
 
 int optimize(BLASImplementation impl, int argc, char* argv[]);
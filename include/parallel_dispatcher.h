@@ -0,0 +1,46 @@
+#pragma once
+
+#include <sdfg/codegen/dispatchers/node_dispatcher.h>
+#include <sdfg/codegen/dispatchers/node_dispatcher_registry.h>
+#include <sdfg/codegen/instrumentation/instrumentation.h>
+#include <sdfg/codegen/language_extension.h>
+#include <sdfg/codegen/utils.h>
+#include <sdfg/structured_control_flow/map.h>
+#include <sdfg/structured_control_flow/sequence.h>
+#include <sdfg/structured_sdfg.h>
+
+#include <memory>
+#include <set>
+#include <string>
+
+namespace sdfg {
+namespace codegen {
+
+inline structured_control_flow::ScheduleType ScheduleType_Parallel("PARALLEL");
+
+class ParallelMapDispatcher : public NodeDispatcher {
+    structured_control_flow::Map& node_;
+
+    void private_containers(structured_control_flow::Sequence& sequence,
+                            std::set<std::string>& result) const;
+
+   public:
+    ParallelMapDispatcher(LanguageExtension& language_extension, StructuredSDFG& sdfg,
+                          structured_control_flow::Map& node, Instrumentation& instrumentation);
+
+    virtual void dispatch_node(PrettyPrinter& main_stream, PrettyPrinter& globals_stream,
+                               PrettyPrinter& library_stream) override;
+};
+
+inline void register_parallel_dispatcher() {
+    MapDispatcherRegistry::instance().register_map_dispatcher(
+        ScheduleType_Parallel.value(),
+        [](LanguageExtension& language_extension, StructuredSDFG& sdfg,
+           structured_control_flow::Map& node, Instrumentation& instrumentation) {
+            return std::make_unique<ParallelMapDispatcher>(language_extension, sdfg, node,
+                                                           instrumentation);
+        });
+}
+
+}  // namespace codegen
+}  // namespace sdfg
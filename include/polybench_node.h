@@ -21,14 +21,32 @@ namespace polybench {
 
 inline data_flow::LibraryNodeCode LibraryNodeType_PolyBench("PolyBench");
 
-enum PolyBenchNodeType { StartInstruments, StopAndPrintInstruments };
+enum PolyBenchNodeType {
+    StartInstruments,
+    StopAndPrintInstruments,
+    StartRegion,
+    StopRegion,
+    PrintRegions,
+    StartCounters,
+    StopAndPrintCounters,
+    ThreadBudget,
+    NestedThreadBudget,
+    // Device residency of the CUBLAS backend, the region names the array and for CUDARegister
+    // also its size in bytes
+    CUDARegister,
+    CUDADownload,
+    CUDAHostWrite,
+    CUDARelease
+};
 
 class PolyBenchNode : public data_flow::LibraryNode {
     const PolyBenchNodeType type_;
+    const std::string region_;
 
    public:
     PolyBenchNode(size_t element_id, const DebugInfo& debug_info, const graph::Vertex vertex,
-                  data_flow::DataFlowGraph& parent, const PolyBenchNodeType type);
+                  data_flow::DataFlowGraph& parent, const PolyBenchNodeType type,
+                  const std::string& region = "");
 
     PolyBenchNode(const PolyBenchNode&) = delete;
     PolyBenchNode& operator=(const PolyBenchNode&) = delete;
@@ -37,6 +55,8 @@ class PolyBenchNode : public data_flow::LibraryNode {
 
     PolyBenchNodeType type() const;
 
+    const std::string& region() const;
+
     virtual std::unique_ptr<data_flow::DataFlowNode> clone(
         size_t element_id, const graph::Vertex vertex,
         data_flow::DataFlowGraph& parent) const override;
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct ProcessOutput {
+    bool success;
+    std::string out;
+    std::string err;
+};
+
+// Runs the command with the additional environment variables and collects its output, an empty
+// CPU list leaves the affinity untouched. The executable is searched in PATH without a slash.
+ProcessOutput run_process(const std::vector<std::string>& command,
+                          const std::vector<std::pair<std::string, std::string>>& environment,
+                          const std::vector<int>& cpus);
+
+// Thread counts of OpenMP and the BLAS library, the OpenMP threads are bound to consecutive cores.
+// The optimized versions take them as the budgets of their parallel loops and library calls.
+std::vector<std::pair<std::string, std::string>> thread_environment(size_t omp_threads,
+                                                                    size_t mkl_threads);
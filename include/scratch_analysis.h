@@ -0,0 +1,36 @@
+#pragma once
+
+#include <sdfg/structured_control_flow/control_flow_node.h>
+#include <sdfg/structured_sdfg.h>
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "benchmarks.h"
+
+namespace sdfg {
+namespace analysis {
+
+// Determines the variables of a benchmark that are written before being read inside the SCoP and
+// never accessed outside of it. Those variables are temporaries that can live in a scratch arena.
+class ScratchArrayAnalysis {
+    const Benchmark& benchmark_;
+
+    enum AccessState { Unaccessed, ScopWrittenFirst, Escaping };
+
+    bool in_scop_;
+    std::unordered_map<std::string, AccessState> states_;
+
+    void visit(const structured_control_flow::ControlFlowNode& node);
+    void access(const std::string& container, bool write);
+
+   public:
+    ScratchArrayAnalysis(const Benchmark& benchmark);
+
+    std::unordered_set<size_t> run(const StructuredSDFG& sdfg);
+};
+
+}  // namespace analysis
+}  // namespace sdfg
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <sdfg/codegen/dispatchers/node_dispatcher.h>
+#include <sdfg/codegen/dispatchers/node_dispatcher_registry.h>
+#include <sdfg/codegen/instrumentation/instrumentation.h>
+#include <sdfg/codegen/language_extension.h>
+#include <sdfg/codegen/utils.h>
+#include <sdfg/structured_control_flow/map.h>
+#include <sdfg/structured_sdfg.h>
+
+#include <memory>
+#include <set>
+#include <string>
+
+namespace sdfg {
+namespace codegen {
+
+inline structured_control_flow::ScheduleType ScheduleType_SIMD("SIMD");
+
+class SIMDMapDispatcher : public NodeDispatcher {
+    structured_control_flow::Map& node_;
+
+    std::set<std::string> private_containers() const;
+
+   public:
+    SIMDMapDispatcher(LanguageExtension& language_extension, StructuredSDFG& sdfg,
+                      structured_control_flow::Map& node, Instrumentation& instrumentation);
+
+    virtual void dispatch_node(PrettyPrinter& main_stream, PrettyPrinter& globals_stream,
+                               PrettyPrinter& library_stream) override;
+};
+
+inline void register_simd_dispatcher() {
+    MapDispatcherRegistry::instance().register_map_dispatcher(
+        ScheduleType_SIMD.value(),
+        [](LanguageExtension& language_extension, StructuredSDFG& sdfg,
+           structured_control_flow::Map& node, Instrumentation& instrumentation) {
+            return std::make_unique<SIMDMapDispatcher>(language_extension, sdfg, node,
+                                                       instrumentation);
+        });
+}
+
+}  // namespace codegen
+}  // namespace sdfg
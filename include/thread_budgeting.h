@@ -0,0 +1,35 @@
+#pragma once
+
+#include <sdfg/analysis/analysis.h>
+#include <sdfg/builder/structured_sdfg_builder.h>
+#include <sdfg/passes/pass.h>
+#include <sdfg/structured_control_flow/control_flow_node.h>
+
+#include <string>
+
+namespace sdfg {
+namespace passes {
+
+/// Sets the thread budgets of OpenMP and the BLAS library in front of the top-level regions of
+/// the kernel. Parallel loops and library calls of sequential code get all threads, calls on the
+/// threads of a parallel loop run sequentially. A budget is only set where it changes.
+class ThreadBudgeting : public Pass {
+    struct Needs {
+        bool parallel_loops = false;
+        bool sequential_calls = false;
+        bool nested_calls = false;
+    };
+
+    void needs(structured_control_flow::ControlFlowNode& node, bool parallel, Needs& result) const;
+
+   public:
+    ThreadBudgeting();
+
+    virtual std::string name() override;
+
+    virtual bool run_pass(builder::StructuredSDFGBuilder& builder,
+                          analysis::AnalysisManager& analysis_manager) override;
+};
+
+}  // namespace passes
+}  // namespace sdfg
@@ -3,7 +3,9 @@
 #include <sdfg/analysis/analysis.h>
 #include <sdfg/builder/structured_sdfg_builder.h>
 #include <sdfg/passes/pass.h>
+#include <sdfg/structured_control_flow/sequence.h>
 
+#include <cstddef>
 #include <string>
 
 #include "benchmarks.h"
@@ -11,6 +13,10 @@
 namespace sdfg {
 namespace passes {
 
+/// Positions of the start and stop instruments of the timed region among the children of the root.
+bool find_instruments(structured_control_flow::Sequence& root, size_t& scop_index,
+                      size_t& endscop_index);
+
 class PolyBenchTimerInstrumentation : public Pass {
     const CodeRegion& code_region_;
 
@@ -23,5 +29,35 @@ class PolyBenchTimerInstrumentation : public Pass {
                           analysis::AnalysisManager& analysis_manager) override;
 };
 
+/// Wraps every top-level loop nest and every top-level library call of the timed region into a
+/// named timing region. Calls inside loop nests are part of the region of their nest.
+class PolyBenchRegionInstrumentation : public Pass {
+    void instrument(builder::StructuredSDFGBuilder& builder,
+                    structured_control_flow::Sequence& sequence, size_t begin, size_t end,
+                    bool top_level);
+
+    void wrap(builder::StructuredSDFGBuilder& builder, structured_control_flow::Sequence& sequence,
+              size_t index, const std::string& region);
+
+   public:
+    PolyBenchRegionInstrumentation();
+
+    virtual std::string name() override;
+
+    virtual bool run_pass(builder::StructuredSDFGBuilder& builder,
+                          analysis::AnalysisManager& analysis_manager) override;
+};
+
+/// Reads the hardware counters right inside the instruments of the timed region.
+class PolyBenchCounterInstrumentation : public Pass {
+   public:
+    PolyBenchCounterInstrumentation();
+
+    virtual std::string name() override;
+
+    virtual bool run_pass(builder::StructuredSDFGBuilder& builder,
+                          analysis::AnalysisManager& analysis_manager) override;
+};
+
 }  // namespace passes
 }  // namespace sdfg
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "optimize.h"
+
+// Choices of the EinsumPipeline that are worth measuring instead of fixing them
+struct PipelineConfig {
+    // Einsum nodes that stay loop nests instead of becoming BLAS calls, by the order in which
+    // Einsum2BLAS finds them
+    std::set<size_t> skipped_einsums;
+    // Lowerings tried by MKL3 and BUILTIN in order, the first applicable one wins
+    std::vector<std::string> lowerings = {"Gemm", "Symm", "Syrk"};
+    bool loop_fusion = true;
+    bool vectorize = true;
+    bool batch_blas = true;
+};
+
+void to_json(nlohmann::json& json, const PipelineConfig& config);
+void from_json(const nlohmann::json& json, PipelineConfig& config);
+
+std::string implementation_name(BLASImplementation impl);
+
+// Hash of CPU model, CPU count and memory size, tuned configurations only carry over to
+// identical machines
+std::string machine_fingerprint();
+
+// Dataset the run binaries are built for, the check binaries reuse their configuration
+const std::string TUNING_DATASET = "EXTRALARGE";
+
+// Winning configurations of the autotuner by benchmark, implementation, dataset and machine
+class TuningDatabase {
+    std::filesystem::path path_;
+    nlohmann::json entries_;
+
+   public:
+    TuningDatabase(const std::filesystem::path& path);
+
+    static std::string key(const std::string& benchmark, BLASImplementation impl);
+
+    std::optional<PipelineConfig> lookup(const std::string& key) const;
+
+    void store(const std::string& key, const PipelineConfig& config, double seconds,
+               double default_seconds);
+
+    bool save() const;
+};
@@ -52,8 +52,8 @@ void print_array(int m,
   POLYBENCH_DUMP_BEGIN("corr");
   for (i = 0; i < m; i++)
     for (j = 0; j < m; j++) {
-      if ((i * m + j) % 20 == 0) fprintf (POLYBENCH_DUMP_TARGET, "\n");
-      fprintf (POLYBENCH_DUMP_TARGET, DATA_PRINTF_MODIFIER, corr[i][j]);
+      if ((i * m + j) % 20 == 0) POLYBENCH_DUMP_NEWLINE;
+      POLYBENCH_DUMP_VALUE(corr[i][j]);
     }
   POLYBENCH_DUMP_END("corr");
   POLYBENCH_DUMP_FINISH;
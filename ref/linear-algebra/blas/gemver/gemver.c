@@ -70,8 +70,8 @@ void print_array(int n,
   POLYBENCH_DUMP_START;
   POLYBENCH_DUMP_BEGIN("w");
   for (i = 0; i < n; i++) {
-    if (i % 20 == 0) fprintf (POLYBENCH_DUMP_TARGET, "\n");
-    fprintf (POLYBENCH_DUMP_TARGET, DATA_PRINTF_MODIFIER, w[i]);
+    if (i % 20 == 0) POLYBENCH_DUMP_NEWLINE;
+    POLYBENCH_DUMP_VALUE(w[i]);
   }
   POLYBENCH_DUMP_END("w");
   POLYBENCH_DUMP_FINISH;
@@ -60,8 +60,8 @@ void print_array(int m, int n,
   POLYBENCH_DUMP_BEGIN("C");
   for (i = 0; i < m; i++)
     for (j = 0; j < n; j++) {
-	if ((i * m + j) % 20 == 0) fprintf (POLYBENCH_DUMP_TARGET, "\n");
-	fprintf (POLYBENCH_DUMP_TARGET, DATA_PRINTF_MODIFIER, C[i][j]);
+	if ((i * m + j) % 20 == 0) POLYBENCH_DUMP_NEWLINE;
+	POLYBENCH_DUMP_VALUE(C[i][j]);
     }
   POLYBENCH_DUMP_END("C");
   POLYBENCH_DUMP_FINISH;
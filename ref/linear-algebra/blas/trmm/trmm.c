@@ -56,8 +56,8 @@ void print_array(int m, int n,
   POLYBENCH_DUMP_BEGIN("B");
   for (i = 0; i < m; i++)
     for (j = 0; j < n; j++) {
-	if ((i * m + j) % 20 == 0) fprintf (POLYBENCH_DUMP_TARGET, "\n");
-	fprintf (POLYBENCH_DUMP_TARGET, DATA_PRINTF_MODIFIER, B[i][j]);
+	if ((i * m + j) % 20 == 0) POLYBENCH_DUMP_NEWLINE;
+	POLYBENCH_DUMP_VALUE(B[i][j]);
     }
   POLYBENCH_DUMP_END("B");
   POLYBENCH_DUMP_FINISH;
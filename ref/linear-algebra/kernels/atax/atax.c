@@ -51,8 +51,8 @@ void print_array(int n,
   POLYBENCH_DUMP_START;
   POLYBENCH_DUMP_BEGIN("y");
   for (i = 0; i < n; i++) {
-    if (i % 20 == 0) fprintf (POLYBENCH_DUMP_TARGET, "\n");
-    fprintf (POLYBENCH_DUMP_TARGET, DATA_PRINTF_MODIFIER, y[i]);
+    if (i % 20 == 0) POLYBENCH_DUMP_NEWLINE;
+    POLYBENCH_DUMP_VALUE(y[i]);
   }
   POLYBENCH_DUMP_END("y");
   POLYBENCH_DUMP_FINISH;
@@ -57,15 +57,15 @@ void print_array(int n,
   POLYBENCH_DUMP_START;
   POLYBENCH_DUMP_BEGIN("x1");
   for (i = 0; i < n; i++) {
-    if (i % 20 == 0) fprintf (POLYBENCH_DUMP_TARGET, "\n");
-    fprintf (POLYBENCH_DUMP_TARGET, DATA_PRINTF_MODIFIER, x1[i]);
+    if (i % 20 == 0) POLYBENCH_DUMP_NEWLINE;
+    POLYBENCH_DUMP_VALUE(x1[i]);
   }
   POLYBENCH_DUMP_END("x1");
 
   POLYBENCH_DUMP_BEGIN("x2");
   for (i = 0; i < n; i++) {
-    if (i % 20 == 0) fprintf (POLYBENCH_DUMP_TARGET, "\n");
-    fprintf (POLYBENCH_DUMP_TARGET, DATA_PRINTF_MODIFIER, x2[i]);
+    if (i % 20 == 0) POLYBENCH_DUMP_NEWLINE;
+    POLYBENCH_DUMP_VALUE(x2[i]);
   }
   POLYBENCH_DUMP_END("x2");
   POLYBENCH_DUMP_FINISH;
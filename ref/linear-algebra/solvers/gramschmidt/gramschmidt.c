@@ -55,16 +55,16 @@ void print_array(int m, int n,
   POLYBENCH_DUMP_BEGIN("R");
   for (i = 0; i < n; i++)
     for (j = 0; j < n; j++) {
-	if ((i*n+j) % 20 == 0) fprintf (POLYBENCH_DUMP_TARGET, "\n");
-	fprintf (POLYBENCH_DUMP_TARGET, DATA_PRINTF_MODIFIER, R[i][j]);
+	if ((i*n+j) % 20 == 0) POLYBENCH_DUMP_NEWLINE;
+	POLYBENCH_DUMP_VALUE(R[i][j]);
     }
   POLYBENCH_DUMP_END("R");
 
   POLYBENCH_DUMP_BEGIN("Q");
   for (i = 0; i < m; i++)
     for (j = 0; j < n; j++) {
-	if ((i*n+j) % 20 == 0) fprintf (POLYBENCH_DUMP_TARGET, "\n");
-	fprintf (POLYBENCH_DUMP_TARGET, DATA_PRINTF_MODIFIER, Q[i][j]);
+	if ((i*n+j) % 20 == 0) POLYBENCH_DUMP_NEWLINE;
+	POLYBENCH_DUMP_VALUE(Q[i][j]);
     }
   POLYBENCH_DUMP_END("Q");
   POLYBENCH_DUMP_FINISH;
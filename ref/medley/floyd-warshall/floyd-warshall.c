@@ -50,8 +50,8 @@ void print_array(int n,
   POLYBENCH_DUMP_BEGIN("path");
   for (i = 0; i < n; i++)
     for (j = 0; j < n; j++) {
-      if ((i * n + j) % 20 == 0) fprintf (POLYBENCH_DUMP_TARGET, "\n");
-      fprintf (POLYBENCH_DUMP_TARGET, DATA_PRINTF_MODIFIER, path[i][j]);
+      if ((i * n + j) % 20 == 0) POLYBENCH_DUMP_NEWLINE;
+      POLYBENCH_DUMP_VALUE(path[i][j]);
     }
   POLYBENCH_DUMP_END("path");
   POLYBENCH_DUMP_FINISH;
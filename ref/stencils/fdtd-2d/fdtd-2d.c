@@ -60,24 +60,24 @@ void print_array(int nx,
   POLYBENCH_DUMP_BEGIN("ex");
   for (i = 0; i < nx; i++)
     for (j = 0; j < ny; j++) {
-      if ((i * nx + j) % 20 == 0) fprintf(POLYBENCH_DUMP_TARGET, "\n");
-      fprintf(POLYBENCH_DUMP_TARGET, DATA_PRINTF_MODIFIER, ex[i][j]);
+      if ((i * nx + j) % 20 == 0) POLYBENCH_DUMP_NEWLINE;
+      POLYBENCH_DUMP_VALUE(ex[i][j]);
     }
   POLYBENCH_DUMP_END("ex");
 
   POLYBENCH_DUMP_BEGIN("ey");
   for (i = 0; i < nx; i++)
     for (j = 0; j < ny; j++) {
-      if ((i * nx + j) % 20 == 0) fprintf(POLYBENCH_DUMP_TARGET, "\n");
-      fprintf(POLYBENCH_DUMP_TARGET, DATA_PRINTF_MODIFIER, ey[i][j]);
+      if ((i * nx + j) % 20 == 0) POLYBENCH_DUMP_NEWLINE;
+      POLYBENCH_DUMP_VALUE(ey[i][j]);
     }
   POLYBENCH_DUMP_END("ey");
 
   POLYBENCH_DUMP_BEGIN("hz");
   for (i = 0; i < nx; i++)
     for (j = 0; j < ny; j++) {
-      if ((i * nx + j) % 20 == 0) fprintf(POLYBENCH_DUMP_TARGET, "\n");
-      fprintf(POLYBENCH_DUMP_TARGET, DATA_PRINTF_MODIFIER, hz[i][j]);
+      if ((i * nx + j) % 20 == 0) POLYBENCH_DUMP_NEWLINE;
+      POLYBENCH_DUMP_VALUE(hz[i][j]);
     }
   POLYBENCH_DUMP_END("hz");
 
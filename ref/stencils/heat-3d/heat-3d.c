@@ -50,8 +50,8 @@ void print_array(int n,
   for (i = 0; i < n; i++)
     for (j = 0; j < n; j++)
       for (k = 0; k < n; k++) {
-         if ((i * n * n + j * n + k) % 20 == 0) fprintf(POLYBENCH_DUMP_TARGET, "\n");
-         fprintf(POLYBENCH_DUMP_TARGET, DATA_PRINTF_MODIFIER, A[i][j][k]);
+         if ((i * n * n + j * n + k) % 20 == 0) POLYBENCH_DUMP_NEWLINE;
+         POLYBENCH_DUMP_VALUE(A[i][j][k]);
       }
   POLYBENCH_DUMP_END("A");
   POLYBENCH_DUMP_FINISH;
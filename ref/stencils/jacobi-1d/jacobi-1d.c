@@ -50,8 +50,8 @@ void print_array(int n,
   POLYBENCH_DUMP_BEGIN("A");
   for (i = 0; i < n; i++)
     {
-      if (i % 20 == 0) fprintf(POLYBENCH_DUMP_TARGET, "\n");
-      fprintf(POLYBENCH_DUMP_TARGET, DATA_PRINTF_MODIFIER, A[i]);
+      if (i % 20 == 0) POLYBENCH_DUMP_NEWLINE;
+      POLYBENCH_DUMP_VALUE(A[i]);
     }
   POLYBENCH_DUMP_END("A");
   POLYBENCH_DUMP_FINISH;
@@ -11,14 +11,22 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <assert.h>
 #include <time.h>
 #include <sys/time.h>
 #include <sys/resource.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
 #include <sched.h>
 #include <math.h>
+#ifdef __linux__
+# include <linux/perf_event.h>
+#endif
 #ifdef _OPENMP
 # include <omp.h>
 #endif
@@ -44,6 +52,7 @@
 
 int polybench_papi_counters_threadid = POLYBENCH_THREAD_MONITOR;
 double polybench_program_total_flops = 0;
+double polybench_program_total_bytes = 0;
 
 #ifdef POLYBENCH_PAPI
 # include <papi.h>
@@ -74,6 +83,107 @@ struct polybench_data_ptrs
 static struct polybench_data_ptrs* _polybench_alloc_table = NULL;
 static size_t polybench_inter_array_padding_sz = 0;
 
+/*
+ * Scratch arena for temporaries that are only live inside the SCoP. A
+ * single, huge-page backed allocation that is carved into aligned chunks.
+ *
+ */
+#define POLYBENCH_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#define POLYBENCH_MAX_NUMA_NODES 1024
+#define POLYBENCH_MAX_CPUS 4096
+static char* polybench_scratch_arena = NULL;
+static size_t polybench_scratch_size = 0;
+static size_t polybench_scratch_used = 0;
+
+/*
+ * Allocation policy of polybench_alloc_data, see
+ * polybench_set_alloc_policy. In the non-default modes each array is
+ * shifted by a growing offset and the original pointer is stored in
+ * front of the data. The count covers the arrays of all modes.
+ *
+ */
+static int polybench_alloc_mode = POLYBENCH_ALLOC_DEFAULT;
+static size_t polybench_alloc_offset = 0;
+static size_t polybench_alloc_count = 0;
+
+/*
+ * Hardware counters through perf_event_open. The counters are opened
+ * once, inherited by all threads created afterwards and never stopped,
+ * regions take the difference of two reads. When more events are open
+ * than the PMU has counters the kernel multiplexes them, every
+ * difference is then scaled by the time the counter was enabled over
+ * the time it actually ran.
+ *
+ */
+#define POLYBENCH_NB_PERF_COUNTERS 5
+#define POLYBENCH_PERF_CYCLES 0
+#define POLYBENCH_PERF_INSTRUCTIONS 1
+#define POLYBENCH_PERF_LLC_MISSES 2
+#define POLYBENCH_PERF_FP_OPS 3
+#define POLYBENCH_PERF_MEM_EVENT 4
+static const char* polybench_perf_names[POLYBENCH_NB_PERF_COUNTERS] =
+  { "cycles", "instructions", "llc_misses", "fp_ops", "mem_event" };
+static int polybench_perf_fds[POLYBENCH_NB_PERF_COUNTERS] = { -1, -1, -1, -1, -1 };
+static int polybench_perf_enabled = 0;
+struct polybench_perf_reading
+{
+  unsigned long long value;
+  unsigned long long enabled;
+  unsigned long long running;
+};
+static int polybench_perf_multiplexed = 0;
+static struct polybench_perf_reading polybench_perf_start[POLYBENCH_NB_PERF_COUNTERS];
+static unsigned long long polybench_perf_total[POLYBENCH_NB_PERF_COUNTERS];
+static double polybench_perf_t_start, polybench_perf_t_total;
+
+/*
+ * Named timing regions. A region is identified by its name and keeps
+ * the region that was open when it was entered first as its parent.
+ *
+ */
+#define POLYBENCH_MAX_REGIONS 256
+struct polybench_region
+{
+  const char* name;
+  int parent;
+  unsigned long calls;
+  double start;
+  double total;
+  struct polybench_perf_reading counters_start[POLYBENCH_NB_PERF_COUNTERS];
+  unsigned long long counters[POLYBENCH_NB_PERF_COUNTERS];
+};
+static struct polybench_region polybench_regions[POLYBENCH_MAX_REGIONS];
+static int polybench_nb_regions = 0;
+static int polybench_region_stack[POLYBENCH_MAX_REGIONS];
+static int polybench_region_depth = 0;
+
+/*
+ * In-process repetitions of the kernel. Warmup runs are executed but
+ * neither recorded nor reported, the timer of every measured run is
+ * kept as a sample.
+ *
+ */
+static int polybench_nb_runs = 0;
+static int polybench_nb_warmup = 0;
+static int polybench_flush_enabled = 1;
+static int polybench_run_index = 0;
+static double* polybench_samples = NULL;
+static int polybench_nb_samples = 0;
+
+/*
+ * Binary dump of the live-out data. The values of an array are buffered
+ * until its end, the record then carries the final element count.
+ *
+ */
+#define POLYBENCH_DUMP_MAGIC "PBDUMP1\n"
+#define POLYBENCH_DUMP_MAX_DIMS 8
+static FILE* polybench_dump_file = NULL;
+static double* polybench_dump_values = NULL;
+static uint64_t polybench_dump_count = 0;
+static uint64_t polybench_dump_capacity = 0;
+static uint32_t polybench_dump_nb_dims = 0;
+static uint64_t polybench_dump_dims[POLYBENCH_DUMP_MAX_DIMS];
+
 /* Timer code (gettimeofday). */
 double polybench_t_start, polybench_t_end;
 /* Timer code (RDTSC). */
@@ -353,7 +463,8 @@ void polybench_papi_print()
 void polybench_prepare_instruments()
 {
 #ifndef POLYBENCH_NO_FLUSH_CACHE
-  polybench_flush_cache ();
+  if (polybench_flush_enabled)
+    polybench_flush_cache ();
 #endif
 #ifdef POLYBENCH_LINUX_FIFO_SCHEDULER
   polybench_linux_fifo_scheduler ();
@@ -385,8 +496,39 @@ void polybench_timer_stop()
 }
 
 
+#ifndef POLYBENCH_CYCLE_ACCURATE_TIMER
+static
+void print_roofline(double time)
+{
+  /* Stderr keeps stdout to the single number parsed by the scripts. */
+  if (polybench_program_total_flops == 0 || time <= 0)
+    return;
+  fprintf (stderr, "gflops %0.3f\n", polybench_program_total_flops / time / 1.0e9);
+  if (polybench_program_total_bytes == 0)
+    return;
+  fprintf (stderr, "gbs %0.3f\n", polybench_program_total_bytes / time / 1.0e9);
+  fprintf (stderr, "intensity %0.3f\n",
+	   polybench_program_total_flops / polybench_program_total_bytes);
+}
+#endif
+
+
 void polybench_timer_print()
 {
+  if (polybench_nb_runs > 0)
+    {
+      /* Reported at once by polybench_report_repetitions. */
+      if (polybench_run_index > polybench_nb_warmup)
+#ifndef POLYBENCH_CYCLE_ACCURATE_TIMER
+	polybench_samples[polybench_nb_samples++] = polybench_t_end - polybench_t_start;
+#else
+	polybench_samples[polybench_nb_samples++] = polybench_c_end - polybench_c_start;
+#endif
+      return;
+    }
+#ifndef POLYBENCH_CYCLE_ACCURATE_TIMER
+  print_roofline (polybench_t_end - polybench_t_start);
+#endif
 #ifdef POLYBENCH_GFLOPS
       if  (polybench_program_total_flops == 0)
 	{
@@ -512,10 +654,46 @@ void check_alloc_table_state()
 #endif // !POLYBENCH_ENABLE_INTARRAY_PAD
 
 
+static
+void*
+xmalloc_policy(size_t alloc_sz)
+{
+  void* ret = NULL;
+  size_t align = 4096;
+  if (polybench_alloc_mode == POLYBENCH_ALLOC_HUGE_PAGES)
+    align = POLYBENCH_HUGE_PAGE_SIZE;
+  /* Skip one alignment unit to make room for the original pointer,
+     then shift each array differently so that their bases do not
+     compete for the same cache sets. */
+  size_t offset = (polybench_alloc_count * polybench_alloc_offset) % align;
+  offset += align;
+  size_t sz = (offset + alloc_sz + align - 1) / align;
+  sz *= align;
+  int err = posix_memalign (&ret, align, sz);
+  if (! ret || err)
+    {
+      fprintf (stderr, "[PolyBench] posix_memalign: cannot allocate memory");
+      exit (1);
+    }
+#ifdef MADV_HUGEPAGE
+  /* Only a hint, transparent huge pages may be disabled. */
+  if (polybench_alloc_mode == POLYBENCH_ALLOC_HUGE_PAGES)
+    madvise (ret, sz, MADV_HUGEPAGE);
+#endif
+  void* user_view = (char*) ret + offset;
+  ((void**) user_view)[-1] = ret;
+
+  return user_view;
+}
+
+
 static
 void*
 xmalloc(size_t alloc_sz)
 {
+  if (polybench_alloc_mode != POLYBENCH_ALLOC_DEFAULT)
+    return xmalloc_policy (alloc_sz);
+
   void* ret = NULL;
   /* By default, post-pad the arrays. Safe behavior, but likely useless. */
   polybench_inter_array_padding_sz += POLYBENCH_INTER_ARRAY_PADDING_FACTOR;
@@ -544,8 +722,27 @@ xmalloc(size_t alloc_sz)
 }
 
 
+void polybench_set_alloc_policy(int mode, size_t inter_array_offset)
+{
+  if (polybench_alloc_count != 0)
+    {
+      fprintf (stderr, "[PolyBench] allocation policy must be set before allocating\n");
+      exit (1);
+    }
+  polybench_alloc_mode = mode;
+  /* Keep the arrays cache line aligned. */
+  polybench_alloc_offset = (inter_array_offset + 63) / 64;
+  polybench_alloc_offset *= 64;
+}
+
+
 void polybench_free_data(void* ptr)
 {
+  if (polybench_alloc_mode != POLYBENCH_ALLOC_DEFAULT)
+    {
+      free (((void**) ptr)[-1]);
+      return;
+    }
 #ifdef POLYBENCH_ENABLE_INTARRAY_PAD
   free_data_from_alloc_table (ptr);
 #else
@@ -564,6 +761,602 @@ void* polybench_alloc_data(unsigned long long int n, int elt_size)
   size_t val = n;
   val *= elt_size;
   void* ret = xmalloc (val);
+  /* Counted in every mode, the policy cannot change once arrays exist. */
+  polybench_alloc_count++;
+
+  return ret;
+}
+
+
+void polybench_reserve_scratch(size_t size)
+{
+  if (polybench_scratch_arena != NULL)
+    {
+      fprintf (stderr, "[PolyBench] scratch arena already reserved\n");
+      exit (1);
+    }
+  /* Round up to full huge pages. */
+  size_t sz = (size + POLYBENCH_HUGE_PAGE_SIZE - 1) / POLYBENCH_HUGE_PAGE_SIZE;
+  sz *= POLYBENCH_HUGE_PAGE_SIZE;
+  if (sz == 0)
+    sz = POLYBENCH_HUGE_PAGE_SIZE;
+  void* ret = NULL;
+  int err = posix_memalign (&ret, POLYBENCH_HUGE_PAGE_SIZE, sz);
+  if (! ret || err)
+    {
+      fprintf (stderr, "[PolyBench] posix_memalign: cannot allocate scratch arena");
+      exit (1);
+    }
+#ifdef MADV_HUGEPAGE
+  /* Only a hint, transparent huge pages may be disabled. */
+  madvise (ret, sz, MADV_HUGEPAGE);
+#endif
+  polybench_scratch_arena = (char*) ret;
+  polybench_scratch_size = sz;
+  polybench_scratch_used = 0;
+}
+
+
+void* polybench_alloc_scratch(unsigned long long int n, int elt_size)
+{
+  size_t val = n;
+  val *= elt_size;
+  val = (val + POLYBENCH_SCRATCH_ALIGNMENT - 1) / POLYBENCH_SCRATCH_ALIGNMENT;
+  val *= POLYBENCH_SCRATCH_ALIGNMENT;
+  if (polybench_scratch_arena == NULL ||
+      polybench_scratch_used + val > polybench_scratch_size)
+    {
+      fprintf (stderr, "[PolyBench] scratch arena exhausted\n");
+      exit (1);
+    }
+  void* ret = polybench_scratch_arena + polybench_scratch_used;
+  polybench_scratch_used += val;
 
   return ret;
 }
+
+
+void polybench_release_scratch()
+{
+  free (polybench_scratch_arena);
+  polybench_scratch_arena = NULL;
+  polybench_scratch_size = 0;
+  polybench_scratch_used = 0;
+}
+
+
+void polybench_numa_interleave()
+{
+#ifdef SYS_set_mempolicy
+  /* MPOL_INTERLEAVE over all nodes present, without depending on
+     libnuma. Applies to all pages faulted in afterwards. */
+  unsigned long mask[POLYBENCH_MAX_NUMA_NODES / (8 * sizeof(unsigned long))];
+  unsigned long maxnode = 0;
+  char path[64];
+  int node;
+  memset (mask, 0, sizeof(mask));
+  for (node = 0; node < POLYBENCH_MAX_NUMA_NODES; ++node)
+    {
+      snprintf (path, sizeof(path), "/sys/devices/system/node/node%d", node);
+      if (access (path, F_OK) != 0)
+	continue;
+      mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+      maxnode = node + 2;
+    }
+  if (maxnode == 0)
+    return;
+  if (syscall (SYS_set_mempolicy, 3 /* MPOL_INTERLEAVE */, mask, maxnode) != 0)
+    fprintf (stderr, "[PolyBench] set_mempolicy: cannot interleave memory\n");
+#endif
+}
+
+
+void polybench_first_touch(void* ptr, size_t size)
+{
+  /* Fault the pages in with the static schedule of the kernel's
+     parallel loops, so they land on the node of the thread using them. */
+  char* data = (char*) ptr;
+  long page = sysconf (_SC_PAGESIZE);
+  long i;
+  long n = (long) ((size + page - 1) / page);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) private(i)
+#endif
+  for (i = 0; i < n; i++)
+    data[i * page] = 0;
+}
+
+
+/* Thread count of the BLAS library, 0 leaves the library default. The
+   harness sets POLYBENCH_BLAS_THREADS for every backend, the generated
+   code hands it to the thread-control call of the backend. */
+int polybench_blas_threads()
+{
+  const char* value = getenv ("POLYBENCH_BLAS_THREADS");
+  if (value == NULL || *value == '\0')
+    return 0;
+  return atoi (value);
+}
+
+
+
+#ifdef SYS_sched_getaffinity
+static
+long topology_id(int cpu, const char* name)
+{
+  char path[96];
+  long id = -1;
+  FILE* file;
+  snprintf (path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, name);
+  file = fopen (path, "r");
+  if (file == NULL)
+    return -1;
+  if (fscanf (file, "%ld", &id) != 1)
+    id = -1;
+  fclose (file);
+  return id;
+}
+#endif
+
+
+/* Physical cores among the CPUs the process may run on. The hyperthreads
+   of a core share its floating point units, each core counts once. */
+int polybench_physical_cores()
+{
+#ifdef SYS_sched_getaffinity
+  unsigned long mask[POLYBENCH_MAX_CPUS / (8 * sizeof(unsigned long))];
+  static long cores[POLYBENCH_MAX_CPUS];
+  int bits = 8 * sizeof(unsigned long);
+  int nb_cores = 0;
+  int cpu, i;
+  long size = syscall (SYS_sched_getaffinity, 0, sizeof(mask), mask);
+  if (size <= 0)
+    return (int) sysconf (_SC_NPROCESSORS_ONLN);
+  for (cpu = 0; cpu < size * 8; ++cpu)
+    {
+      long package, core, key;
+      if (! ((mask[cpu / bits] >> (cpu % bits)) & 1))
+	continue;
+      package = topology_id (cpu, "physical_package_id");
+      core = topology_id (cpu, "core_id");
+      /* Without topology information every CPU is a core of its own. */
+      key = package < 0 || core < 0 ? -1 - cpu : package * 65536 + core;
+      for (i = 0; i < nb_cores && cores[i] != key; ++i)
+	;
+      if (i == nb_cores)
+	cores[nb_cores++] = key;
+    }
+  return nb_cores > 0 ? nb_cores : 1;
+#else
+  return (int) sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+}
+
+
+/* Thread budget of the kernel, POLYBENCH_THREADS or one thread per
+   physical core. The generated code splits it between its regions. */
+int polybench_threads()
+{
+  const char* value = getenv ("POLYBENCH_THREADS");
+  if (value != NULL && *value != '\0' && atoi (value) > 0)
+    return atoi (value);
+  return polybench_physical_cores ();
+}
+
+static
+int reporting_run()
+{
+  /* With repetitions, report the accumulation over all measured runs once. */
+  return polybench_nb_runs == 0 ||
+    polybench_run_index == polybench_nb_warmup + polybench_nb_runs;
+}
+
+
+static
+double region_clock()
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+
+#ifdef __linux__
+static
+int open_counter(unsigned int type, unsigned long long config)
+{
+  struct perf_event_attr attr;
+  memset (&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.inherit = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return (int) syscall (SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+
+static
+void read_counters(struct polybench_perf_reading* readings)
+{
+  int i;
+  for (i = 0; i < POLYBENCH_NB_PERF_COUNTERS; ++i)
+    {
+      memset (&readings[i], 0, sizeof(readings[i]));
+      if (polybench_perf_fds[i] != -1 &&
+	  read (polybench_perf_fds[i], &readings[i], sizeof(readings[i])) != sizeof(readings[i]))
+	memset (&readings[i], 0, sizeof(readings[i]));
+    }
+}
+
+
+/* Events of an interval, scaled up if the counter was multiplexed. */
+static
+unsigned long long counter_delta(const struct polybench_perf_reading* start,
+				 const struct polybench_perf_reading* end)
+{
+  unsigned long long value = end->value - start->value;
+  unsigned long long enabled = end->enabled - start->enabled;
+  unsigned long long running = end->running - start->running;
+  if (running == 0 || running >= enabled)
+    return value;
+  polybench_perf_multiplexed = 1;
+  return (unsigned long long) ((double) value * enabled / running);
+}
+
+
+void polybench_counters_init()
+{
+#ifdef __linux__
+  /* Must run before the first parallel region, only threads created
+     afterwards inherit the counters. */
+  polybench_perf_fds[POLYBENCH_PERF_CYCLES] =
+    open_counter (PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+  polybench_perf_fds[POLYBENCH_PERF_INSTRUCTIONS] =
+    open_counter (PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+  polybench_perf_fds[POLYBENCH_PERF_LLC_MISSES] =
+    open_counter (PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+  /* There are no generic events for floating point operations and
+     memory traffic, they are given as raw event codes of the CPU, e.g.
+     0x01c7 for scalar double FP_ARITH_INST_RETIRED on Intel. */
+  const char* fp_event = getenv ("POLYBENCH_PERF_FP_EVENT");
+  if (fp_event)
+    polybench_perf_fds[POLYBENCH_PERF_FP_OPS] =
+      open_counter (PERF_TYPE_RAW, strtoull (fp_event, NULL, 0));
+  const char* mem_event = getenv ("POLYBENCH_PERF_MEM_EVENT");
+  if (mem_event)
+    polybench_perf_fds[POLYBENCH_PERF_MEM_EVENT] =
+      open_counter (PERF_TYPE_RAW, strtoull (mem_event, NULL, 0));
+  int i;
+  for (i = 0; i < POLYBENCH_NB_PERF_COUNTERS; ++i)
+    if (polybench_perf_fds[i] != -1)
+      polybench_perf_enabled = 1;
+  if (! polybench_perf_enabled)
+    fprintf (stderr, "[PolyBench] perf_event_open: cannot open counters, check /proc/sys/kernel/perf_event_paranoid\n");
+#else
+  fprintf (stderr, "[PolyBench] hardware counters require Linux\n");
+#endif
+}
+
+
+void polybench_counters_start()
+{
+  read_counters (polybench_perf_start);
+  polybench_perf_t_start = region_clock ();
+}
+
+
+void polybench_counters_stop()
+{
+  struct polybench_perf_reading readings[POLYBENCH_NB_PERF_COUNTERS];
+  polybench_perf_t_total += region_clock () - polybench_perf_t_start;
+  read_counters (readings);
+  int i;
+  for (i = 0; i < POLYBENCH_NB_PERF_COUNTERS; ++i)
+    polybench_perf_total[i] += counter_delta (&polybench_perf_start[i], &readings[i]);
+}
+
+
+void polybench_counters_print()
+{
+  if (! polybench_perf_enabled || ! reporting_run ())
+    return;
+  /* Stderr keeps stdout to the single number of polybench_timer_print. */
+  if (polybench_perf_multiplexed)
+    fprintf (stderr, "[PolyBench] counters were multiplexed, values are scaled estimates\n");
+  int i;
+  for (i = 0; i < POLYBENCH_NB_PERF_COUNTERS; ++i)
+    if (polybench_perf_fds[i] != -1)
+      fprintf (stderr, "%s %llu\n", polybench_perf_names[i], polybench_perf_total[i]);
+  if (polybench_perf_fds[POLYBENCH_PERF_CYCLES] != -1 &&
+      polybench_perf_fds[POLYBENCH_PERF_INSTRUCTIONS] != -1 &&
+      polybench_perf_total[POLYBENCH_PERF_CYCLES] > 0)
+    fprintf (stderr, "ipc %0.3f\n",
+	     (double) polybench_perf_total[POLYBENCH_PERF_INSTRUCTIONS] /
+	     polybench_perf_total[POLYBENCH_PERF_CYCLES]);
+  /* Every last level cache miss moves one line from memory. */
+  if (polybench_perf_fds[POLYBENCH_PERF_LLC_MISSES] != -1 && polybench_perf_t_total > 0)
+    fprintf (stderr, "llc_miss_bandwidth_gbs %0.3f\n",
+	     polybench_perf_total[POLYBENCH_PERF_LLC_MISSES] * 64.0 /
+	     polybench_perf_t_total / 1.0e9);
+}
+
+
+void polybench_region_start(const char* name)
+{
+  int id;
+  for (id = 0; id < polybench_nb_regions; ++id)
+    if (strcmp (polybench_regions[id].name, name) == 0)
+      break;
+  if (id == polybench_nb_regions)
+    {
+      if (polybench_nb_regions == POLYBENCH_MAX_REGIONS)
+	{
+	  fprintf (stderr, "[PolyBench] too many timing regions\n");
+	  exit (1);
+	}
+      polybench_regions[id].name = name;
+      polybench_regions[id].parent = polybench_region_depth > 0 ?
+	polybench_region_stack[polybench_region_depth - 1] : -1;
+      polybench_regions[id].calls = 0;
+      polybench_regions[id].total = 0.0;
+      memset (polybench_regions[id].counters, 0, sizeof(polybench_regions[id].counters));
+      polybench_nb_regions++;
+    }
+  if (polybench_region_depth == POLYBENCH_MAX_REGIONS)
+    {
+      fprintf (stderr, "[PolyBench] timing regions nested too deeply\n");
+      exit (1);
+    }
+  polybench_region_stack[polybench_region_depth++] = id;
+  read_counters (polybench_regions[id].counters_start);
+  polybench_regions[id].start = region_clock ();
+}
+
+
+void polybench_region_stop(const char* name)
+{
+  double now = region_clock ();
+  struct polybench_perf_reading readings[POLYBENCH_NB_PERF_COUNTERS];
+  read_counters (readings);
+  if (polybench_region_depth == 0)
+    {
+      fprintf (stderr, "[PolyBench] timing region %s stopped but not started\n", name);
+      exit (1);
+    }
+  int id = polybench_region_stack[--polybench_region_depth];
+  if (strcmp (polybench_regions[id].name, name) != 0)
+    {
+      fprintf (stderr, "[PolyBench] timing region %s stopped inside %s\n",
+	       name, polybench_regions[id].name);
+      exit (1);
+    }
+  polybench_regions[id].total += now - polybench_regions[id].start;
+  polybench_regions[id].calls++;
+  int i;
+  for (i = 0; i < POLYBENCH_NB_PERF_COUNTERS; ++i)
+    polybench_regions[id].counters[i] +=
+      counter_delta (&polybench_regions[id].counters_start[i], &readings[i]);
+}
+
+
+static
+void print_regions(int parent, int depth, double parent_total)
+{
+  int id;
+  for (id = 0; id < polybench_nb_regions; ++id)
+    {
+      if (polybench_regions[id].parent != parent)
+	continue;
+      double share = parent_total > 0 ?
+	100.0 * polybench_regions[id].total / parent_total : 100.0;
+      fprintf (stderr, "%*s%-*s %12.6f %10lu %6.1f%%", 2 * depth, "",
+	       40 - 2 * depth, polybench_regions[id].name,
+	       polybench_regions[id].total, polybench_regions[id].calls, share);
+      int i;
+      for (i = 0; i < POLYBENCH_NB_PERF_COUNTERS; ++i)
+	if (polybench_perf_fds[i] != -1)
+	  fprintf (stderr, " %s=%llu", polybench_perf_names[i],
+		   polybench_regions[id].counters[i]);
+      fprintf (stderr, "\n");
+      print_regions (id, depth + 1, polybench_regions[id].total);
+    }
+}
+
+
+void polybench_region_print()
+{
+  if (! reporting_run ())
+    return;
+  /* Stderr keeps stdout to the single number of polybench_timer_print. */
+  double total = 0.0;
+  int id;
+  for (id = 0; id < polybench_nb_regions; ++id)
+    if (polybench_regions[id].parent == -1)
+      total += polybench_regions[id].total;
+  if (polybench_perf_multiplexed)
+    fprintf (stderr, "[PolyBench] counters were multiplexed, values are scaled estimates\n");
+  fprintf (stderr, "%-40s %12s %10s %7s\n", "region", "time (s)", "calls", "share");
+  print_regions (-1, 0, total);
+}
+
+
+void polybench_set_repetitions(int runs, int warmup, int flush_cache)
+{
+  polybench_nb_runs = runs;
+  polybench_nb_warmup = warmup;
+  polybench_flush_enabled = flush_cache;
+  polybench_run_index = 0;
+  polybench_nb_samples = 0;
+  free (polybench_samples);
+  polybench_samples = (double*) calloc (runs > 0 ? runs : 1, sizeof(double));
+  assert (polybench_samples != NULL);
+}
+
+
+void polybench_next_run()
+{
+  polybench_run_index++;
+  if (polybench_run_index != polybench_nb_warmup + 1)
+    return;
+  /* Forget what the warmup runs accumulated. */
+  int id;
+  for (id = 0; id < polybench_nb_regions; ++id)
+    {
+      polybench_regions[id].calls = 0;
+      polybench_regions[id].total = 0.0;
+      memset (polybench_regions[id].counters, 0, sizeof(polybench_regions[id].counters));
+    }
+  memset (polybench_perf_total, 0, sizeof(polybench_perf_total));
+  polybench_perf_t_total = 0.0;
+  polybench_perf_multiplexed = 0;
+}
+
+
+static
+int compare_samples(const void* a, const void* b)
+{
+  double x = *(const double*) a;
+  double y = *(const double*) b;
+  return (x > y) - (x < y);
+}
+
+
+/* The cycle-accurate timer counts TSC ticks, whose frequency is not
+   known here, so its samples are reported in cycles. */
+#ifndef POLYBENCH_CYCLE_ACCURATE_TIMER
+# define POLYBENCH_SAMPLE_UNIT "seconds"
+# define POLYBENCH_SAMPLE_FORMAT "%0.6f"
+#else
+# define POLYBENCH_SAMPLE_UNIT "cycles"
+# define POLYBENCH_SAMPLE_FORMAT "%0.0f"
+#endif
+
+void polybench_report_repetitions()
+{
+  int n = polybench_nb_samples;
+  double* sorted = (double*) malloc ((n > 0 ? n : 1) * sizeof(double));
+  assert (sorted != NULL);
+  memcpy (sorted, polybench_samples, n * sizeof(double));
+  qsort (sorted, n, sizeof(double), compare_samples);
+
+  double mean = 0.0, var = 0.0;
+  int i;
+  for (i = 0; i < n; ++i)
+    mean += sorted[i];
+  mean = n > 0 ? mean / n : 0.0;
+  for (i = 0; i < n; ++i)
+    var += (sorted[i] - mean) * (sorted[i] - mean);
+  var = n > 1 ? var / (n - 1) : 0.0;
+
+  printf ("{\"runs\": %d, \"warmup\": %d, \"flush_cache\": %s, \"unit\": \""
+	  POLYBENCH_SAMPLE_UNIT "\"", n,
+	  polybench_nb_warmup, polybench_flush_enabled ? "true" : "false");
+  if (n > 0)
+    {
+      double median = n % 2 ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+      /* Nearest rank. */
+      int p90 = (int) ceil (0.9 * n) - 1;
+      printf (", \"min\": " POLYBENCH_SAMPLE_FORMAT ", \"median\": " POLYBENCH_SAMPLE_FORMAT
+	      ", \"p90\": " POLYBENCH_SAMPLE_FORMAT ", \"max\": " POLYBENCH_SAMPLE_FORMAT,
+	      sorted[0], median, sorted[p90], sorted[n - 1]);
+      printf (", \"mean\": " POLYBENCH_SAMPLE_FORMAT ", \"cv\": %0.6f", mean,
+	      mean > 0 ? sqrt (var) / mean : 0.0);
+#ifndef POLYBENCH_CYCLE_ACCURATE_TIMER
+      if (polybench_program_total_flops > 0 && median > 0)
+	printf (", \"gflops\": %0.3f", polybench_program_total_flops / median / 1.0e9);
+      if (polybench_program_total_bytes > 0 && median > 0)
+	printf (", \"gbs\": %0.3f", polybench_program_total_bytes / median / 1.0e9);
+#endif
+    }
+  printf (", \"samples\": [");
+  for (i = 0; i < n; ++i)
+    printf ("%s" POLYBENCH_SAMPLE_FORMAT, i > 0 ? ", " : "", polybench_samples[i]);
+  printf ("]}\n");
+  free (sorted);
+}
+
+
+void polybench_dump_start()
+{
+  const char* path = getenv ("POLYBENCH_DUMP_FILE");
+  if (path == NULL || *path == '\0')
+    path = "polybench.dump";
+  polybench_dump_file = fopen (path, "wb");
+  if (polybench_dump_file == NULL)
+    {
+      fprintf (stderr, "[PolyBench] cannot open dump file %s\n", path);
+      exit (1);
+    }
+  fwrite (POLYBENCH_DUMP_MAGIC, 1, strlen (POLYBENCH_DUMP_MAGIC), polybench_dump_file);
+}
+
+
+void polybench_dump_finish()
+{
+  fclose (polybench_dump_file);
+  polybench_dump_file = NULL;
+  free (polybench_dump_values);
+  polybench_dump_values = NULL;
+  polybench_dump_capacity = 0;
+}
+
+
+/*
+ * Every array is one record in native byte order:
+ *   uint32 name length, name, uint32 number of dimensions,
+ *   uint64 extent of each dimension, uint64 count, double values[count]
+ * Arrays without a shape are written as one dimension of count elements.
+ *
+ */
+void polybench_dump_begin()
+{
+  polybench_dump_count = 0;
+  polybench_dump_nb_dims = 0;
+}
+
+
+void polybench_dump_shape(int nb_dims, ...)
+{
+  va_list args;
+  int i;
+  assert (nb_dims <= POLYBENCH_DUMP_MAX_DIMS);
+  va_start (args, nb_dims);
+  for (i = 0; i < nb_dims; ++i)
+    polybench_dump_dims[i] = (uint64_t) va_arg (args, int);
+  va_end (args);
+  polybench_dump_nb_dims = nb_dims;
+}
+
+
+void polybench_dump_value(double value)
+{
+  if (polybench_dump_count == polybench_dump_capacity)
+    {
+      polybench_dump_capacity = polybench_dump_capacity ? 2 * polybench_dump_capacity : 4096;
+      polybench_dump_values = (double*) realloc (polybench_dump_values,
+						 polybench_dump_capacity * sizeof(double));
+      assert (polybench_dump_values != NULL);
+    }
+  polybench_dump_values[polybench_dump_count++] = value;
+}
+
+
+void polybench_dump_end(const char* name)
+{
+  uint32_t name_length = strlen (name);
+  if (polybench_dump_nb_dims == 0)
+    {
+      polybench_dump_nb_dims = 1;
+      polybench_dump_dims[0] = polybench_dump_count;
+    }
+  fwrite (&name_length, sizeof(name_length), 1, polybench_dump_file);
+  fwrite (name, 1, name_length, polybench_dump_file);
+  fwrite (&polybench_dump_nb_dims, sizeof(polybench_dump_nb_dims), 1, polybench_dump_file);
+  fwrite (polybench_dump_dims, sizeof(uint64_t), polybench_dump_nb_dims, polybench_dump_file);
+  fwrite (&polybench_dump_count, sizeof(polybench_dump_count), 1, polybench_dump_file);
+  fwrite (polybench_dump_values, sizeof(double), polybench_dump_count, polybench_dump_file);
+}
@@ -153,6 +153,34 @@
   type POLYBENCH_5D_F(POLYBENCH_DECL_VAR(var), dim1, dim2, dim3, dim4, dim5, ddim1, ddim2, ddim3, ddim4, ddim5);
 # endif
 
+/* Macros for temporaries living in the scratch arena. The arena must be
+   reserved with polybench_reserve_scratch before, using the sum of
+   POLYBENCH_SCRATCH_SIZE over all temporaries, and is released at once
+   with polybench_release_scratch. */
+# ifndef POLYBENCH_SCRATCH_ALIGNMENT
+#  define POLYBENCH_SCRATCH_ALIGNMENT 64
+# endif
+# define POLYBENCH_SCRATCH_SIZE(n, type) \
+  ((((size_t)(n) * sizeof(type) + POLYBENCH_SCRATCH_ALIGNMENT - 1) / POLYBENCH_SCRATCH_ALIGNMENT) * POLYBENCH_SCRATCH_ALIGNMENT)
+# ifndef POLYBENCH_STACK_ARRAYS
+#  define POLYBENCH_1D_SCRATCH_DECL(var, type, dim1, ddim1)		\
+  type POLYBENCH_1D_F(POLYBENCH_DECL_VAR(var), dim1, ddim1); \
+  var = (type(*)[POLYBENCH_C99_SELECT(dim1, ddim1) + POLYBENCH_PADDING_FACTOR])polybench_alloc_scratch (POLYBENCH_C99_SELECT(dim1, ddim1) + POLYBENCH_PADDING_FACTOR, sizeof(type));
+#  define POLYBENCH_2D_SCRATCH_DECL(var, type, dim1, dim2, ddim1, ddim2)	\
+  type POLYBENCH_2D_F(POLYBENCH_DECL_VAR(var), dim1, dim2, ddim1, ddim2); \
+  var = (type(*)[POLYBENCH_C99_SELECT(dim1, ddim1) + POLYBENCH_PADDING_FACTOR][POLYBENCH_C99_SELECT(dim2, ddim2) + POLYBENCH_PADDING_FACTOR])polybench_alloc_scratch ((POLYBENCH_C99_SELECT(dim1, ddim1) + POLYBENCH_PADDING_FACTOR) * (POLYBENCH_C99_SELECT(dim2, ddim2) + POLYBENCH_PADDING_FACTOR), sizeof(type));
+#  define POLYBENCH_3D_SCRATCH_DECL(var, type, dim1, dim2, dim3, ddim1, ddim2, ddim3) \
+  type POLYBENCH_3D_F(POLYBENCH_DECL_VAR(var), dim1, dim2, dim3, ddim1, ddim2, ddim3); \
+  var = (type(*)[POLYBENCH_C99_SELECT(dim1, ddim1) + POLYBENCH_PADDING_FACTOR][POLYBENCH_C99_SELECT(dim2, ddim2) + POLYBENCH_PADDING_FACTOR][POLYBENCH_C99_SELECT(dim3, ddim3) + POLYBENCH_PADDING_FACTOR])polybench_alloc_scratch ((POLYBENCH_C99_SELECT(dim1, ddim1) + POLYBENCH_PADDING_FACTOR) * (POLYBENCH_C99_SELECT(dim2, ddim2) + POLYBENCH_PADDING_FACTOR) * (POLYBENCH_C99_SELECT(dim3, ddim3) + POLYBENCH_PADDING_FACTOR), sizeof(type));
+# else
+#  define POLYBENCH_1D_SCRATCH_DECL(var, type, dim1, ddim1)		\
+  POLYBENCH_1D_ARRAY_DECL(var, type, dim1, ddim1)
+#  define POLYBENCH_2D_SCRATCH_DECL(var, type, dim1, dim2, ddim1, ddim2)	\
+  POLYBENCH_2D_ARRAY_DECL(var, type, dim1, dim2, ddim1, ddim2)
+#  define POLYBENCH_3D_SCRATCH_DECL(var, type, dim1, dim2, dim3, ddim1, ddim2, ddim3) \
+  POLYBENCH_3D_ARRAY_DECL(var, type, dim1, dim2, dim3, ddim1, ddim2, ddim3)
+# endif
+
 
 /* Dead-code elimination macros. Use argc/argv for the run-time check. */
 # ifndef POLYBENCH_DUMP_ARRAYS
@@ -162,10 +190,26 @@
 # endif
 
 #define POLYBENCH_DUMP_TARGET stderr
-#define POLYBENCH_DUMP_START    fprintf(POLYBENCH_DUMP_TARGET, "==BEGIN DUMP_ARRAYS==\n")
-#define POLYBENCH_DUMP_FINISH   fprintf(POLYBENCH_DUMP_TARGET, "==END   DUMP_ARRAYS==\n")
-#define POLYBENCH_DUMP_BEGIN(s) fprintf(POLYBENCH_DUMP_TARGET, "begin dump: %s", s)
-#define POLYBENCH_DUMP_END(s)   fprintf(POLYBENCH_DUMP_TARGET, "\nend   dump: %s\n", s)
+/* Binary dumps write the live-out data with full precision to the file
+   named by POLYBENCH_DUMP_FILE (default polybench.dump), see
+   polybench_dump_begin for the format. */
+# ifdef POLYBENCH_DUMP_BINARY
+#  define POLYBENCH_DUMP_START    polybench_dump_start()
+#  define POLYBENCH_DUMP_FINISH   polybench_dump_finish()
+#  define POLYBENCH_DUMP_BEGIN(s) polybench_dump_begin()
+#  define POLYBENCH_DUMP_END(s)   polybench_dump_end(s)
+#  define POLYBENCH_DUMP_SHAPE(...) polybench_dump_shape(__VA_ARGS__)
+#  define POLYBENCH_DUMP_VALUE(x) polybench_dump_value((double) (x))
+#  define POLYBENCH_DUMP_NEWLINE  ((void) 0)
+# else
+#  define POLYBENCH_DUMP_START    fprintf(POLYBENCH_DUMP_TARGET, "==BEGIN DUMP_ARRAYS==\n")
+#  define POLYBENCH_DUMP_FINISH   fprintf(POLYBENCH_DUMP_TARGET, "==END   DUMP_ARRAYS==\n")
+#  define POLYBENCH_DUMP_BEGIN(s) fprintf(POLYBENCH_DUMP_TARGET, "begin dump: %s", s)
+#  define POLYBENCH_DUMP_END(s)   fprintf(POLYBENCH_DUMP_TARGET, "\nend   dump: %s\n", s)
+#  define POLYBENCH_DUMP_SHAPE(...) ((void) 0)
+#  define POLYBENCH_DUMP_VALUE(x) fprintf(POLYBENCH_DUMP_TARGET, DATA_PRINTF_MODIFIER, x)
+#  define POLYBENCH_DUMP_NEWLINE  fprintf(POLYBENCH_DUMP_TARGET, "\n")
+# endif
 
 # define polybench_prevent_dce(func)		\
   POLYBENCH_DCE_ONLY_CODE			\
@@ -204,6 +248,13 @@ extern const unsigned int polybench_papi_eventlist[];
 # endif
 
 
+/* Work of the SCoP. With timing enabled, the achieved GFLOP/s, GB/s
+   and the arithmetic intensity are reported on stderr. */
+extern double polybench_program_total_flops;
+extern double polybench_program_total_bytes;
+# define polybench_set_program_flops(value) polybench_program_total_flops = (value)
+# define polybench_set_program_bytes(value) polybench_program_total_bytes = (value)
+
 /* Timing support. */
 # if defined(POLYBENCH_TIME) || defined(POLYBENCH_GFLOPS)
 #  undef polybench_start_instruments
@@ -212,12 +263,33 @@ extern const unsigned int polybench_papi_eventlist[];
 #  define polybench_start_instruments polybench_timer_start();
 #  define polybench_stop_instruments polybench_timer_stop();
 #  define polybench_print_instruments polybench_timer_print();
-extern double polybench_program_total_flops;
 extern void polybench_timer_start();
 extern void polybench_timer_stop();
 extern void polybench_timer_print();
 # endif
 
+/* Named timing regions, inserted by the optimizer around the loop
+   nests and library calls of the SCoP. Regions entered while another
+   one is open are reported below it. */
+extern void polybench_region_start(const char* name);
+extern void polybench_region_stop(const char* name);
+extern void polybench_region_print();
+
+/* In-process repetitions. Every run re-executes the kernel including the
+   initialization in front of its timed region, the samples of the
+   measured runs are reported as JSON on stdout. */
+extern void polybench_set_repetitions(int runs, int warmup, int flush_cache);
+extern void polybench_next_run();
+extern void polybench_report_repetitions();
+
+/* Hardware counters of the SCoP through perf_event_open, see
+   polybench.c. polybench_counters_init must be called first in main.
+   Timing regions report the counters as well once they are open. */
+extern void polybench_counters_init();
+extern void polybench_counters_start();
+extern void polybench_counters_stop();
+extern void polybench_counters_print();
+
 /* PAPI support. */
 # ifdef POLYBENCH_PAPI
 extern int polybench_papi_start_counter(int evid);
@@ -227,9 +299,31 @@ extern void polybench_papi_close();
 extern void polybench_papi_print();
 # endif
 
+/* Allocation policies of polybench_alloc_data. ALIGNED places each array
+   on its own pages, HUGE_PAGES on its own 2M pages and advises the kernel
+   to back them with transparent huge pages. */
+# define POLYBENCH_ALLOC_DEFAULT 0
+# define POLYBENCH_ALLOC_ALIGNED 1
+# define POLYBENCH_ALLOC_HUGE_PAGES 2
+
 /* Function prototypes. */
 extern void* polybench_alloc_data(unsigned long long int n, int elt_size);
 extern void polybench_free_data(void* ptr);
+extern void polybench_set_alloc_policy(int mode, size_t inter_array_offset);
+extern void polybench_reserve_scratch(size_t size);
+extern void* polybench_alloc_scratch(unsigned long long int n, int elt_size);
+extern void polybench_release_scratch();
+extern void polybench_numa_interleave();
+extern void polybench_first_touch(void* ptr, size_t size);
+extern int polybench_blas_threads();
+extern int polybench_physical_cores();
+extern int polybench_threads();
+extern void polybench_dump_start();
+extern void polybench_dump_finish();
+extern void polybench_dump_begin();
+extern void polybench_dump_end(const char* name);
+extern void polybench_dump_shape(int nb_dims, ...);
+extern void polybench_dump_value(double value);
 
 /* PolyBench internal functions that should not be directly called by */
 /* the user, unless when designing customized execution profiling */
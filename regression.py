@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+
+from typing import Any, Optional
+from os import listdir, makedirs, path
+from datetime import datetime, timezone
+from math import erf, sqrt
+from statistics import median
+import hashlib
+import json
+import random
+import subprocess
+
+HISTORY = "history"
+# One-sided significance level of the Mann-Whitney test
+ALPHA = 0.01
+# Slowdowns of the median below this share are noise, whatever the test says
+THRESHOLD = 0.03
+BOOTSTRAP_RESAMPLES = 2000
+# Largest sample sizes of the exact distribution of U
+EXACT_LIMIT = 30
+
+def git_revision() -> str:
+    revision = subprocess.run(["git", "rev-parse", "--short", "HEAD"], capture_output=True).stdout.decode().strip()
+    dirty = subprocess.run(["git", "status", "--porcelain", "--untracked-files=no"], capture_output=True).stdout.decode().strip()
+    if revision == "":
+        revision = "unknown"
+    return f"{revision}-dirty" if dirty != "" else revision
+
+def machine() -> dict[str, Any]:
+    result = {"cpu": "unknown", "cpus": 0, "memory_kb": 0}
+    with open("/proc/cpuinfo", "r") as file:
+        for line in file:
+            if line.startswith("model name"):
+                result["cpu"] = line.split(":", 1)[1].strip()
+            if line.startswith("processor"):
+                result["cpus"] += 1
+    with open("/proc/meminfo", "r") as file:
+        for line in file:
+            if line.startswith("MemTotal"):
+                result["memory_kb"] = int(line.split()[1])
+    return result
+
+def fingerprint(info: dict[str, Any]) -> str:
+    key = f"{info['cpu']}|{info['cpus']}|{info['memory_kb']}"
+    return hashlib.sha1(key.encode()).hexdigest()[:12]
+
+def load(filepath: str) -> dict[str, dict[str, Any]]:
+    if not path.isfile(filepath):
+        print(f"File does not exist: {filepath}")
+        exit(1)
+    with open(filepath, "r") as file:
+        return json.load(file)
+
+def record(versions: list[str]) -> None:
+    info = machine()
+    revision = git_revision()
+    folder = path.join(HISTORY, fingerprint(info), revision)
+    makedirs(folder, exist_ok=True)
+    for version in versions:
+        data = load(f"results/{version}.json")
+        with open(path.join(folder, f"{version}.json"), "w+") as outfile:
+            outfile.write(json.dumps(data, indent=True))
+            outfile.write("\n")
+    meta = {"revision": revision, "date": datetime.now(timezone.utc).isoformat(), "machine": info}
+    with open(path.join(folder, "meta.json"), "w+") as outfile:
+        outfile.write(json.dumps(meta, indent=True))
+        outfile.write("\n")
+    print(f"Recorded {', '.join(versions)} of {revision} in {folder}")
+
+def latest_baseline(version: str, exclude: str) -> Optional[str]:
+    folder = path.join(HISTORY, fingerprint(machine()))
+    if not path.isdir(folder):
+        return None
+    candidates = []
+    for revision in listdir(folder):
+        if revision == exclude or not path.isfile(path.join(folder, revision, f"{version}.json")):
+            continue
+        meta = load(path.join(folder, revision, "meta.json"))
+        candidates.append((meta["date"], revision))
+    return max(candidates)[1] if len(candidates) > 0 else None
+
+def exact_u_distribution(n: int, m: int) -> list[int]:
+    # counts[u] is the number of orderings of n + m distinct values with statistic u
+    counts = [[[1] for _ in range(m + 1)] for _ in range(n + 1)]
+    for i in range(1, n + 1):
+        for j in range(1, m + 1):
+            result = [0] * (i * j + 1)
+            for u, count in enumerate(counts[i - 1][j]):
+                result[u + j] += count
+            for u, count in enumerate(counts[i][j - 1]):
+                result[u] += count
+            counts[i][j] = result
+    return counts[n][m]
+
+def mann_whitney_greater(current: list[float], baseline: list[float]) -> float:
+    """P-value of the one-sided test that the current times are larger than the baseline times."""
+    n, m = len(current), len(baseline)
+    values = sorted([(value, 0) for value in current] + [(value, 1) for value in baseline])
+    ranks = [0.0] * len(values)
+    ties = []
+    i = 0
+    while i < len(values):
+        j = i
+        while j + 1 < len(values) and values[j + 1][0] == values[i][0]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[k] = (i + j) / 2 + 1
+        ties.append(j - i + 1)
+        i = j + 1
+    rank_sum = sum(rank for rank, (_, sample) in zip(ranks, values) if sample == 0)
+    u = rank_sum - n * (n + 1) / 2
+
+    if max(ties) == 1 and n <= EXACT_LIMIT and m <= EXACT_LIMIT:
+        counts = exact_u_distribution(n, m)
+        return sum(counts[int(u):]) / sum(counts)
+    # Normal approximation with tie and continuity correction
+    mu = n * m / 2
+    tie_term = sum(t ** 3 - t for t in ties) / ((n + m) * (n + m - 1))
+    sigma = sqrt(n * m / 12 * ((n + m + 1) - tie_term))
+    if sigma == 0:
+        return 1.0
+    z = (u - mu - 0.5) / sigma
+    return 0.5 * (1 - erf(z / sqrt(2)))
+
+def bootstrap_ratio(current: list[float], baseline: list[float]) -> tuple[float, float]:
+    """95% confidence interval of the ratio of the medians, current over baseline."""
+    generator = random.Random(0)
+    ratios = []
+    for _ in range(BOOTSTRAP_RESAMPLES):
+        current_sample = [generator.choice(current) for _ in current]
+        baseline_sample = [generator.choice(baseline) for _ in baseline]
+        ratios.append(median(current_sample) / median(baseline_sample))
+    ratios.sort()
+    return ratios[int(0.025 * len(ratios))], ratios[int(0.975 * len(ratios)) - 1]
+
+def check(version: str, baseline_revision: Optional[str]) -> int:
+    revision = git_revision()
+    if baseline_revision is None:
+        baseline_revision = latest_baseline(version, revision)
+    if baseline_revision is None:
+        print(f"No baseline of {version} on this machine, record one with: regression.py record {version}")
+        return 0
+    baseline = load(path.join(HISTORY, fingerprint(machine()), baseline_revision, f"{version}.json"))
+    current = load(f"results/{version}.json")
+    print(f"Comparing {version} of {revision} against {baseline_revision}")
+
+    regressions = 0
+    for benchmark in sorted(baseline.keys()):
+        bench = benchmark.split("/")[-1]
+        if not benchmark in current:
+            continue
+        old_status = baseline[benchmark]["status"]
+        new_status = current[benchmark]["status"]
+        if old_status in ["good", "unstable"] and not new_status in ["good", "unstable"]:
+            print(f"* {bench}: status {old_status} -> {new_status}")
+            regressions += 1
+            continue
+        if not new_status in ["good", "unstable"] or not old_status in ["good", "unstable"]:
+            continue
+        new_data = current[benchmark]["data"]
+        old_data = baseline[benchmark]["data"]
+        if len(new_data) == 0 or len(old_data) == 0:
+            continue
+        ratio = median(new_data) / median(old_data)
+        p_value = mann_whitney_greater(new_data, old_data)
+        low, high = bootstrap_ratio(new_data, old_data)
+        slower = p_value < ALPHA and ratio > 1 + THRESHOLD
+        marker = "*" if slower else " "
+        print(f"{marker} {bench}: x{ratio:.3f} [{low:.3f}, {high:.3f}] p={p_value:.4f}")
+        if slower:
+            regressions += 1
+
+    if regressions > 0:
+        print(f"{regressions} significant regression(s)")
+    return regressions
+
+if __name__ == "__main__":
+    from sys import argv
+    if len(argv) < 3 or not argv[1] in ["record", "check"]:
+        print("Usage: regression.py record [versions]")
+        print("       regression.py check [versions] [--baseline revision]")
+        exit(1)
+    baseline_revision = None
+    versions = argv[2:]
+    if "--baseline" in versions:
+        index = versions.index("--baseline")
+        if index + 1 >= len(versions):
+            print("Missing revision after --baseline")
+            exit(1)
+        baseline_revision = versions[index + 1]
+        versions = versions[:index] + versions[index + 2:]
+    if argv[1] == "record":
+        record(versions)
+        exit(0)
+    failed = 0
+    for version in versions:
+        failed += check(version, baseline_revision)
+    exit(1 if failed > 0 else 0)
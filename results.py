@@ -45,8 +45,8 @@ def calculate_data(raw_data: dict[str, dict[str, Any]], raw_data_ref: dict[str,
             result[bench]["max"] = float("nan")
     return result
 
-def print_results(version: str) -> None:
-    raw_data_ref = get_data("ref")
+def print_results(version: str, reference: str = "ref") -> None:
+    raw_data_ref = get_data(reference)
     raw_data = get_data(version)
     data = calculate_data(raw_data, raw_data_ref)
     max_name_len = max(4, max([len(bench) for bench in data.keys()]))
@@ -69,7 +69,7 @@ def print_results(version: str) -> None:
         sum_speedup = 0.0
         num_speedup = 0
         for bench in CATEGORIES[i]:
-            if not isnan(data[bench]["avg"]):
+            if bench in data and not isnan(data[bench]["avg"]):
                 sum_speedup += data[bench]["avg"]
                 num_speedup += 1
         if num_speedup == 0:
@@ -80,7 +80,7 @@ def print_results(version: str) -> None:
 
 if __name__ == "__main__":
     from sys import argv
-    if len(argv) != 2:
-        print("Usage: results.py [json file]")
+    if len(argv) not in [2, 3]:
+        print("Usage: results.py [json file] [reference json file]")
         exit(1)
-    print_results(argv[1])
\ No newline at end of file
+    print_results(*argv[1:])
\ No newline at end of file
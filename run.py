@@ -8,7 +8,7 @@ def get_benchmark_output(exec: str, omp_nthreads: int, mkl_nthreads: int) -> flo
     if not isfile(exec):
         print(f"{exec} does not exist...")
         exit(1)
-    out = subprocess.run(exec, capture_output=True, env=environ.update({"OMP_NUM_THREADS": str(omp_nthreads), "MKL_NUM_THREAD": str(mkl_nthreads)})).stdout.decode()
+    out = subprocess.run(exec, capture_output=True, env=environ.update({"OMP_NUM_THREADS": str(omp_nthreads), "MKL_NUM_THREADS": str(mkl_nthreads), "POLYBENCH_THREADS": str(omp_nthreads), "POLYBENCH_BLAS_THREADS": str(mkl_nthreads)})).stdout.decode()
     try:
         result = float(out.strip())
     except Exception:
@@ -50,6 +50,7 @@ if __name__ == "__main__":
         "linear-algebra/kernels/bicg",
         "linear-algebra/kernels/doitgen",
         "linear-algebra/kernels/mvt",
+        "linear-algebra/solvers/durbin",
         "linear-algebra/solvers/gramschmidt",
         "linear-algebra/solvers/trisolv",
         "medley/deriche",
@@ -0,0 +1,3 @@
+#include "autotuner.h"
+
+int main(int argc, char* argv[]) { return autotune(argc, argv); }
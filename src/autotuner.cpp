@@ -0,0 +1,297 @@
+#include "autotuner.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "benchmarks.h"
+#include "blas_backend.h"
+#include "dump.h"
+#include "process.h"
+#include "tuning.h"
+
+namespace {
+
+// Variants must beat the best configuration by this share, smaller gains are noise
+const double MIN_GAIN = 0.02;
+
+// Lowering orders of MKL3 and BUILTIN, a missing lowering leaves its einsums to the later ones,
+// to Einsum2BLAS (BUILTIN) or to loops (MKL3)
+const std::vector<std::vector<std::string>> LOWERINGS = {{"Gemm", "Symm", "Syrk"},
+                                                        {"Symm", "Syrk", "Gemm"},
+                                                        {"Gemm"}};
+
+double median(std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    size_t n = samples.size();
+    return n % 2 ? samples.at(n / 2) : 0.5 * (samples.at(n / 2 - 1) + samples.at(n / 2));
+}
+
+bool run_step(const std::vector<std::string>& command) {
+    auto output = run_process(command, {}, {});
+    if (output.success) return true;
+    std::cerr << "Failed:";
+    for (auto& arg : command) std::cerr << " " << arg;
+    std::cerr << std::endl << output.err;
+    return false;
+}
+
+std::string optimizer(const TunerOptions& options) {
+    return "./build/optimize_" + implementation_name(options.impl);
+}
+
+// Generates and builds the binary of the benchmark, without a configuration file optimize
+// consults the tuning database
+bool build(const TunerOptions& options, Benchmark* benchmark, bool check,
+           const std::filesystem::path& config_path) {
+    std::vector<std::string> command = {optimizer(options), check ? "check" : "run",
+                                        benchmark->name()};
+    if (!config_path.empty()) {
+        command.push_back("--config");
+        command.push_back(config_path.string());
+    }
+    command.push_back("--tuning-db");
+    command.push_back(options.tuning_database);
+    if (!run_step(command)) return false;
+    return run_step({"make", "bin/" + benchmark->out_path(check)});
+}
+
+bool read_dump(const std::filesystem::path& executable, Dump& dump) {
+    auto output = run_process({executable.string()}, thread_environment(1, 1), {});
+    return output.success && parse_text_dump(output.err, dump);
+}
+
+// Median time of the run binary, empty if the check binary disagrees with the reference
+std::optional<double> evaluate(const TunerOptions& options, Benchmark* benchmark,
+                               const Dump& reference, const PipelineConfig& config,
+                               const std::filesystem::path& config_path) {
+    std::ofstream out(config_path);
+    out << nlohmann::json(config).dump(1) << std::endl;
+    out.close();
+
+    if (!build(options, benchmark, true, config_path)) return std::nullopt;
+    Dump dump;
+    std::vector<ArrayComparison> comparisons;
+    if (!read_dump("bin/" + benchmark->out_path(true), dump) ||
+        !compare_dumps(reference, dump, {TEXT_TOLERANCE, 0.0, 0}, comparisons)) {
+        std::cerr << "  variant does not match the reference" << std::endl;
+        return std::nullopt;
+    }
+
+    if (!build(options, benchmark, false, config_path)) return std::nullopt;
+    auto environment = thread_environment(options.omp_threads, options.mkl_threads);
+    std::vector<double> times;
+    for (size_t rep = 0; rep < options.reps; ++rep) {
+        auto output = run_process({"bin/" + benchmark->out_path(false)}, environment, {});
+        try {
+            if (!output.success) return std::nullopt;
+            times.push_back(std::stod(output.out));
+        } catch (const std::exception&) {
+            return std::nullopt;
+        }
+    }
+    if (times.empty()) return std::nullopt;
+    return median(times);
+}
+
+// Configurations that differ from the current one in a single knob
+std::vector<std::pair<std::string, PipelineConfig>> neighbours(const TunerOptions& options,
+                                                               const PipelineConfig& config,
+                                                               const std::set<size_t>& candidates) {
+    std::vector<std::pair<std::string, PipelineConfig>> result;
+    for (size_t candidate : candidates) {
+        auto variant = config;
+        bool skipped = variant.skipped_einsums.contains(candidate);
+        if (skipped)
+            variant.skipped_einsums.erase(candidate);
+        else
+            variant.skipped_einsums.insert(candidate);
+        result.push_back({(skipped ? "lower einsum " : "skip einsum ") + std::to_string(candidate),
+                          variant});
+    }
+    if (options.impl == MKL3 || options.impl == BUILTIN) {
+        for (auto& lowerings : LOWERINGS) {
+            if (lowerings == config.lowerings) continue;
+            auto variant = config;
+            variant.lowerings = lowerings;
+            std::string description = "lowerings";
+            for (auto& lowering : lowerings) description += " " + lowering;
+            result.push_back({description, variant});
+        }
+    }
+    auto variant = config;
+    variant.loop_fusion = !config.loop_fusion;
+    result.push_back({variant.loop_fusion ? "loop fusion on" : "loop fusion off", variant});
+    variant = config;
+    variant.vectorize = !config.vectorize;
+    result.push_back({variant.vectorize ? "vectorize on" : "vectorize off", variant});
+    if (options.impl != CUBLAS) {
+        variant = config;
+        variant.batch_blas = !config.batch_blas;
+        result.push_back({variant.batch_blas ? "batching on" : "batching off", variant});
+    }
+    return result;
+}
+
+bool tune(const TunerOptions& options, Benchmark* benchmark, TuningDatabase& database) {
+    std::cout << "Tuning " << benchmark->name() << std::endl;
+    if (!run_step({"make", "bin/ref/check/" + benchmark->path()})) return false;
+    Dump reference;
+    if (!read_dump("bin/ref/check/" + benchmark->path(), reference)) {
+        std::cerr << "Could not read the reference dump of " << benchmark->name() << std::endl;
+        return false;
+    }
+
+    auto config_path = std::filesystem::path(options.tuning_database).parent_path() /
+                       (benchmark->name() + ".config.json");
+    PipelineConfig best;
+    auto default_time = evaluate(options, benchmark, reference, best, config_path);
+    if (!default_time) {
+        std::cerr << "The default configuration of " << benchmark->name() << " fails"
+                  << std::endl;
+        return false;
+    }
+    double best_time = *default_time;
+    std::cout << "  default: " << best_time << std::endl;
+
+    // Candidates are numbered by the order of the pipeline, which the check and run SDFGs share
+    std::set<size_t> candidates;
+    try {
+        std::ifstream recipe(std::filesystem::path(benchmark->out_path(false)) / "recipe.json");
+        auto count = nlohmann::json::parse(recipe).at("einsum_candidates").get<size_t>();
+        for (size_t candidate = 0; candidate < count; ++candidate) candidates.insert(candidate);
+    } catch (const std::exception&) {
+        std::cerr << "No einsum candidates in the recipe of " << benchmark->name() << std::endl;
+    }
+
+    // Coordinate descent, every pass changes one knob of the best configuration at a time
+    bool improved = true;
+    while (improved) {
+        improved = false;
+        for (auto& variant : neighbours(options, best, candidates)) {
+            auto time = evaluate(options, benchmark, reference, variant.second, config_path);
+            if (!time) {
+                std::cout << "  " << variant.first << ": failed" << std::endl;
+                continue;
+            }
+            std::cout << "  " << variant.first << ": " << *time << std::endl;
+            if (*time < (1.0 - MIN_GAIN) * best_time) {
+                best = variant.second;
+                best_time = *time;
+                improved = true;
+                break;
+            }
+        }
+    }
+    std::filesystem::remove(config_path);
+
+    auto key = TuningDatabase::key(benchmark->name(), options.impl);
+    database.store(key, best, best_time, *default_time);
+    if (!database.save()) {
+        std::cerr << "Could not write " << options.tuning_database << std::endl;
+        return false;
+    }
+    std::cout << "  best: " << best_time << " (x" << *default_time / best_time << ")" << std::endl;
+
+    // Leave the binaries of the tuned configuration behind, optimize reads it from the database
+    return build(options, benchmark, true, {}) && build(options, benchmark, false, {});
+}
+
+void print_usage() {
+    std::cerr << "Usage: autotune <version> <a,b,...> [options]" << std::endl
+              << "Tunes the EinsumPipeline of the given benchmarks on this machine." << std::endl
+              << "Options:" << std::endl
+              << "  --reps <n>             runs of every variant" << std::endl
+              << "  --omp-threads <n>      OMP_NUM_THREADS of the runs" << std::endl
+              << "  --mkl-threads <n>      MKL_NUM_THREADS of the runs" << std::endl
+              << "  --tuning-db <db.json>  database of tuned configurations" << std::endl
+              << "Available versions:";
+    for (auto impl : BLAS_IMPLEMENTATIONS) std::cerr << " opt_" << blas_backend(impl).name;
+    std::cerr << std::endl;
+}
+
+bool parse_tuner_options(int argc, char* argv[], TunerOptions& options) {
+    if (argc < 3) return false;
+    std::string version(argv[1]);
+    bool found = false;
+    for (auto impl : BLAS_IMPLEMENTATIONS) {
+        if (version != "opt_" + blas_backend(impl).name) continue;
+        options.impl = impl;
+        found = true;
+    }
+    if (!found) {
+        std::cerr << "Unknown version: " << version << std::endl;
+        return false;
+    }
+    std::stringstream stream(argv[2]);
+    std::string benchmark;
+    while (std::getline(stream, benchmark, ',')) {
+        if (!benchmark.empty()) options.benchmarks.push_back(benchmark);
+    }
+    if (options.benchmarks.empty()) return false;
+
+    for (int i = 3; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (i + 1 >= argc) return false;
+        std::string value(argv[++i]);
+        try {
+            if (arg == "--reps") {
+                options.reps = std::stoul(value);
+            } else if (arg == "--omp-threads") {
+                options.omp_threads = std::stoul(value);
+            } else if (arg == "--mkl-threads") {
+                options.mkl_threads = std::stoul(value);
+            } else if (arg == "--tuning-db") {
+                options.tuning_database = value;
+            } else {
+                return false;
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int autotune(int argc, char* argv[]) {
+    TunerOptions options;
+    if (!parse_tuner_options(argc, argv, options)) {
+        print_usage();
+        return 1;
+    }
+    register_benchmarks(options.impl);
+
+    std::vector<Benchmark*> benchmarks;
+    for (auto& name : options.benchmarks) {
+        Benchmark* benchmark = BenchmarkRegistry::instance().get_benchmark(name);
+        if (!benchmark) {
+            std::cerr << "Unknown benchmark: " << name << std::endl
+                      << "Available benchmarks: "
+                      << BenchmarkRegistry::instance().dump_benchmarks() << std::endl;
+            return 1;
+        }
+        benchmarks.push_back(benchmark);
+    }
+
+    auto database_path = std::filesystem::path(options.tuning_database);
+    if (database_path.has_parent_path())
+        std::filesystem::create_directories(database_path.parent_path());
+    TuningDatabase database(database_path);
+    int failures = 0;
+    for (auto* benchmark : benchmarks) {
+        if (!tune(options, benchmark, database)) ++failures;
+    }
+    return failures;
+}
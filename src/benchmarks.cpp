@@ -1,5 +1,12 @@
 #include "benchmarks.h"
 
+#include <symengine/basic.h>
+#include <symengine/eval_double.h>
+#include <symengine/integer.h>
+#include <symengine/parser.h>
+#include <symengine/symbol.h>
+#include <symengine/visitor.h>
+
 #include <cstddef>
 #include <filesystem>
 #include <mutex>
@@ -10,6 +17,8 @@
 #include <utility>
 #include <vector>
 
+#include "blas_backend.h"
+
 Variable::Variable(const std::string name) : type_(Scalar), name_(name), dimensions_() {}
 
 Variable::Variable(const std::string name, const size_t dim1)
@@ -83,7 +92,8 @@ Benchmark::Benchmark(const BLASImplementation impl, const std::string name, cons
                      const std::vector<DatasetSize> dataset_sizes,
                      const std::vector<Variable> variables,
                      const std::vector<size_t> call_variables,
-                     const std::vector<size_t> print_variables, const CodeRegion code_region)
+                     const std::vector<size_t> print_variables, const CodeRegion code_region,
+                     const PerformanceModel performance_model)
     : impl_(impl),
       name_(name),
       path_(path),
@@ -91,7 +101,8 @@ Benchmark::Benchmark(const BLASImplementation impl, const std::string name, cons
       variables_(variables),
       call_variables_(call_variables),
       print_variables_(print_variables),
-      code_region_(code_region) {
+      code_region_(code_region),
+      performance_model_(performance_model) {
     for (auto& variable : variables) {
         for (size_t dim : variable.dimensions()) {
             if (dim >= dataset_sizes.size()) {
@@ -115,10 +126,33 @@ Benchmark::Benchmark(const BLASImplementation impl, const std::string name, cons
                                      " >= " + std::to_string(variables.size()));
         }
     }
+
+    std::unordered_set<std::string> dataset_size_names;
+    for (auto& dataset_size : dataset_sizes) dataset_size_names.insert(dataset_size.name);
+    for (auto& expression : {performance_model.flops, performance_model.elements}) {
+        for (auto& symbol : SymEngine::free_symbols(*SymEngine::parse(expression))) {
+            auto& name = static_cast<const SymEngine::Symbol&>(*symbol).get_name();
+            if (!dataset_size_names.contains(name)) {
+                throw std::runtime_error("Performance model " + expression +
+                                         " references unknown dataset size " + name);
+            }
+        }
+    }
+}
+
+double Benchmark::evaluate(const std::string& expression, bool check) const {
+    SymEngine::map_basic_basic sizes;
+    for (auto& dataset_size : this->dataset_sizes()) {
+        int size = check ? dataset_size.medium_size : dataset_size.extralarge_size;
+        sizes[SymEngine::symbol(dataset_size.name)] = SymEngine::integer(size);
+    }
+    return SymEngine::eval_double(*SymEngine::parse(expression)->subs(sizes));
 }
 
 const std::string& Benchmark::name() const { return this->name_; }
 
+const std::string& Benchmark::path() const { return this->path_; }
+
 std::string Benchmark::json_path(bool check) const {
     if (check)
         return (std::filesystem::path("sdfg_json/check") / (this->path_ + ".json")).string();
@@ -127,14 +161,7 @@ std::string Benchmark::json_path(bool check) const {
 }
 
 std::string Benchmark::out_root_folder() const {
-    switch (this->impl_) {
-        case MKL:
-            return "optimized_mkl";
-        case MKL3:
-            return "optimized_mkl3";
-        case CUBLAS:
-            return "optimized_cublas";
-    }
+    return "optimized_" + blas_backend(this->impl_).name;
 }
 
 std::string Benchmark::source_file_ending() const {
@@ -195,6 +222,16 @@ std::unordered_set<size_t> Benchmark::print_variables_dataset_sizes() const {
 
 const CodeRegion& Benchmark::code_region() const { return this->code_region_; }
 
+const PerformanceModel& Benchmark::performance_model() const { return this->performance_model_; }
+
+double Benchmark::flops(bool check) const {
+    return this->evaluate(this->performance_model_.flops, check);
+}
+
+double Benchmark::elements(bool check) const {
+    return this->evaluate(this->performance_model_.elements, check);
+}
+
 BenchmarkRegistry::~BenchmarkRegistry() {
     for (auto benchmark : this->benchmarks_) {
         delete benchmark.second;
@@ -208,13 +245,15 @@ void BenchmarkRegistry::register_benchmark(const std::string name, const std::st
                                            const std::vector<Variable> variables,
                                            const std::vector<size_t> call_variables,
                                            const std::vector<size_t> print_variables,
-                                           const CodeRegion code_region) {
+                                           const CodeRegion code_region,
+                                           const PerformanceModel performance_model) {
     std::lock_guard<std::mutex> lock(this->mutex_);
     if (this->benchmarks_.contains(name)) {
         throw std::runtime_error("Benchmark already registered with name: " + name);
     }
-    this->benchmarks_[name] = new Benchmark(impl_, name, path, dataset_sizes, variables,
-                                            call_variables, print_variables, code_region);
+    this->benchmarks_[name] =
+        new Benchmark(impl_, name, path, dataset_sizes, variables, call_variables,
+                      print_variables, code_region, performance_model);
 }
 
 Benchmark* BenchmarkRegistry::get_benchmark(const std::string name) {
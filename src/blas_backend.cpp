@@ -0,0 +1,34 @@
+#include "blas_backend.h"
+
+#include <string>
+#include <vector>
+
+const BLASBackend& blas_backend(BLASImplementation impl) {
+    // The reference CBLAS runs sequentially
+    static const BLASBackend mkl = {"mkl", {"mkl.h"}, "mkl_set_num_threads"};
+    static const BLASBackend mkl3 = {"mkl3", {"mkl.h"}, "mkl_set_num_threads"};
+    static const BLASBackend cublas = {"cublas", {"cuda.h", "cublas_v2.h"}, ""};
+    static const BLASBackend openblas = {"openblas", {"cblas.h"}, "openblas_set_num_threads"};
+    static const BLASBackend blis = {"blis", {"blis.h", "cblas.h"}, "bli_thread_set_num_threads"};
+    static const BLASBackend cblas = {"cblas", {"cblas.h"}, ""};
+    static const BLASBackend builtin = {"builtin", {"builtin_blas.h"},
+                                        "builtin_blas_set_num_threads"};
+    switch (impl) {
+        case MKL:
+            return mkl;
+        case MKL3:
+            return mkl3;
+        case CUBLAS:
+            return cublas;
+        case OPENBLAS:
+            return openblas;
+        case BLIS:
+            return blis;
+        case CBLAS:
+            return cblas;
+        case BUILTIN:
+            return builtin;
+        default:
+            return mkl;
+    }
+}
@@ -0,0 +1,59 @@
+#include "blas_batch_dispatcher.h"
+
+#include <sdfg/codegen/dispatchers/node_dispatcher.h>
+#include <sdfg/codegen/dispatchers/sequence_dispatcher.h>
+#include <sdfg/codegen/instrumentation/instrumentation.h>
+#include <sdfg/codegen/language_extension.h>
+#include <sdfg/codegen/utils.h>
+#include <sdfg/structured_control_flow/map.h>
+#include <sdfg/structured_sdfg.h>
+
+#include <string>
+
+namespace sdfg {
+namespace codegen {
+
+BLASBatchMapDispatcher::BLASBatchMapDispatcher(LanguageExtension& language_extension,
+                                               StructuredSDFG& sdfg,
+                                               structured_control_flow::Map& node,
+                                               Instrumentation& instrumentation)
+    : NodeDispatcher(language_extension, sdfg, node, instrumentation), node_(node) {}
+
+void BLASBatchMapDispatcher::dispatch_node(PrettyPrinter& main_stream,
+                                           PrettyPrinter& globals_stream,
+                                           PrettyPrinter& library_stream) {
+    // The loop only records the calls, they run after it in one batch
+    main_stream << "polybench_blas_batch_begin();" << std::endl;
+    for (auto& call : BATCHED_BLAS_CALLS) {
+        main_stream << "#define " << call << " polybench_blas_batch_" << call.substr(6)
+                    << std::endl;
+    }
+
+    main_stream << "for";
+    main_stream << "(";
+    main_stream << this->node_.indvar()->get_name();
+    main_stream << " = ";
+    main_stream << this->language_extension_.expression(this->node_.init());
+    main_stream << ";";
+    main_stream << this->language_extension_.expression(this->node_.condition());
+    main_stream << ";";
+    main_stream << this->node_.indvar()->get_name();
+    main_stream << " = ";
+    main_stream << this->language_extension_.expression(this->node_.update());
+    main_stream << ")" << std::endl;
+    main_stream << "{" << std::endl;
+
+    main_stream.setIndent(main_stream.indent() + 4);
+    SequenceDispatcher dispatcher(this->language_extension_, this->sdfg_, this->node_.root(),
+                                  this->instrumentation_);
+    dispatcher.dispatch(main_stream, globals_stream, library_stream);
+    main_stream.setIndent(main_stream.indent() - 4);
+
+    main_stream << "}" << std::endl;
+
+    for (auto& call : BATCHED_BLAS_CALLS) main_stream << "#undef " << call << std::endl;
+    main_stream << "polybench_blas_batch_flush();" << std::endl;
+}
+
+}  // namespace codegen
+}  // namespace sdfg
@@ -0,0 +1,218 @@
+#include "blas_batching.h"
+
+#include <sdfg/analysis/analysis.h>
+#include <sdfg/analysis/scope_analysis.h>
+#include <sdfg/builder/structured_sdfg_builder.h>
+#include <sdfg/data_flow/access_node.h>
+#include <sdfg/data_flow/library_node.h>
+#include <sdfg/data_flow/memlet.h>
+#include <sdfg/data_flow/tasklet.h>
+#include <sdfg/einsum/einsum_node.h>
+#include <sdfg/structured_control_flow/block.h>
+#include <sdfg/structured_control_flow/control_flow_node.h>
+#include <sdfg/structured_control_flow/map.h>
+#include <sdfg/structured_control_flow/sequence.h>
+#include <sdfg/structured_control_flow/structured_loop.h>
+#include <sdfg/symbolic/symbolic.h>
+#include <sdfg/transformations/transformation.h>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "blas_batch_dispatcher.h"
+
+namespace sdfg {
+namespace transformations {
+
+std::vector<std::reference_wrapper<structured_control_flow::StructuredLoop>>
+BLASBatching::loop_nest() {
+    std::vector<std::reference_wrapper<structured_control_flow::StructuredLoop>> result;
+    structured_control_flow::StructuredLoop* current_loop = &this->loop_;
+    while (current_loop) {
+        if (current_loop->root().size() != 1) return {};
+        if (!current_loop->root().at(0).second.assignments().empty()) return {};
+        result.push_back(*current_loop);
+        auto& child = current_loop->root().at(0).first;
+        if (dynamic_cast<structured_control_flow::Block*>(&child)) break;
+        current_loop = dynamic_cast<structured_control_flow::StructuredLoop*>(&child);
+    }
+    if (!current_loop) return {};
+    return result;
+}
+
+data_flow::LibraryNode* BLASBatching::blas_node(structured_control_flow::Block& block) {
+    data_flow::LibraryNode* result = nullptr;
+    for (auto& node : block.dataflow().nodes()) {
+        auto* library_node = dynamic_cast<data_flow::LibraryNode*>(&node);
+        if (!library_node) continue;
+        if (result || dynamic_cast<einsum::EinsumNode*>(library_node)) return nullptr;
+        result = library_node;
+    }
+    return result;
+}
+
+bool BLASBatching::selects_slice(const data_flow::Subset& begin_subset,
+                                 const data_flow::Subset& end_subset,
+                                 const symbolic::Symbol& indvar,
+                                 const symbolic::SymbolSet& indvars) {
+    // One dimension is fixed to the index variable with a constant offset
+    for (size_t i = 0; i < begin_subset.size(); ++i) {
+        auto& begin = begin_subset.at(i);
+        if (!symbolic::eq(begin, end_subset.at(i))) continue;
+        if (!symbolic::uses(begin, indvar)) continue;
+        bool constant_offset = true;
+        for (auto& other : indvars) {
+            if (symbolic::uses(symbolic::sub(begin, indvar), other)) constant_offset = false;
+        }
+        if (constant_offset) return true;
+    }
+    return false;
+}
+
+BLASBatching::BLASBatching(structured_control_flow::StructuredLoop& loop) : loop_(loop) {}
+
+std::string BLASBatching::name() const { return "BLASBatching"; }
+
+bool BLASBatching::can_be_applied(builder::StructuredSDFGBuilder& builder,
+                                  analysis::AnalysisManager& analysis_manager) {
+    auto& sdfg = builder.subject();
+
+    // Sequential loop outside of other batches
+    if (auto* map_stmt = dynamic_cast<structured_control_flow::Map*>(&this->loop_)) {
+        if (map_stmt->schedule_type().value() !=
+            structured_control_flow::ScheduleType_Sequential.value())
+            return false;
+    }
+    auto& scope_analysis = analysis_manager.get<analysis::ScopeAnalysis>();
+    auto* scope = scope_analysis.parent_scope(&this->loop_);
+    while (scope) {
+        auto* map_stmt = dynamic_cast<structured_control_flow::Map*>(scope);
+        if (map_stmt &&
+            map_stmt->schedule_type().value() == codegen::ScheduleType_BLASBatch.value())
+            return false;
+        scope = scope_analysis.parent_scope(scope);
+    }
+
+    // Perfect loop nest around a block with a single BLAS call
+    auto loop_nest = this->loop_nest();
+    if (loop_nest.empty()) return false;
+    symbolic::SymbolSet indvars;
+    for (auto& loop : loop_nest) indvars.insert(loop.get().indvar());
+    auto& block =
+        static_cast<structured_control_flow::Block&>(loop_nest.back().get().root().at(0).first);
+    auto& dataflow = block.dataflow();
+    auto* blas_node = this->blas_node(block);
+    if (!blas_node) return false;
+
+    // Each iteration of the nest writes its own slice of every output
+    std::unordered_set<std::string> written;
+    for (auto& oedge : dataflow.out_edges(*blas_node)) {
+        auto& output = static_cast<data_flow::AccessNode&>(oedge.dst());
+        if (oedge.begin_subset().empty()) return false;
+        for (auto& indvar : indvars) {
+            if (!this->selects_slice(oedge.begin_subset(), oedge.end_subset(), indvar, indvars))
+                return false;
+        }
+        written.insert(output.data());
+    }
+    if (written.empty()) return false;
+
+    // Outputs are only read by the call itself, e.g. C of beta * C, and only in its own slice
+    for (auto& iedge : dataflow.in_edges(*blas_node)) {
+        auto& input = static_cast<data_flow::AccessNode&>(iedge.src());
+        if (!written.contains(input.data())) continue;
+        bool same_slice = false;
+        for (auto& oedge : dataflow.out_edges(*blas_node)) {
+            auto& output = static_cast<data_flow::AccessNode&>(oedge.dst());
+            if (output.data() != input.data()) continue;
+            auto& begin_subset = iedge.begin_subset();
+            auto& end_subset = iedge.end_subset();
+            if (begin_subset.size() != oedge.begin_subset().size()) continue;
+            same_slice = true;
+            for (size_t i = 0; i < begin_subset.size(); ++i) {
+                if (!symbolic::eq(begin_subset.at(i), oedge.begin_subset().at(i)) ||
+                    !symbolic::eq(end_subset.at(i), oedge.end_subset().at(i)))
+                    same_slice = false;
+            }
+            if (same_slice) break;
+        }
+        if (!same_slice) return false;
+    }
+
+    // Other computations run while the calls are recorded, e.g. the scaled beta of
+    // BLASScalingFusion, they must neither see the outputs nor write arrays
+    for (auto& node : dataflow.nodes()) {
+        auto* tasklet = dynamic_cast<data_flow::Tasklet*>(&node);
+        if (!tasklet) {
+            if (&node != blas_node && !dynamic_cast<data_flow::AccessNode*>(&node)) return false;
+            continue;
+        }
+        for (auto& iedge : dataflow.in_edges(*tasklet)) {
+            auto& input = static_cast<data_flow::AccessNode&>(iedge.src());
+            if (written.contains(input.data())) return false;
+        }
+        for (auto& oedge : dataflow.out_edges(*tasklet)) {
+            auto& output = static_cast<data_flow::AccessNode&>(oedge.dst());
+            if (!oedge.subset().empty() || !sdfg.is_transient(output.data())) return false;
+        }
+    }
+
+    return true;
+}
+
+void BLASBatching::apply(builder::StructuredSDFGBuilder& builder,
+                         analysis::AnalysisManager& analysis_manager) {
+    auto& scope_analysis = analysis_manager.get<analysis::ScopeAnalysis>();
+    auto* parent =
+        static_cast<structured_control_flow::Sequence*>(scope_analysis.parent_scope(&this->loop_));
+
+    // Add batched map in front of the loop
+    auto& batch_loop =
+        builder
+            .add_map_before(*parent, this->loop_, this->loop_.indvar(), this->loop_.condition(),
+                            this->loop_.init(), this->loop_.update(),
+                            codegen::ScheduleType_BLASBatch, {}, this->loop_.debug_info())
+            .first;
+
+    // Move the body, the loop nest has no assignments
+    auto& body = this->loop_.root();
+    while (body.size() > 0) {
+        auto& child = body.at(0).first;
+        builder.insert(child, body, batch_loop.root(), child.debug_info());
+    }
+
+    // Remove the old loop but keep the assignments of its transition
+    size_t loop_index;
+    for (loop_index = 0; loop_index < parent->size(); ++loop_index) {
+        if (parent->at(loop_index).first.element_id() == this->loop_.element_id()) break;
+    }
+    auto& assignments = parent->at(loop_index).second.assignments();
+    parent->at(loop_index - 1).second.assignments().insert(assignments.begin(), assignments.end());
+    builder.remove_child(*parent, loop_index);
+
+    analysis_manager.invalidate_all();
+}
+
+void BLASBatching::to_json(nlohmann::json& j) const {
+    j["transformation_type"] = this->name();
+    j["loop_element_id"] = this->loop_.element_id();
+}
+
+BLASBatching BLASBatching::from_json(builder::StructuredSDFGBuilder& builder,
+                                     const nlohmann::json& desc) {
+    auto loop_id = desc["loop_element_id"].get<size_t>();
+    auto element = builder.find_element_by_id(loop_id);
+    if (!element) {
+        throw InvalidTransformationDescriptionException("Element with ID " +
+                                                        std::to_string(loop_id) + " not found.");
+    }
+    auto loop = dynamic_cast<structured_control_flow::StructuredLoop*>(element);
+
+    return BLASBatching(*loop);
+}
+
+}  // namespace transformations
+}  // namespace sdfg
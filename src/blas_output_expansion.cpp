@@ -0,0 +1,444 @@
+#include "blas_output_expansion.h"
+
+#include <sdfg/analysis/analysis.h>
+#include <sdfg/analysis/scope_analysis.h>
+#include <sdfg/builder/structured_sdfg_builder.h>
+#include <sdfg/data_flow/access_node.h>
+#include <sdfg/data_flow/library_node.h>
+#include <sdfg/data_flow/memlet.h>
+#include <sdfg/data_flow/tasklet.h>
+#include <sdfg/einsum/einsum_node.h>
+#include <sdfg/structured_control_flow/block.h>
+#include <sdfg/structured_control_flow/control_flow_node.h>
+#include <sdfg/structured_control_flow/if_else.h>
+#include <sdfg/structured_control_flow/map.h>
+#include <sdfg/structured_control_flow/sequence.h>
+#include <sdfg/structured_control_flow/structured_loop.h>
+#include <sdfg/structured_control_flow/while.h>
+#include <sdfg/symbolic/symbolic.h>
+#include <sdfg/transformations/transformation.h>
+#include <sdfg/types/array.h>
+#include <sdfg/types/pointer.h>
+#include <sdfg/types/scalar.h>
+#include <symengine/basic.h>
+#include <symengine/logic.h>
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "blas_batch_dispatcher.h"
+
+namespace sdfg {
+namespace transformations {
+
+namespace {
+
+// Begin and end of the accessed range, library nodes access a range and tasklets an element
+using Range = std::pair<data_flow::Subset, data_flow::Subset>;
+
+struct Accesses {
+    std::unordered_map<std::string, std::vector<Range>> reads;
+    std::unordered_map<std::string, std::vector<Range>> writes;
+    symbolic::SymbolSet assigned;
+};
+
+Range range(data_flow::Memlet& memlet) {
+    if (dynamic_cast<data_flow::LibraryNode*>(&memlet.src()) ||
+        dynamic_cast<data_flow::LibraryNode*>(&memlet.dst()))
+        return {memlet.begin_subset(), memlet.end_subset()};
+    return {memlet.subset(), memlet.subset()};
+}
+
+bool uses(const Range& range, const symbolic::SymbolSet& symbols) {
+    for (auto& symbol : symbols) {
+        for (auto& expr : range.first) {
+            if (symbolic::uses(expr, symbol)) return true;
+        }
+        for (auto& expr : range.second) {
+            if (symbolic::uses(expr, symbol)) return true;
+        }
+    }
+    return false;
+}
+
+// Fails for control flow leaving the loop, e.g. a return, the loop cannot be distributed then
+bool collect(structured_control_flow::ControlFlowNode& node, Accesses& accesses) {
+    if (auto* block = dynamic_cast<structured_control_flow::Block*>(&node)) {
+        auto& dataflow = block->dataflow();
+        for (auto& dataflow_node : dataflow.nodes()) {
+            auto* access_node = dynamic_cast<data_flow::AccessNode*>(&dataflow_node);
+            if (!access_node) continue;
+            for (auto& oedge : dataflow.out_edges(*access_node))
+                accesses.reads[access_node->data()].push_back(range(oedge));
+            for (auto& iedge : dataflow.in_edges(*access_node))
+                accesses.writes[access_node->data()].push_back(range(iedge));
+        }
+        return true;
+    } else if (auto* sequence = dynamic_cast<structured_control_flow::Sequence*>(&node)) {
+        for (size_t i = 0; i < sequence->size(); ++i) {
+            for (auto& assignment : sequence->at(i).second.assignments())
+                accesses.assigned.insert(assignment.first);
+            if (!collect(sequence->at(i).first, accesses)) return false;
+        }
+        return true;
+    } else if (auto* loop = dynamic_cast<structured_control_flow::StructuredLoop*>(&node)) {
+        accesses.assigned.insert(loop->indvar());
+        return collect(loop->root(), accesses);
+    } else if (auto* if_else = dynamic_cast<structured_control_flow::IfElse*>(&node)) {
+        for (size_t i = 0; i < if_else->size(); ++i) {
+            if (!collect(if_else->at(i).first, accesses)) return false;
+        }
+        return true;
+    } else if (auto* while_loop = dynamic_cast<structured_control_flow::While*>(&node)) {
+        return collect(while_loop->root(), accesses);
+    }
+    return false;
+}
+
+const types::IType* element_type(const types::IType& type) {
+    if (auto* pointer = dynamic_cast<const types::Pointer*>(&type)) return &pointer->pointee_type();
+    if (auto* array = dynamic_cast<const types::Array*>(&type)) return &array->element_type();
+    return nullptr;
+}
+
+}  // namespace
+
+data_flow::LibraryNode* BLASOutputExpansion::blas_node(structured_control_flow::Block& block) {
+    data_flow::LibraryNode* result = nullptr;
+    for (auto& node : block.dataflow().nodes()) {
+        auto* library_node = dynamic_cast<data_flow::LibraryNode*>(&node);
+        if (!library_node) continue;
+        if (result || dynamic_cast<einsum::EinsumNode*>(library_node)) return nullptr;
+        result = library_node;
+    }
+    return result;
+}
+
+size_t BLASOutputExpansion::blas_index() {
+    auto& body = this->loop_.root();
+    for (size_t i = 0; i < body.size(); ++i) {
+        auto* block = dynamic_cast<structured_control_flow::Block*>(&body.at(i).first);
+        if (block && this->blas_node(*block)) return i;
+    }
+    return body.size();
+}
+
+bool BLASOutputExpansion::initializes(structured_control_flow::ControlFlowNode& node,
+                                      const std::string& container,
+                                      const symbolic::Expression& begin,
+                                      const symbolic::Expression& end) {
+    // for (i = begin; i < end + 1; i++) container[i] = constant
+    auto* loop = dynamic_cast<structured_control_flow::StructuredLoop*>(&node);
+    if (!loop) return false;
+    auto indvar = loop->indvar();
+    if (!symbolic::eq(loop->init(), begin)) return false;
+    if (!symbolic::eq(loop->update(), symbolic::add(indvar, symbolic::one()))) return false;
+    if (!symbolic::eq(loop->condition(), symbolic::Lt(indvar, symbolic::add(end, symbolic::one()))))
+        return false;
+    if (loop->root().size() != 1) return false;
+    if (!loop->root().at(0).second.assignments().empty()) return false;
+    auto* block = dynamic_cast<structured_control_flow::Block*>(&loop->root().at(0).first);
+    if (!block) return false;
+
+    auto& dataflow = block->dataflow();
+    bool writes = false;
+    for (auto& dataflow_node : dataflow.nodes()) {
+        if (auto* access_node = dynamic_cast<data_flow::AccessNode*>(&dataflow_node)) {
+            if (access_node->data() != container || dataflow.out_degree(*access_node) > 0)
+                return false;
+            continue;
+        }
+        auto* tasklet = dynamic_cast<data_flow::Tasklet*>(&dataflow_node);
+        if (!tasklet || dataflow.in_degree(*tasklet) > 0) return false;
+        for (auto& oedge : dataflow.out_edges(*tasklet)) {
+            if (oedge.subset().size() != 1 || !symbolic::eq(oedge.subset().at(0), indvar))
+                return false;
+            writes = true;
+        }
+    }
+    return writes;
+}
+
+void BLASOutputExpansion::expand(builder::StructuredSDFGBuilder& builder,
+                                 structured_control_flow::Block& block,
+                                 const std::string& container,
+                                 const std::string& expanded_container,
+                                 const symbolic::Expression& row) {
+    auto& dataflow = block.dataflow();
+    std::vector<data_flow::AccessNode*> access_nodes;
+    for (auto& node : dataflow.nodes()) {
+        auto* access_node = dynamic_cast<data_flow::AccessNode*>(&node);
+        if (access_node && access_node->data() == container) access_nodes.push_back(access_node);
+    }
+
+    for (auto* access_node : access_nodes) {
+        auto& expanded_access = builder.add_access(block, expanded_container);
+        std::vector<data_flow::Memlet*> memlets;
+        for (auto& iedge : dataflow.in_edges(*access_node)) memlets.push_back(&iedge);
+        for (auto& oedge : dataflow.out_edges(*access_node)) memlets.push_back(&oedge);
+        for (auto* memlet : memlets) {
+            bool write = &memlet->dst() == access_node;
+            data_flow::DataFlowNode& src = write ? memlet->src() : expanded_access;
+            data_flow::DataFlowNode& dst = write ? expanded_access : memlet->dst();
+            auto [begin_subset, end_subset] = range(*memlet);
+            begin_subset.insert(begin_subset.begin(), row);
+            end_subset.insert(end_subset.begin(), row);
+            if (dynamic_cast<data_flow::LibraryNode*>(write ? &src : &dst)) {
+                builder.add_memlet(block, src, memlet->src_conn(), dst, memlet->dst_conn(),
+                                   begin_subset, end_subset);
+            } else {
+                builder.add_memlet(block, src, memlet->src_conn(), dst, memlet->dst_conn(),
+                                   begin_subset);
+            }
+            builder.remove_memlet(block, *memlet);
+        }
+        builder.remove_node(block, *access_node);
+    }
+}
+
+void BLASOutputExpansion::distribute(builder::StructuredSDFGBuilder& builder,
+                                     structured_control_flow::Sequence& parent, size_t count) {
+    auto& sdfg = builder.subject();
+    auto indvar = this->loop_.indvar();
+
+    structured_control_flow::StructuredLoop* new_loop;
+    if (auto* map_stmt = dynamic_cast<structured_control_flow::Map*>(&this->loop_)) {
+        new_loop = &builder
+                        .add_map_before(parent, this->loop_, indvar, this->loop_.condition(),
+                                        this->loop_.init(), this->loop_.update(),
+                                        map_stmt->schedule_type(), {}, this->loop_.debug_info())
+                        .first;
+    } else {
+        new_loop = &builder
+                        .add_for_before(parent, this->loop_, indvar, this->loop_.condition(),
+                                        this->loop_.init(), this->loop_.update(),
+                                        this->loop_.debug_info())
+                        .first;
+    }
+    auto& body = this->loop_.root();
+    for (size_t i = 0; i < count; ++i) {
+        auto& child = body.at(0).first;
+        builder.insert(child, body, new_loop->root(), child.debug_info());
+    }
+
+    std::string new_indvar = builder.find_new_name(indvar->get_name());
+    builder.add_container(new_indvar, sdfg.type(indvar->get_name()));
+    new_loop->replace(indvar, symbolic::symbol(new_indvar));
+}
+
+BLASOutputExpansion::BLASOutputExpansion(structured_control_flow::StructuredLoop& loop)
+    : loop_(loop) {}
+
+std::string BLASOutputExpansion::name() const { return "BLASOutputExpansion"; }
+
+bool BLASOutputExpansion::can_be_applied(builder::StructuredSDFGBuilder& builder,
+                                         analysis::AnalysisManager& analysis_manager) {
+    auto& sdfg = builder.subject();
+
+    // Sequential loop outside of batches, the rows of the output are fixed during the loop nest
+    if (auto* map_stmt = dynamic_cast<structured_control_flow::Map*>(&this->loop_)) {
+        if (map_stmt->schedule_type().value() !=
+            structured_control_flow::ScheduleType_Sequential.value())
+            return false;
+    }
+    auto indvar = this->loop_.indvar();
+    symbolic::SymbolSet indvars;
+    indvars.insert(indvar);
+    auto& scope_analysis = analysis_manager.get<analysis::ScopeAnalysis>();
+    auto* scope = scope_analysis.parent_scope(&this->loop_);
+    while (scope) {
+        auto* map_stmt = dynamic_cast<structured_control_flow::Map*>(scope);
+        if (map_stmt &&
+            map_stmt->schedule_type().value() == codegen::ScheduleType_BLASBatch.value())
+            return false;
+        if (auto* loop = dynamic_cast<structured_control_flow::StructuredLoop*>(scope))
+            indvars.insert(loop->indvar());
+        scope = scope_analysis.parent_scope(scope);
+    }
+    if (!symbolic::eq(this->loop_.update(), symbolic::add(indvar, symbolic::one()))) return false;
+    auto condition = this->loop_.condition();
+    if (!SymEngine::is_a<SymEngine::StrictLessThan>(*condition)) return false;
+    auto args = condition->get_args();
+    if (!symbolic::eq(args.at(0), indvar)) return false;
+    for (auto& other : indvars) {
+        if (symbolic::uses(this->loop_.init(), other)) return false;
+        if (symbolic::uses(args.at(1), other)) return false;
+    }
+
+    // Initializations of the output, the call, then the code reading the output
+    auto& body = this->loop_.root();
+    for (size_t i = 0; i < body.size(); ++i) {
+        if (!body.at(i).second.assignments().empty()) return false;
+    }
+    size_t blas_index = this->blas_index();
+    if (blas_index + 1 >= body.size()) return false;
+    auto& block = static_cast<structured_control_flow::Block&>(body.at(blas_index).first);
+    auto& dataflow = block.dataflow();
+    auto* blas_node = this->blas_node(block);
+
+    // A single output whose range is the same in every iteration
+    if (dataflow.out_degree(*blas_node) != 1) return false;
+    auto& oedge = *dataflow.out_edges(*blas_node).begin();
+    auto& container = static_cast<data_flow::AccessNode&>(oedge.dst()).data();
+    if (oedge.begin_subset().size() != 1 || oedge.end_subset().size() != 1) return false;
+    auto& begin = oedge.begin_subset().at(0);
+    auto& end = oedge.end_subset().at(0);
+    if (uses(range(oedge), indvars)) return false;
+    auto* element = element_type(sdfg.type(container));
+    if (!element || !dynamic_cast<const types::Scalar*>(element)) return false;
+
+    // Other computations of the block must stay batchable, see BLASBatching
+    for (auto& node : dataflow.nodes()) {
+        auto* tasklet = dynamic_cast<data_flow::Tasklet*>(&node);
+        if (!tasklet) {
+            if (&node != blas_node && !dynamic_cast<data_flow::AccessNode*>(&node)) return false;
+            continue;
+        }
+        for (auto& iedge : dataflow.in_edges(*tasklet)) {
+            auto& input = static_cast<data_flow::AccessNode&>(iedge.src());
+            if (input.data() == container) return false;
+        }
+        for (auto& tasklet_oedge : dataflow.out_edges(*tasklet)) {
+            auto& output = static_cast<data_flow::AccessNode&>(tasklet_oedge.dst());
+            if (!tasklet_oedge.subset().empty() || !sdfg.is_transient(output.data()))
+                return false;
+        }
+    }
+
+    // A call reading the output, e.g. C of beta * C, needs the initializations in front of it
+    Accesses block_accesses;
+    collect(block, block_accesses);
+    if (block_accesses.reads.contains(container)) {
+        if (blas_index == 0) return false;
+        for (auto& read : block_accesses.reads.at(container)) {
+            if (read.first.size() != 1 || !symbolic::eq(read.first.at(0), begin) ||
+                !symbolic::eq(read.second.at(0), end))
+                return false;
+        }
+    }
+    for (size_t i = 0; i < blas_index; ++i) {
+        if (!this->initializes(body.at(i).first, container, begin, end)) return false;
+    }
+
+    // The calls of all iterations run before the rest of the body, the rest may only write what
+    // the call reads in the slice of its own iteration
+    Accesses rest_accesses;
+    for (size_t i = blas_index + 1; i < body.size(); ++i) {
+        if (!collect(body.at(i).first, rest_accesses)) return false;
+    }
+    for (auto& write : block_accesses.writes) {
+        if (write.first == container) continue;
+        if (rest_accesses.reads.contains(write.first) || rest_accesses.writes.contains(write.first))
+            return false;
+    }
+    for (auto& read : block_accesses.reads) {
+        for (auto& symbol : rest_accesses.assigned) {
+            if (symbol->get_name() == read.first) return false;
+        }
+        for (auto& read_range : read.second) {
+            if (uses(read_range, rest_accesses.assigned)) return false;
+        }
+        if (read.first == container || !rest_accesses.writes.contains(read.first)) continue;
+        for (auto& read_range : read.second) {
+            size_t dimension;
+            for (dimension = 0; dimension < read_range.first.size(); ++dimension) {
+                if (symbolic::eq(read_range.first.at(dimension), indvar) &&
+                    symbolic::eq(read_range.second.at(dimension), indvar))
+                    break;
+            }
+            if (dimension == read_range.first.size()) return false;
+            for (auto& write_range : rest_accesses.writes.at(read.first)) {
+                if (write_range.first.size() != read_range.first.size()) return false;
+                if (!symbolic::eq(write_range.first.at(dimension), indvar) ||
+                    !symbolic::eq(write_range.second.at(dimension), indvar))
+                    return false;
+            }
+        }
+    }
+    if (uses(range(oedge), rest_accesses.assigned)) return false;
+
+    return true;
+}
+
+void BLASOutputExpansion::apply(builder::StructuredSDFGBuilder& builder,
+                                analysis::AnalysisManager& analysis_manager) {
+    auto& sdfg = builder.subject();
+    auto indvar = this->loop_.indvar();
+    auto init = this->loop_.init();
+    auto bound = this->loop_.condition()->get_args().at(1);
+
+    auto& body = this->loop_.root();
+    size_t blas_index = this->blas_index();
+    auto& block = static_cast<structured_control_flow::Block&>(body.at(blas_index).first);
+    auto* blas_node = this->blas_node(block);
+    auto& oedge = *block.dataflow().out_edges(*blas_node).begin();
+    std::string container = static_cast<data_flow::AccessNode&>(oedge.dst()).data();
+    auto begin = oedge.begin_subset().at(0);
+    auto end = oedge.end_subset().at(0);
+
+    // Rows of the output indexed by the iteration, columns indexed like the output
+    types::Scalar scalar_type(element_type(sdfg.type(container))->primitive_type());
+    types::Array row_type(scalar_type, symbolic::add(end, symbolic::one()));
+    std::string expanded_container = builder.find_new_name("_rows");
+    builder.add_container(expanded_container, types::Array(row_type, symbolic::sub(bound, init)));
+    auto row = symbolic::sub(indvar, init);
+    for (size_t i = 0; i <= blas_index; ++i) {
+        auto* child_block = dynamic_cast<structured_control_flow::Block*>(&body.at(i).first);
+        if (!child_block) {
+            auto& loop = static_cast<structured_control_flow::StructuredLoop&>(body.at(i).first);
+            child_block = &static_cast<structured_control_flow::Block&>(loop.root().at(0).first);
+        }
+        this->expand(builder, *child_block, container, expanded_container, row);
+    }
+
+    // The initializations and the call get loops of their own in front of the loop
+    auto& scope_analysis = analysis_manager.get<analysis::ScopeAnalysis>();
+    auto* parent =
+        static_cast<structured_control_flow::Sequence*>(scope_analysis.parent_scope(&this->loop_));
+    if (blas_index > 0) this->distribute(builder, *parent, blas_index);
+    this->distribute(builder, *parent, 1);
+
+    // The rest of the body reads the row of its iteration from the output
+    std::string copy_indvar_name = builder.find_new_name(indvar->get_name());
+    builder.add_container(copy_indvar_name, sdfg.type(indvar->get_name()));
+    auto copy_indvar = symbolic::symbol(copy_indvar_name);
+    auto& copy_loop =
+        builder
+            .add_for_before(body, body.at(0).first, copy_indvar,
+                            symbolic::Lt(copy_indvar, symbolic::add(end, symbolic::one())), begin,
+                            symbolic::add(copy_indvar, symbolic::one()), this->loop_.debug_info())
+            .first;
+    auto& copy_block = builder.add_block(copy_loop.root());
+    auto& rows = builder.add_access(copy_block, expanded_container);
+    auto& output = builder.add_access(copy_block, container);
+    auto& copy = builder.add_tasklet(copy_block, data_flow::TaskletCode::assign,
+                                     {"_out", scalar_type}, {{"_in", scalar_type}});
+    builder.add_memlet(copy_block, rows, "void", copy, "_in", {row, copy_indvar});
+    builder.add_memlet(copy_block, copy, "_out", output, "void", {copy_indvar});
+
+    analysis_manager.invalidate_all();
+}
+
+void BLASOutputExpansion::to_json(nlohmann::json& j) const {
+    j["transformation_type"] = this->name();
+    j["loop_element_id"] = this->loop_.element_id();
+}
+
+BLASOutputExpansion BLASOutputExpansion::from_json(builder::StructuredSDFGBuilder& builder,
+                                                   const nlohmann::json& desc) {
+    auto loop_id = desc["loop_element_id"].get<size_t>();
+    auto element = builder.find_element_by_id(loop_id);
+    if (!element) {
+        throw InvalidTransformationDescriptionException("Element with ID " +
+                                                        std::to_string(loop_id) + " not found.");
+    }
+    auto loop = dynamic_cast<structured_control_flow::StructuredLoop*>(element);
+
+    return BLASOutputExpansion(*loop);
+}
+
+}  // namespace transformations
+}  // namespace sdfg
@@ -0,0 +1,271 @@
+#include "blas_scaling_fusion.h"
+
+#include <sdfg/analysis/analysis.h>
+#include <sdfg/analysis/scope_analysis.h>
+#include <sdfg/builder/structured_sdfg_builder.h>
+#include <sdfg/data_flow/access_node.h>
+#include <sdfg/data_flow/library_node.h>
+#include <sdfg/data_flow/memlet.h>
+#include <sdfg/data_flow/tasklet.h>
+#include <sdfg/structured_control_flow/block.h>
+#include <sdfg/structured_control_flow/sequence.h>
+#include <sdfg/structured_control_flow/structured_loop.h>
+#include <sdfg/symbolic/symbolic.h>
+#include <sdfg/transformations/transformation.h>
+#include <symengine/basic.h>
+#include <symengine/logic.h>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace sdfg {
+namespace transformations {
+
+// Connector of the BLAS library nodes receiving the scaling factor of the output
+static const std::string BLAS_BETA_CONNECTOR = "beta";
+
+std::vector<std::reference_wrapper<structured_control_flow::StructuredLoop>>
+BLASScalingFusion::loop_nest() {
+    std::vector<std::reference_wrapper<structured_control_flow::StructuredLoop>> result;
+    structured_control_flow::StructuredLoop* current_loop = &this->loop_;
+    while (current_loop) {
+        if (current_loop->root().size() != 1) return {};
+        if (!current_loop->root().at(0).second.assignments().empty()) return {};
+        result.push_back(*current_loop);
+        auto& child = current_loop->root().at(0).first;
+        if (dynamic_cast<structured_control_flow::Block*>(&child)) break;
+        current_loop = dynamic_cast<structured_control_flow::StructuredLoop*>(&child);
+    }
+    if (!current_loop) return {};
+    return result;
+}
+
+data_flow::Tasklet* BLASScalingFusion::scaling_tasklet(structured_control_flow::Block& block) {
+    data_flow::Tasklet* result = nullptr;
+    for (auto& node : block.dataflow().nodes()) {
+        if (dynamic_cast<data_flow::AccessNode*>(&node)) continue;
+        auto* tasklet = dynamic_cast<data_flow::Tasklet*>(&node);
+        if (!tasklet || result) return nullptr;
+        result = tasklet;
+    }
+    if (!result) return nullptr;
+    if (result->code() != data_flow::TaskletCode::mul) return nullptr;
+    if (result->inputs().size() != 2) return nullptr;
+    return result;
+}
+
+BLASScalingFusion::BLASScalingFusion(structured_control_flow::StructuredLoop& loop,
+                                     data_flow::LibraryNode& blas_node)
+    : loop_(loop), blas_node_(blas_node) {}
+
+std::string BLASScalingFusion::name() const { return "BLASScalingFusion"; }
+
+bool BLASScalingFusion::can_be_applied(builder::StructuredSDFGBuilder& builder,
+                                       analysis::AnalysisManager& analysis_manager) {
+    // Perfect loop nest over a rectangular iteration space
+    auto loop_nest = this->loop_nest();
+    if (loop_nest.empty()) return false;
+    symbolic::SymbolSet indvars;
+    for (auto& loop : loop_nest) indvars.insert(loop.get().indvar());
+    std::vector<symbolic::Expression> bounds;
+    for (auto& loop : loop_nest) {
+        auto indvar = loop.get().indvar();
+        if (!symbolic::eq(loop.get().update(), symbolic::add(indvar, symbolic::one())))
+            return false;
+        auto condition = loop.get().condition();
+        if (!SymEngine::is_a<SymEngine::StrictLessThan>(*condition)) return false;
+        auto args = condition->get_args();
+        if (!symbolic::eq(args.at(0), indvar)) return false;
+        for (auto& other : indvars) {
+            if (symbolic::uses(loop.get().init(), other)) return false;
+            if (symbolic::uses(args.at(1), other)) return false;
+        }
+        bounds.push_back(args.at(1));
+    }
+
+    // Body: C[i, j, ...] = C[i, j, ...] * s
+    auto& block =
+        static_cast<structured_control_flow::Block&>(loop_nest.back().get().root().at(0).first);
+    auto* tasklet = this->scaling_tasklet(block);
+    if (!tasklet) return false;
+    auto& dataflow = block.dataflow();
+    if (dataflow.out_degree(*tasklet) != 1) return false;
+    auto& oedge = *dataflow.out_edges(*tasklet).begin();
+    auto& output = static_cast<data_flow::AccessNode&>(oedge.dst());
+    auto& subset = oedge.subset();
+    if (subset.size() != loop_nest.size()) return false;
+    for (size_t i = 0; i < subset.size(); ++i) {
+        if (!symbolic::eq(subset.at(i), loop_nest.at(i).get().indvar())) return false;
+    }
+    // One input reads C[i, j, ...], the other one is a scalar container or a constant
+    size_t output_inputs = 0;
+    for (auto& input : tasklet->inputs()) {
+        size_t edges = 0;
+        for (auto& iedge : dataflow.in_edges(*tasklet)) {
+            if (iedge.dst_conn() != input.first) continue;
+            edges++;
+            auto& src = static_cast<data_flow::AccessNode&>(iedge.src());
+            if (src.data() == output.data()) {
+                if (iedge.subset().size() != subset.size()) return false;
+                for (size_t i = 0; i < subset.size(); ++i) {
+                    if (!symbolic::eq(iedge.subset().at(i), subset.at(i))) return false;
+                }
+                output_inputs++;
+            } else if (!iedge.subset().empty()) {
+                return false;
+            }
+        }
+        if (edges > 1) return false;
+    }
+    if (output_inputs != 1) return false;
+
+    // The BLAS call must directly follow the loop nest
+    auto& scope_analysis = analysis_manager.get<analysis::ScopeAnalysis>();
+    auto* parent =
+        static_cast<structured_control_flow::Sequence*>(scope_analysis.parent_scope(&this->loop_));
+    if (!parent) return false;
+    size_t loop_index;
+    for (loop_index = 0; loop_index < parent->size(); ++loop_index) {
+        if (parent->at(loop_index).first.element_id() == this->loop_.element_id()) break;
+    }
+    if (loop_index + 1 >= parent->size()) return false;
+    if (!parent->at(loop_index).second.assignments().empty()) return false;
+    auto* blas_block =
+        dynamic_cast<structured_control_flow::Block*>(&parent->at(loop_index + 1).first);
+    if (!blas_block) return false;
+    if (&this->blas_node_.get_parent() != &blas_block->dataflow()) return false;
+    auto& blas_dataflow = blas_block->dataflow();
+
+    // The BLAS call must accumulate into exactly the scaled region of C ...
+    bool writes_output = false;
+    for (auto& blas_oedge : blas_dataflow.out_edges(this->blas_node_)) {
+        auto& blas_output = static_cast<data_flow::AccessNode&>(blas_oedge.dst());
+        if (blas_output.data() != output.data()) continue;
+        auto& begin_subset = blas_oedge.begin_subset();
+        auto& end_subset = blas_oedge.end_subset();
+        if (begin_subset.size() != bounds.size() || end_subset.size() != bounds.size())
+            return false;
+        for (size_t i = 0; i < bounds.size(); ++i) {
+            if (!symbolic::eq(begin_subset.at(i), loop_nest.at(i).get().init())) return false;
+            if (!symbolic::eq(end_subset.at(i), symbolic::sub(bounds.at(i), symbolic::one())))
+                return false;
+        }
+        writes_output = true;
+    }
+    if (!writes_output) return false;
+
+    // ... read C only once, and take beta as an input
+    size_t output_reads = 0;
+    bool has_beta = false;
+    for (auto& blas_iedge : blas_dataflow.in_edges(this->blas_node_)) {
+        auto& blas_input = static_cast<data_flow::AccessNode&>(blas_iedge.src());
+        if (blas_input.data() == output.data()) output_reads++;
+        if (blas_iedge.dst_conn() == BLAS_BETA_CONNECTOR) has_beta = true;
+    }
+    if (output_reads != 1 || !has_beta) return false;
+
+    return true;
+}
+
+void BLASScalingFusion::apply(builder::StructuredSDFGBuilder& builder,
+                              analysis::AnalysisManager& analysis_manager) {
+    auto& sdfg = builder.subject();
+
+    auto& scope_analysis = analysis_manager.get<analysis::ScopeAnalysis>();
+    auto* parent =
+        static_cast<structured_control_flow::Sequence*>(scope_analysis.parent_scope(&this->loop_));
+    size_t loop_index;
+    for (loop_index = 0; loop_index < parent->size(); ++loop_index) {
+        if (parent->at(loop_index).first.element_id() == this->loop_.element_id()) break;
+    }
+    auto& blas_block =
+        static_cast<structured_control_flow::Block&>(parent->at(loop_index + 1).first);
+
+    // Determine the scaling factor, either a constant or a scalar container
+    auto loop_nest = this->loop_nest();
+    auto& block =
+        static_cast<structured_control_flow::Block&>(loop_nest.back().get().root().at(0).first);
+    auto* tasklet = this->scaling_tasklet(block);
+    auto& oedge = *block.dataflow().out_edges(*tasklet).begin();
+    auto& output = static_cast<data_flow::AccessNode&>(oedge.dst());
+    // A constant is the name of its unconnected connector, a container gets a fresh connector
+    // next to the one of beta
+    std::string factor_container;
+    std::string factor_connector;
+    for (auto& input : tasklet->inputs()) {
+        bool connected = false;
+        for (auto& iedge : block.dataflow().in_edges(*tasklet)) {
+            if (iedge.dst_conn() != input.first) continue;
+            connected = true;
+            auto& src = static_cast<data_flow::AccessNode&>(iedge.src());
+            if (src.data() != output.data()) {
+                factor_container = src.data();
+                factor_connector = "_in2";
+            }
+        }
+        if (!connected) factor_connector = input.first;
+    }
+    auto type = tasklet->output().second;
+
+    // Scale beta in front of the BLAS call: beta' = beta * s
+    data_flow::Memlet* beta_edge = nullptr;
+    for (auto& iedge : blas_block.dataflow().in_edges(this->blas_node_)) {
+        if (iedge.dst_conn() == BLAS_BETA_CONNECTOR) beta_edge = &iedge;
+    }
+    auto& beta_src = beta_edge->src();
+    auto beta_src_conn = beta_edge->src_conn();
+    auto beta_subset = beta_edge->subset();
+
+    std::string scaled_beta = builder.find_new_name("_beta");
+    builder.add_container(scaled_beta, type);
+
+    auto& scale = builder.add_tasklet(blas_block, data_flow::TaskletCode::mul, {"_out", type},
+                                      {{"_in1", type}, {factor_connector, type}});
+    builder.add_memlet(blas_block, beta_src, beta_src_conn, scale, "_in1", beta_subset);
+    if (!factor_container.empty()) {
+        auto& factor = builder.add_access(blas_block, factor_container);
+        builder.add_memlet(blas_block, factor, "void", scale, factor_connector, {});
+    }
+    auto& scaled_beta_access = builder.add_access(blas_block, scaled_beta);
+    builder.add_memlet(blas_block, scale, "_out", scaled_beta_access, "void", {});
+    builder.add_memlet(blas_block, scaled_beta_access, "void", this->blas_node_,
+                       BLAS_BETA_CONNECTOR, {});
+    builder.remove_memlet(blas_block, *beta_edge);
+
+    // Remove the scaling loop nest
+    builder.remove_child(*parent, loop_index);
+
+    analysis_manager.invalidate_all();
+}
+
+void BLASScalingFusion::to_json(nlohmann::json& j) const {
+    j["transformation_type"] = this->name();
+    j["loop_element_id"] = this->loop_.element_id();
+    j["blas_node_element_id"] = this->blas_node_.element_id();
+}
+
+BLASScalingFusion BLASScalingFusion::from_json(builder::StructuredSDFGBuilder& builder,
+                                               const nlohmann::json& desc) {
+    auto loop_id = desc["loop_element_id"].get<size_t>();
+    auto element = builder.find_element_by_id(loop_id);
+    if (!element) {
+        throw InvalidTransformationDescriptionException("Element with ID " +
+                                                        std::to_string(loop_id) + " not found.");
+    }
+    auto loop = dynamic_cast<structured_control_flow::StructuredLoop*>(element);
+
+    auto blas_node_id = desc["blas_node_element_id"].get<size_t>();
+    auto blas_element = builder.find_element_by_id(blas_node_id);
+    if (!blas_element) {
+        throw InvalidTransformationDescriptionException(
+            "Element with ID " + std::to_string(blas_node_id) + " not found.");
+    }
+    auto blas_node = dynamic_cast<data_flow::LibraryNode*>(blas_element);
+
+    return BLASScalingFusion(*loop, *blas_node);
+}
+
+}  // namespace transformations
+}  // namespace sdfg
@@ -0,0 +1,93 @@
+#include "blas_task_dispatcher.h"
+
+#include <sdfg/codegen/dispatchers/node_dispatcher.h>
+#include <sdfg/codegen/dispatchers/sequence_dispatcher.h>
+#include <sdfg/codegen/instrumentation/instrumentation.h>
+#include <sdfg/codegen/language_extension.h>
+#include <sdfg/codegen/utils.h>
+#include <sdfg/structured_control_flow/control_flow_node.h>
+#include <sdfg/structured_control_flow/if_else.h>
+#include <sdfg/structured_control_flow/map.h>
+#include <sdfg/structured_control_flow/sequence.h>
+#include <sdfg/structured_control_flow/structured_loop.h>
+#include <sdfg/structured_control_flow/while.h>
+#include <sdfg/structured_sdfg.h>
+
+#include <cstddef>
+#include <set>
+#include <string>
+
+namespace sdfg {
+namespace codegen {
+
+BLASTaskMapDispatcher::BLASTaskMapDispatcher(LanguageExtension& language_extension,
+                                             StructuredSDFG& sdfg,
+                                             structured_control_flow::Map& node,
+                                             Instrumentation& instrumentation)
+    : NodeDispatcher(language_extension, sdfg, node, instrumentation), node_(node) {}
+
+void BLASTaskMapDispatcher::loop_indvars(structured_control_flow::ControlFlowNode& node,
+                                         std::set<std::string>& result) const {
+    if (auto* loop = dynamic_cast<structured_control_flow::StructuredLoop*>(&node)) {
+        result.insert(loop->indvar()->get_name());
+        this->loop_indvars(loop->root(), result);
+    } else if (auto* sequence = dynamic_cast<structured_control_flow::Sequence*>(&node)) {
+        for (size_t i = 0; i < sequence->size(); ++i) {
+            this->loop_indvars(sequence->at(i).first, result);
+        }
+    } else if (auto* if_else = dynamic_cast<structured_control_flow::IfElse*>(&node)) {
+        for (size_t i = 0; i < if_else->size(); ++i) {
+            this->loop_indvars(if_else->at(i).first, result);
+        }
+    } else if (auto* while_loop = dynamic_cast<structured_control_flow::While*>(&node)) {
+        this->loop_indvars(while_loop->root(), result);
+    }
+}
+
+void BLASTaskMapDispatcher::dispatch_node(PrettyPrinter& main_stream,
+                                          PrettyPrinter& globals_stream,
+                                          PrettyPrinter& library_stream) {
+    auto& tasks = this->node_.root();
+
+    // Without concurrency a single thread runs the tasks in order with all threads each
+    main_stream << "polybench_blas_tasks_begin(" << tasks.size() << ");" << std::endl;
+    main_stream << "#pragma omp parallel num_threads(" << tasks.size()
+                << ") if(polybench_blas_tasks_concurrent())" << std::endl;
+    main_stream << "#pragma omp single" << std::endl;
+    main_stream << "{" << std::endl;
+    main_stream.setIndent(main_stream.indent() + 4);
+
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        auto& task = static_cast<structured_control_flow::Sequence&>(tasks.at(i).first);
+
+        // Index variables are declared at function scope, the tasks share their names
+        std::string clauses;
+        std::set<std::string> indvars;
+        this->loop_indvars(task, indvars);
+        if (!indvars.empty()) {
+            clauses += " private(";
+            for (auto& indvar : indvars) {
+                if (clauses.back() != '(') clauses += ", ";
+                clauses += indvar;
+            }
+            clauses += ")";
+        }
+        main_stream << "#pragma omp task" << clauses << std::endl;
+        main_stream << "{" << std::endl;
+        main_stream.setIndent(main_stream.indent() + 4);
+        main_stream << "polybench_blas_task_begin(" << i << ");" << std::endl;
+        SequenceDispatcher dispatcher(this->language_extension_, this->sdfg_, task,
+                                      this->instrumentation_);
+        dispatcher.dispatch(main_stream, globals_stream, library_stream);
+        main_stream << "polybench_blas_task_end();" << std::endl;
+        main_stream.setIndent(main_stream.indent() - 4);
+        main_stream << "}" << std::endl;
+    }
+
+    main_stream.setIndent(main_stream.indent() - 4);
+    main_stream << "}" << std::endl;
+    main_stream << "polybench_blas_tasks_end();" << std::endl;
+}
+
+}  // namespace codegen
+}  // namespace sdfg
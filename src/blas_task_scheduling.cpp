@@ -0,0 +1,216 @@
+#include "blas_task_scheduling.h"
+
+#include <sdfg/analysis/analysis.h>
+#include <sdfg/analysis/users.h>
+#include <sdfg/builder/structured_sdfg_builder.h>
+#include <sdfg/data_flow/library_node.h>
+#include <sdfg/structured_control_flow/block.h>
+#include <sdfg/structured_control_flow/control_flow_node.h>
+#include <sdfg/structured_control_flow/if_else.h>
+#include <sdfg/structured_control_flow/map.h>
+#include <sdfg/structured_control_flow/sequence.h>
+#include <sdfg/structured_control_flow/structured_loop.h>
+#include <sdfg/structured_control_flow/while.h>
+#include <sdfg/structured_sdfg.h>
+#include <sdfg/symbolic/symbolic.h>
+#include <sdfg/types/scalar.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "blas_task_dispatcher.h"
+#include "polybench_node.h"
+#include "timer.h"
+
+namespace sdfg {
+namespace passes {
+
+namespace {
+
+bool has_library_node(structured_control_flow::ControlFlowNode& node) {
+    if (auto* block = dynamic_cast<structured_control_flow::Block*>(&node)) {
+        for (auto& dataflow_node : block->dataflow().nodes()) {
+            if (dynamic_cast<polybench::PolyBenchNode*>(&dataflow_node)) continue;
+            if (dynamic_cast<data_flow::LibraryNode*>(&dataflow_node)) return true;
+        }
+    } else if (auto* sequence = dynamic_cast<structured_control_flow::Sequence*>(&node)) {
+        for (size_t i = 0; i < sequence->size(); ++i) {
+            if (has_library_node(sequence->at(i).first)) return true;
+        }
+    } else if (auto* loop = dynamic_cast<structured_control_flow::StructuredLoop*>(&node)) {
+        return has_library_node(loop->root());
+    } else if (auto* if_else = dynamic_cast<structured_control_flow::IfElse*>(&node)) {
+        for (size_t i = 0; i < if_else->size(); ++i) {
+            if (has_library_node(if_else->at(i).first)) return true;
+        }
+    } else if (auto* while_loop = dynamic_cast<structured_control_flow::While*>(&node)) {
+        return has_library_node(while_loop->root());
+    }
+    return false;
+}
+
+// Task groups do not nest
+bool is_task_map(structured_control_flow::ControlFlowNode& node) {
+    auto* map_stmt = dynamic_cast<structured_control_flow::Map*>(&node);
+    return map_stmt &&
+           map_stmt->schedule_type().value() == codegen::ScheduleType_BLASTasks.value();
+}
+
+void loop_indvars(structured_control_flow::ControlFlowNode& node, std::set<std::string>& result) {
+    if (auto* loop = dynamic_cast<structured_control_flow::StructuredLoop*>(&node)) {
+        result.insert(loop->indvar()->get_name());
+        loop_indvars(loop->root(), result);
+    } else if (auto* sequence = dynamic_cast<structured_control_flow::Sequence*>(&node)) {
+        for (size_t i = 0; i < sequence->size(); ++i) loop_indvars(sequence->at(i).first, result);
+    } else if (auto* if_else = dynamic_cast<structured_control_flow::IfElse*>(&node)) {
+        for (size_t i = 0; i < if_else->size(); ++i) loop_indvars(if_else->at(i).first, result);
+    } else if (auto* while_loop = dynamic_cast<structured_control_flow::While*>(&node)) {
+        loop_indvars(while_loop->root(), result);
+    }
+}
+
+size_t child_index(structured_control_flow::Sequence& sequence, size_t element_id) {
+    size_t index;
+    for (index = 0; index < sequence.size(); ++index) {
+        if (sequence.at(index).first.element_id() == element_id) break;
+    }
+    return index;
+}
+
+}  // namespace
+
+BLASTaskScheduling::Accesses BLASTaskScheduling::accesses(
+    const StructuredSDFG& sdfg, analysis::Users& users,
+    structured_control_flow::ControlFlowNode& node) const {
+    // Loops initialize their index variables and tasks privatize them, they carry no dependence
+    std::set<std::string> indvars;
+    loop_indvars(node, indvars);
+
+    Accesses result;
+    analysis::UsersView users_view(users, node);
+    for (auto& container : sdfg.containers()) {
+        if (indvars.contains(container)) continue;
+        for (auto* user : users_view.uses(container)) {
+            if (user->use() == analysis::Use::READ)
+                result.reads.insert(container);
+            else
+                result.writes.insert(container);
+        }
+    }
+    return result;
+}
+
+bool BLASTaskScheduling::independent(const Accesses& first, const Accesses& second) const {
+    for (auto& container : first.writes) {
+        if (second.reads.contains(container) || second.writes.contains(container)) return false;
+    }
+    for (auto& container : second.writes) {
+        if (first.reads.contains(container)) return false;
+    }
+    return true;
+}
+
+std::vector<size_t> BLASTaskScheduling::task_group(
+    builder::StructuredSDFGBuilder& builder, analysis::AnalysisManager& analysis_manager) const {
+    auto& sdfg = builder.subject();
+    auto& root = sdfg.root();
+    size_t scop_index, endscop_index;
+    if (!find_instruments(root, scop_index, endscop_index)) return {};
+
+    // Moving a child must not move the assignments of its transition
+    size_t count = endscop_index - scop_index - 1;
+    for (size_t i = 0; i < count; ++i) {
+        if (!root.at(scop_index + 1 + i).second.assignments().empty()) return {};
+    }
+
+    // A child depends on every earlier child it conflicts with, the children of one level are
+    // independent of each other
+    auto& users = analysis_manager.get<analysis::Users>();
+    std::vector<Accesses> accesses;
+    std::vector<std::set<std::string>> indvars(count);
+    std::vector<bool> library(count);
+    std::vector<size_t> levels(count, 0);
+    for (size_t i = 0; i < count; ++i) {
+        auto& child = root.at(scop_index + 1 + i).first;
+        accesses.push_back(this->accesses(sdfg, users, child));
+        loop_indvars(child, indvars.at(i));
+        library.at(i) = has_library_node(child) && !is_task_map(child);
+        for (size_t j = 0; j < i; ++j) {
+            if (!this->independent(accesses.at(j), accesses.at(i)))
+                levels.at(i) = std::max(levels.at(i), levels.at(j) + 1);
+        }
+    }
+
+    for (size_t level = 0; level < count; ++level) {
+        // Tasks privatize their index variables, no later child may see the final values
+        std::vector<size_t> members;
+        for (size_t i = 0; i < count; ++i) {
+            if (!library.at(i) || levels.at(i) != level) continue;
+            bool private_indvars = true;
+            for (size_t j = i + 1; j < count; ++j) {
+                for (auto& indvar : indvars.at(i)) {
+                    if (accesses.at(j).reads.contains(indvar) ||
+                        accesses.at(j).writes.contains(indvar))
+                        private_indvars = false;
+                }
+            }
+            if (private_indvars) members.push_back(i);
+        }
+        if (members.size() < 2) continue;
+
+        // The group runs in place of its last member, the others move past the children in
+        // between
+        size_t last = members.back();
+        std::vector<size_t> group;
+        for (size_t member : members) {
+            bool movable = true;
+            for (size_t j = member + 1; j < last; ++j) {
+                if (std::find(members.begin(), members.end(), j) != members.end()) continue;
+                if (!this->independent(accesses.at(member), accesses.at(j))) movable = false;
+            }
+            if (movable) group.push_back(root.at(scop_index + 1 + member).first.element_id());
+        }
+        if (group.size() >= 2) return group;
+    }
+    return {};
+}
+
+BLASTaskScheduling::BLASTaskScheduling() : Pass() {};
+
+std::string BLASTaskScheduling::name() { return "BLASTaskScheduling"; }
+
+bool BLASTaskScheduling::run_pass(builder::StructuredSDFGBuilder& builder,
+                                  analysis::AnalysisManager& analysis_manager) {
+    auto& root = builder.subject().root();
+
+    bool applied = false;
+    for (auto group = this->task_group(builder, analysis_manager); !group.empty();
+         group = this->task_group(builder, analysis_manager)) {
+        auto& last = root.at(child_index(root, group.back())).first;
+        auto indvar = symbolic::symbol(builder.find_new_name("_tasks"));
+        builder.add_container(indvar->get_name(), types::Scalar(types::PrimitiveType::Int64));
+        auto& task_map =
+            builder
+                .add_map_before(root, last, indvar, symbolic::Lt(indvar, symbolic::one()),
+                                symbolic::zero(), symbolic::add(indvar, symbolic::one()),
+                                codegen::ScheduleType_BLASTasks, {}, last.debug_info())
+                .first;
+
+        // One sequence per task, in the original order of the members
+        for (size_t element_id : group) {
+            auto& task = builder.add_sequence(task_map.root());
+            auto& child = root.at(child_index(root, element_id)).first;
+            builder.insert(child, root, task, child.debug_info());
+        }
+
+        analysis_manager.invalidate_all();
+        applied = true;
+    }
+    return applied;
+}
+
+}  // namespace passes
+}  // namespace sdfg
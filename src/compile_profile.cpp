@@ -0,0 +1,112 @@
+#include "compile_profile.h"
+
+#include <sys/resource.h>
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <string>
+
+namespace {
+
+long peak_rss_kb() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return usage.ru_maxrss;
+}
+
+}  // namespace
+
+double elapsed_seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+CompileProfile::CompileProfile() : start_(std::chrono::steady_clock::now()) {
+    this->stages_.emplace_back("optimize", -1);
+    this->open_stages_.push_back(0);
+}
+
+CompileProfile& CompileProfile::instance() {
+    static CompileProfile profile;
+    return profile;
+}
+
+StageProfile& CompileProfile::current() { return this->stages_.at(this->open_stages_.back()); }
+
+CompileProfile::Stage::Stage(const std::string& name) : start_(std::chrono::steady_clock::now()) {
+    auto& profile = CompileProfile::instance();
+    this->index_ = profile.stages_.size();
+    profile.stages_.emplace_back(name, static_cast<long>(profile.open_stages_.back()));
+    profile.open_stages_.push_back(this->index_);
+}
+
+CompileProfile::Stage::~Stage() {
+    auto& profile = CompileProfile::instance();
+    auto& stage = profile.stages_.at(this->index_);
+    stage.seconds = elapsed_seconds(this->start_);
+    stage.peak_rss_kb = peak_rss_kb();
+    profile.open_stages_.pop_back();
+}
+
+void CompileProfile::record_check(const std::string& transformation, double seconds) {
+    auto& profile = this->current().transformations[transformation];
+    ++profile.attempts;
+    profile.can_be_applied_seconds += seconds;
+}
+
+void CompileProfile::record_apply(const std::string& transformation, double seconds) {
+    auto& profile = this->current().transformations[transformation];
+    ++profile.applied;
+    profile.apply_seconds += seconds;
+    // Transformations invalidate all analyses after applying
+    this->invalidate_analyses();
+}
+
+void CompileProfile::record_analysis(const std::string& analysis, double seconds) {
+    auto& profile = this->current().analyses[analysis];
+    ++profile.requests;
+    profile.seconds += seconds;
+    auto valid = this->analyses_valid_.find(analysis);
+    if (valid == this->analyses_valid_.end() || !valid->second) ++profile.recomputations;
+    this->analyses_valid_[analysis] = true;
+}
+
+void CompileProfile::invalidate_analyses() {
+    for (auto& analysis : this->analyses_valid_) analysis.second = false;
+}
+
+nlohmann::json CompileProfile::stage_json(size_t stage) const {
+    auto& profile = this->stages_.at(stage);
+    nlohmann::json json;
+    json["name"] = profile.name;
+    json["seconds"] = stage == 0 ? elapsed_seconds(this->start_) : profile.seconds;
+    json["peak_rss_kb"] = stage == 0 ? peak_rss_kb() : profile.peak_rss_kb;
+    for (auto& transformation : profile.transformations) {
+        auto& entry = json["transformations"][transformation.first];
+        entry["attempts"] = transformation.second.attempts;
+        entry["applied"] = transformation.second.applied;
+        entry["can_be_applied_seconds"] = transformation.second.can_be_applied_seconds;
+        entry["apply_seconds"] = transformation.second.apply_seconds;
+    }
+    for (auto& analysis : profile.analyses) {
+        auto& entry = json["analyses"][analysis.first];
+        entry["requests"] = analysis.second.requests;
+        entry["recomputations"] = analysis.second.recomputations;
+        entry["seconds"] = analysis.second.seconds;
+    }
+    json["stages"] = nlohmann::json::array();
+    for (size_t i = stage + 1; i < this->stages_.size(); ++i) {
+        if (this->stages_.at(i).parent == static_cast<long>(stage))
+            json["stages"].push_back(this->stage_json(i));
+    }
+    return json;
+}
+
+bool CompileProfile::write(const std::filesystem::path& path) const {
+    std::ofstream out(path);
+    if (!out.good()) return false;
+    out << this->stage_json(0).dump(1) << std::endl;
+    return out.good();
+}
@@ -0,0 +1,235 @@
+#include "cublas_residency.h"
+
+#include <sdfg/analysis/analysis.h>
+#include <sdfg/builder/structured_sdfg_builder.h>
+#include <sdfg/data_flow/access_node.h>
+#include <sdfg/data_flow/library_node.h>
+#include <sdfg/element.h>
+#include <sdfg/structured_control_flow/block.h>
+#include <sdfg/structured_control_flow/control_flow_node.h>
+#include <sdfg/structured_control_flow/if_else.h>
+#include <sdfg/structured_control_flow/map.h>
+#include <sdfg/structured_control_flow/sequence.h>
+#include <sdfg/structured_control_flow/structured_loop.h>
+#include <sdfg/structured_control_flow/while.h>
+#include <sdfg/structured_sdfg.h>
+#include <sdfg/types/scalar.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <set>
+#include <string>
+
+#include "benchmarks.h"
+#include "polybench_node.h"
+#include "timer.h"
+
+namespace sdfg {
+namespace passes {
+
+namespace {
+
+// Arguments of the kernel, the runtime finds their host ranges by the base pointer
+bool is_array(const StructuredSDFG& sdfg, const std::string& container) {
+    if (sdfg.is_transient(container)) return false;
+    return !dynamic_cast<const types::Scalar*>(&sdfg.type(container));
+}
+
+bool is_library_node(const data_flow::DataFlowNode& node) {
+    if (dynamic_cast<const polybench::PolyBenchNode*>(&node)) return false;
+    return dynamic_cast<const data_flow::LibraryNode*>(&node);
+}
+
+void add_residency_node(builder::StructuredSDFGBuilder& builder,
+                        structured_control_flow::Block& block,
+                        const polybench::PolyBenchNodeType type, const std::string& array) {
+    builder.add_library_node<polybench::PolyBenchNode, const polybench::PolyBenchNodeType,
+                             const std::string>(block, DebugInfo(), type, array);
+}
+
+}  // namespace
+
+CUBLASResidency::CUBLASResidency(const Benchmark& benchmark, bool check)
+    : Pass(), benchmark_(benchmark), check_(check) {};
+
+std::string CUBLASResidency::name() { return "CUBLASResidency"; }
+
+std::string CUBLASResidency::array_bytes(const StructuredSDFG& sdfg,
+                                         const std::string& container) const {
+    for (size_t i = 0; i < sdfg.arguments().size(); ++i) {
+        if (sdfg.arguments().at(i) != container) continue;
+        auto& variable = this->benchmark_.variables().at(this->benchmark_.call_variables().at(i));
+        size_t elements = 1;
+        for (size_t dim : variable.dimensions()) {
+            auto& dataset_size = this->benchmark_.dataset_sizes().at(dim);
+            elements *= this->check_ ? dataset_size.medium_size : dataset_size.extralarge_size;
+        }
+        // The cuBLAS calls of the kernels are double precision
+        return std::to_string(elements) + " * sizeof(double)";
+    }
+    return "";
+}
+
+void CUBLASResidency::accesses(const StructuredSDFG& sdfg,
+                               structured_control_flow::ControlFlowNode& node,
+                               Accesses& result) const {
+    if (auto* block = dynamic_cast<structured_control_flow::Block*>(&node)) {
+        auto& dataflow = block->dataflow();
+        bool library = false;
+        for (auto& dataflow_node : dataflow.nodes()) {
+            if (is_library_node(dataflow_node)) library = true;
+        }
+        for (auto& dataflow_node : dataflow.nodes()) {
+            auto* access_node = dynamic_cast<data_flow::AccessNode*>(&dataflow_node);
+            if (!access_node || !is_array(sdfg, access_node->data())) continue;
+
+            // Tasklets next to the calls may only compute scalars, e.g. the fused beta
+            for (auto& oedge : dataflow.out_edges(dataflow_node)) {
+                if (is_library_node(oedge.dst()))
+                    result.device.insert(access_node->data());
+                else if (library)
+                    result.mixed = true;
+                else
+                    result.reads.insert(access_node->data());
+            }
+            for (auto& iedge : dataflow.in_edges(dataflow_node)) {
+                if (is_library_node(iedge.src()))
+                    result.device.insert(access_node->data());
+                else if (library)
+                    result.mixed = true;
+                else
+                    result.writes.insert(access_node->data());
+            }
+        }
+    } else if (auto* sequence = dynamic_cast<structured_control_flow::Sequence*>(&node)) {
+        for (size_t i = 0; i < sequence->size(); ++i) {
+            this->accesses(sdfg, sequence->at(i).first, result);
+        }
+    } else if (auto* map_stmt = dynamic_cast<structured_control_flow::Map*>(&node)) {
+        // The residency is not thread-safe, calls must not run on the threads of a loop
+        Accesses body;
+        this->accesses(sdfg, map_stmt->root(), body);
+        if (!body.device.empty() && map_stmt->schedule_type().value() !=
+                                        structured_control_flow::ScheduleType_Sequential.value())
+            result.mixed = true;
+        result.reads.insert(body.reads.begin(), body.reads.end());
+        result.writes.insert(body.writes.begin(), body.writes.end());
+        result.device.insert(body.device.begin(), body.device.end());
+        result.mixed = result.mixed || body.mixed;
+    } else if (auto* loop = dynamic_cast<structured_control_flow::StructuredLoop*>(&node)) {
+        this->accesses(sdfg, loop->root(), result);
+    } else if (auto* if_else = dynamic_cast<structured_control_flow::IfElse*>(&node)) {
+        for (size_t i = 0; i < if_else->size(); ++i) {
+            this->accesses(sdfg, if_else->at(i).first, result);
+        }
+    } else if (auto* while_loop = dynamic_cast<structured_control_flow::While*>(&node)) {
+        this->accesses(sdfg, while_loop->root(), result);
+    }
+}
+
+void CUBLASResidency::guard(builder::StructuredSDFGBuilder& builder,
+                            structured_control_flow::Sequence& sequence,
+                            const std::set<std::string>& device) const {
+    auto& sdfg = builder.subject();
+    for (size_t i = 0; i < sequence.size(); ++i) {
+        auto& child = sequence.at(i).first;
+        Accesses child_accesses;
+        this->accesses(sdfg, child, child_accesses);
+
+        // Host code between the calls of a nested scope is guarded inside of it
+        if (!child_accesses.device.empty()) {
+            if (auto* nested = dynamic_cast<structured_control_flow::Sequence*>(&child)) {
+                this->guard(builder, *nested, device);
+            } else if (auto* loop =
+                           dynamic_cast<structured_control_flow::StructuredLoop*>(&child)) {
+                this->guard(builder, loop->root(), device);
+            } else if (auto* if_else = dynamic_cast<structured_control_flow::IfElse*>(&child)) {
+                for (size_t j = 0; j < if_else->size(); ++j) {
+                    this->guard(builder, if_else->at(j).first, device);
+                }
+            } else if (auto* while_loop = dynamic_cast<structured_control_flow::While*>(&child)) {
+                this->guard(builder, while_loop->root(), device);
+            }
+            continue;
+        }
+
+        // Partial writes need the rest of the array on the host as well
+        std::set<std::string> touched, written;
+        for (auto& container : child_accesses.reads) {
+            if (device.contains(container)) touched.insert(container);
+        }
+        for (auto& container : child_accesses.writes) {
+            if (!device.contains(container)) continue;
+            touched.insert(container);
+            written.insert(container);
+        }
+        if (touched.empty()) continue;
+
+        auto& download_block = builder.add_block_before(sequence, child).first;
+        for (auto& container : touched) {
+            add_residency_node(builder, download_block, polybench::CUDADownload, container);
+        }
+        ++i;
+        if (written.empty()) continue;
+
+        structured_control_flow::Block* host_write_block;
+        if (i + 1 == sequence.size()) {
+            host_write_block = &builder.add_block(sequence);
+        } else {
+            host_write_block = &builder.add_block_before(sequence, sequence.at(i + 1).first).first;
+        }
+        for (auto& container : written) {
+            add_residency_node(builder, *host_write_block, polybench::CUDAHostWrite, container);
+        }
+        ++i;
+    }
+}
+
+bool CUBLASResidency::run_pass(builder::StructuredSDFGBuilder& builder,
+                               analysis::AnalysisManager& analysis_manager) {
+    auto& sdfg = builder.subject();
+    auto& root = sdfg.root();
+
+    size_t scop_index, endscop_index;
+    if (!find_instruments(root, scop_index, endscop_index)) return false;
+
+    // Without registered arrays the redirected transfers go through unchanged
+    Accesses kernel;
+    this->accesses(sdfg, root, kernel);
+    if (kernel.device.empty() || kernel.mixed) return false;
+
+    this->guard(builder, root, kernel.device);
+
+    // main prints the live-outs after the call, they are downloaded inside the timed region
+    find_instruments(root, scop_index, endscop_index);
+    auto& download_block = builder.add_block_before(root, root.at(endscop_index).first).first;
+    auto& print_variables = this->benchmark_.print_variables();
+    for (size_t i = 0; i < sdfg.arguments().size(); ++i) {
+        auto& argument = sdfg.arguments().at(i);
+        if (!kernel.device.contains(argument)) continue;
+        size_t variable = this->benchmark_.call_variables().at(i);
+        if (std::find(print_variables.begin(), print_variables.end(), variable) ==
+            print_variables.end())
+            continue;
+        add_residency_node(builder, download_block, polybench::CUDADownload, argument);
+    }
+
+    // Transfers only belong to an array if they lie inside of its registered extent
+    auto& register_block = builder.add_block_before(root, root.at(0).first).first;
+    for (auto& container : kernel.device) {
+        auto bytes = this->array_bytes(sdfg, container);
+        if (bytes.empty()) continue;
+        add_residency_node(builder, register_block, polybench::CUDARegister,
+                           container + ", " + bytes);
+    }
+
+    auto& release_block = builder.add_block(root);
+    builder.add_library_node<polybench::PolyBenchNode, const polybench::PolyBenchNodeType>(
+        release_block, DebugInfo(), polybench::CUDARelease);
+
+    analysis_manager.invalidate_all();
+    return true;
+}
+
+}  // namespace passes
+}  // namespace sdfg
@@ -0,0 +1,502 @@
+#include "driver.h"
+
+#include <sched.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "dump.h"
+#include "process.h"
+
+namespace {
+
+const std::vector<Version> VERSIONS = {{"ref", "ref"},
+                                       {"opt_mkl", "optimized_mkl"},
+                                       {"opt_mkl3", "optimized_mkl3"},
+                                       {"intel", "intel"},
+                                       {"polly", "polly"},
+                                       {"pluto", "pluto"},
+                                       {"opt_cublas", "optimized_cublas"},
+                                       {"opt_openblas", "optimized_openblas"},
+                                       {"opt_blis", "optimized_blis"},
+                                       {"opt_cblas", "optimized_cblas"},
+                                       {"opt_builtin", "optimized_builtin"}};
+
+const std::vector<std::string> DEFAULT_VERSIONS = {"ref", "opt_mkl", "opt_mkl3", "polly", "pluto"};
+
+const std::vector<std::string> BENCHMARKS = {"datamining/correlation",
+                                             "datamining/covariance",
+                                             "linear-algebra/blas/gemm",
+                                             "linear-algebra/blas/gemver",
+                                             "linear-algebra/blas/gesummv",
+                                             "linear-algebra/blas/symm",
+                                             "linear-algebra/blas/syr2k",
+                                             "linear-algebra/blas/syrk",
+                                             "linear-algebra/blas/trmm",
+                                             "linear-algebra/kernels/2mm",
+                                             "linear-algebra/kernels/3mm",
+                                             "linear-algebra/kernels/atax",
+                                             "linear-algebra/kernels/bicg",
+                                             "linear-algebra/kernels/doitgen",
+                                             "linear-algebra/kernels/mvt",
+                                             "linear-algebra/solvers/cholesky",
+                                             "linear-algebra/solvers/durbin",
+                                             "linear-algebra/solvers/gramschmidt",
+                                             "linear-algebra/solvers/lu",
+                                             "linear-algebra/solvers/ludcmp",
+                                             "linear-algebra/solvers/trisolv",
+                                             "medley/deriche",
+                                             "medley/floyd-warshall",
+                                             "medley/nussinov",
+                                             "stencils/adi",
+                                             "stencils/fdtd-2d",
+                                             "stencils/heat-3d",
+                                             "stencils/jacobi-1d",
+                                             "stencils/jacobi-2d",
+                                             "stencils/seidel-2d"};
+
+// Thread settings of a run plus the extra variables of the options
+std::vector<std::pair<std::string, std::string>> run_environment(const DriverOptions& options,
+                                                                 size_t omp_threads,
+                                                                 size_t mkl_threads) {
+    auto environment = thread_environment(omp_threads, mkl_threads);
+    environment.insert(environment.end(), options.environment.begin(), options.environment.end());
+    return environment;
+}
+
+// Runs a check binary and reads its dump, binary dumps go through a file below the results
+bool run_check(const DriverOptions& options, const std::filesystem::path& executable,
+               size_t omp_threads, size_t mkl_threads, Dump& dump) {
+    auto environment = run_environment(options, omp_threads, mkl_threads);
+    auto dump_path = std::filesystem::path(options.out_path) / "check.dump";
+    if (options.binary_dumps) environment.push_back({"POLYBENCH_DUMP_FILE", dump_path.string()});
+    auto output = run_process({executable.string()}, environment, options.cpus);
+    if (!output.success) return false;
+    if (options.binary_dumps) return read_binary_dump(dump_path, dump);
+    return parse_text_dump(output.err, dump);
+}
+
+bool matches(const DriverOptions& options, const Dump& reference, const Dump& dump) {
+    std::vector<ArrayComparison> comparisons;
+    if (options.binary_dumps) return compare_dumps(reference, dump, options.tolerance, comparisons);
+    return compare_dumps(reference, dump, {TEXT_TOLERANCE, 0.0, 0}, comparisons);
+}
+
+// Plain runs print one time, runs with in-process repetitions print a JSON object with samples
+bool parse_times(const std::string& out, std::vector<double>& times) {
+    try {
+        size_t json_pos = out.find('{');
+        if (json_pos != std::string::npos) {
+            auto json = nlohmann::json::parse(out.substr(json_pos));
+            for (auto& sample : json.at("samples")) times.push_back(sample.get<double>());
+        } else {
+            times.push_back(std::stod(out));
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+std::string check_status(const DriverOptions& options, const Version& version,
+                         const std::string& benchmark, const Dump& reference) {
+    auto check_exec = std::filesystem::path("bin") / version.long_name / "check" / benchmark;
+    auto run_exec = std::filesystem::path("bin") / version.long_name / "run" / benchmark;
+    if (!std::filesystem::is_regular_file(check_exec) ||
+        !std::filesystem::is_regular_file(run_exec))
+        return "unavailable";
+
+    // Sequential first, a mismatch here is a wrong result rather than a race
+    Dump dump;
+    if (!run_check(options, check_exec, 1, 1, dump)) return "corrupt";
+    if (!matches(options, reference, dump)) return "mismatch";
+
+    Dump parallel_dump;
+    if (!run_check(options, check_exec, options.omp_threads, options.mkl_threads, parallel_dump))
+        return "corrupt";
+    if (!matches(options, reference, parallel_dump)) return "unstable";
+
+    return "good";
+}
+
+// Every thread count step must gain at least this share of its ideal speedup
+const double MIN_STEP_EFFICIENCY = 0.5;
+
+double median(std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    size_t n = samples.size();
+    return n % 2 ? samples.at(n / 2) : 0.5 * (samples.at(n / 2 - 1) + samples.at(n / 2));
+}
+
+std::vector<int> available_cpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+std::vector<int> pinned_cpus(const DriverOptions& options, const std::vector<int>& pool,
+                             size_t threads) {
+    std::vector<int> cpus;
+    size_t count = std::min(threads, pool.size());
+    for (size_t i = 0; i < count; ++i) {
+        if (options.pinning == CompactPinning) {
+            cpus.push_back(pool.at(i));
+        } else {
+            cpus.push_back(pool.at(i * pool.size() / count));
+        }
+    }
+    return cpus;
+}
+
+// Region times of polybench_region_print, the binaries must be optimized with --regions
+void parse_regions(const std::string& err, std::map<std::string, double>& regions) {
+    std::istringstream stream(err);
+    std::string line;
+    bool in_table = false;
+    while (std::getline(stream, line)) {
+        std::istringstream fields(line);
+        std::string name;
+        double time;
+        unsigned long calls;
+        if (!in_table) {
+            in_table = (fields >> name) && name == "region";
+            continue;
+        }
+        if (!(fields >> name >> time >> calls)) break;
+        regions[name] += time;
+    }
+}
+
+// First thread count whose step gained less than MIN_STEP_EFFICIENCY of the ideal speedup,
+// zero while the times keep scaling
+size_t saturation_point(const std::vector<size_t>& threads, const std::vector<double>& times) {
+    for (size_t i = 1; i < threads.size(); ++i) {
+        double step_speedup = times.at(i - 1) / times.at(i);
+        double ideal = static_cast<double>(threads.at(i)) / threads.at(i - 1);
+        if (step_speedup - 1.0 < MIN_STEP_EFFICIENCY * (ideal - 1.0)) return threads.at(i);
+    }
+    return 0;
+}
+
+nlohmann::json scaling(const std::vector<size_t>& threads, const std::vector<double>& times) {
+    std::vector<double> speedup, efficiency;
+    for (size_t i = 0; i < threads.size(); ++i) {
+        speedup.push_back(times.front() / times.at(i));
+        efficiency.push_back(speedup.back() * threads.front() / threads.at(i));
+    }
+    nlohmann::json result;
+    result["median"] = times;
+    result["speedup"] = speedup;
+    result["efficiency"] = efficiency;
+    result["saturation"] = saturation_point(threads, times);
+    return result;
+}
+
+// Strong scaling of one run binary over the thread ladder, OpenMP and MKL get the same count
+bool sweep(const DriverOptions& options, const std::filesystem::path& run_exec,
+           nlohmann::json& result) {
+    std::vector<int> pool = options.cpus.empty() ? available_cpus() : options.cpus;
+    std::vector<size_t> threads;
+    std::vector<double> times;
+    std::map<std::string, std::vector<double>> region_times;
+    for (size_t count : options.thread_ladder) {
+        if (count > pool.size()) break;
+        auto cpus = pinned_cpus(options, pool, count);
+        std::vector<double> samples;
+        std::map<std::string, std::vector<double>> region_samples;
+        for (size_t rep = 0; rep < options.reps; ++rep) {
+            auto output =
+                run_process({run_exec.string()}, run_environment(options, count, count), cpus);
+            std::vector<double> run_times;
+            if (!output.success || !parse_times(output.out, run_times)) {
+                std::cerr << "Could not read the time of " << run_exec << std::endl;
+                return false;
+            }
+            samples.push_back(median(run_times));
+            std::map<std::string, double> regions;
+            parse_regions(output.err, regions);
+            for (auto& region : regions) region_samples[region.first].push_back(region.second);
+        }
+        threads.push_back(count);
+        times.push_back(median(samples));
+        for (auto& region : region_samples) {
+            auto& series = region_times[region.first];
+            // Regions that vanish at some thread count have no comparable series
+            if (series.size() + 1 == threads.size()) series.push_back(median(region.second));
+        }
+    }
+    if (threads.empty()) return false;
+
+    result = scaling(threads, times);
+    result["threads"] = threads;
+    result["flags"] = nlohmann::json::array();
+    if (result["saturation"].get<size_t>() > 0) {
+        result["flags"].push_back("kernel stops scaling at " +
+                                  std::to_string(result["saturation"].get<size_t>()) +
+                                  " threads");
+    }
+    for (auto& region : region_times) {
+        if (region.second.size() != threads.size()) continue;
+        auto region_result = scaling(threads, region.second);
+        // Loop nests scale with the OpenMP code, library calls with the BLAS. Task regions mix
+        // several calls and are not attributed to one of them
+        bool library_call = !region.first.starts_with("loop#") &&
+                            !region.first.starts_with("branch#") &&
+                            !region.first.starts_with("tasks#");
+        size_t saturation = region_result["saturation"].get<size_t>();
+        if (library_call && saturation > 0) {
+            result["flags"].push_back("BLAS call " + region.first + " stops scaling at " +
+                                      std::to_string(saturation) + " threads");
+        }
+        result["regions"][region.first] = region_result;
+    }
+    return true;
+}
+
+void print_scaling(const nlohmann::json& result) {
+    std::ios_base::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+    std::cout << "    threads   ";
+    for (auto& count : result["threads"]) std::cout << std::setw(8) << count.get<size_t>();
+    std::cout << std::endl << "    speedup   ";
+    for (auto& value : result["speedup"])
+        std::cout << std::setw(8) << std::fixed << std::setprecision(2) << value.get<double>();
+    std::cout << std::endl << "    efficiency";
+    for (auto& value : result["efficiency"])
+        std::cout << std::setw(8) << std::fixed << std::setprecision(2) << value.get<double>();
+    std::cout << std::endl;
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+    for (auto& flag : result["flags"]) std::cout << "    " << flag.get<std::string>() << std::endl;
+}
+
+bool parse_list(const std::string& value, std::vector<std::string>& result) {
+    std::stringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) result.push_back(item);
+    }
+    return !result.empty();
+}
+
+bool parse_cpus(const std::string& value, std::vector<int>& cpus) {
+    std::vector<std::string> ranges;
+    if (!parse_list(value, ranges)) return false;
+    try {
+        for (auto& range : ranges) {
+            size_t dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+void print_usage() {
+    std::cerr << "Usage: benchmark_driver [options]" << std::endl
+              << "Options:" << std::endl
+              << "  --versions <a,b,...>    versions to run, default "
+                 "ref,opt_mkl,opt_mkl3,polly,pluto"
+              << std::endl
+              << "  --benchmarks <a,b,...>  benchmark names, default all" << std::endl
+              << "  --reps <n>              runs of every binary" << std::endl
+              << "  --omp-threads <n>       OMP_NUM_THREADS of the parallel runs" << std::endl
+              << "  --mkl-threads <n>       MKL_NUM_THREADS of the parallel runs" << std::endl
+              << "  --cpus <list>           pin the binaries, e.g. 0-23,48-71" << std::endl
+              << "  --out <folder>          folder of the result files" << std::endl
+              << "  --binary-dumps          check binaries built with POLYBENCH_DUMP_BINARY"
+              << std::endl
+              << "  --sweep <a,b,...|all>   strong scaling over the thread counts" << std::endl
+              << "  --pin compact|scatter   placement of the threads in the sweep" << std::endl
+              << "  --env <name>=<value>    extra environment variable of every run, repeatable"
+              << std::endl
+              << "Available versions:";
+    for (auto& version : VERSIONS) std::cerr << " " << version.short_name;
+    std::cerr << std::endl;
+}
+
+bool parse_driver_options(int argc, char* argv[], DriverOptions& options) {
+    std::vector<std::string> versions = DEFAULT_VERSIONS;
+    std::vector<std::string> benchmarks;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "--binary-dumps") {
+            options.binary_dumps = true;
+            continue;
+        }
+        if (i + 1 >= argc) return false;
+        std::string value(argv[++i]);
+        try {
+            if (arg == "--versions") {
+                versions.clear();
+                if (!parse_list(value, versions)) return false;
+            } else if (arg == "--benchmarks") {
+                if (!parse_list(value, benchmarks)) return false;
+            } else if (arg == "--reps") {
+                options.reps = std::stoul(value);
+            } else if (arg == "--omp-threads") {
+                options.omp_threads = std::stoul(value);
+            } else if (arg == "--mkl-threads") {
+                options.mkl_threads = std::stoul(value);
+            } else if (arg == "--cpus") {
+                if (!parse_cpus(value, options.cpus)) return false;
+            } else if (arg == "--out") {
+                options.out_path = value;
+            } else if (arg == "--sweep") {
+                options.sweep = true;
+                if (value == "all") continue;
+                std::vector<std::string> counts;
+                if (!parse_list(value, counts)) return false;
+                for (auto& count : counts) options.thread_ladder.push_back(std::stoul(count));
+            } else if (arg == "--env") {
+                size_t separator = value.find('=');
+                if (separator == 0 || separator == std::string::npos) return false;
+                options.environment.push_back(
+                    {value.substr(0, separator), value.substr(separator + 1)});
+            } else if (arg == "--pin") {
+                if (value == "compact") {
+                    options.pinning = CompactPinning;
+                } else if (value == "scatter") {
+                    options.pinning = ScatterPinning;
+                } else {
+                    return false;
+                }
+            } else {
+                return false;
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    for (auto& name : versions) {
+        bool found = false;
+        for (auto& version : VERSIONS) {
+            if (version.short_name != name) continue;
+            options.versions.push_back(version);
+            found = true;
+        }
+        if (!found) {
+            std::cerr << "Unknown version: " << name << std::endl;
+            return false;
+        }
+    }
+
+    // Benchmarks are given by their name without the category
+    for (auto& path : BENCHMARKS) {
+        std::string name = std::filesystem::path(path).filename().string();
+        bool selected = benchmarks.empty();
+        for (auto& benchmark : benchmarks) selected |= benchmark == name || benchmark == "all";
+        if (selected) options.benchmarks.push_back(path);
+    }
+    for (auto& benchmark : benchmarks) {
+        bool found = benchmark == "all";
+        for (auto& path : BENCHMARKS) {
+            found |= std::filesystem::path(path).filename().string() == benchmark;
+        }
+        if (!found) {
+            std::cerr << "Unknown benchmark: " << benchmark << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+}  // namespace
+
+int drive(int argc, char* argv[]) {
+    DriverOptions options;
+    if (!parse_driver_options(argc, argv, options)) {
+        print_usage();
+        return 1;
+    }
+
+    std::filesystem::create_directories(options.out_path);
+    if (options.sweep && options.thread_ladder.empty()) {
+        size_t cpus = options.cpus.empty() ? available_cpus().size() : options.cpus.size();
+        for (size_t count = 1; count < cpus; count *= 2) options.thread_ladder.push_back(count);
+        options.thread_ladder.push_back(cpus);
+    }
+
+    // One pass over the benchmarks runs all versions back to back, drifts of the machine then
+    // affect all versions of a benchmark alike
+    std::unordered_map<std::string, nlohmann::json> results;
+    int failures = 0;
+    for (auto& benchmark : options.benchmarks) {
+        std::cout << "Got benchmark " << benchmark << std::endl;
+
+        Dump reference;
+        auto ref_exec = std::filesystem::path("bin") / "ref" / "check" / benchmark;
+        bool has_reference = std::filesystem::is_regular_file(ref_exec) &&
+                             run_check(options, ref_exec, 1, 1, reference);
+
+        for (auto& version : options.versions) {
+            auto& result = results[version.short_name][benchmark];
+            std::string status = "corrupt";
+            if (has_reference) status = check_status(options, version, benchmark, reference);
+            result["status"] = status;
+            std::cout << "  " << version.short_name << ": " << status << std::endl;
+            if (status != "good" && status != "unstable") {
+                if (status != "unavailable") ++failures;
+                continue;
+            }
+
+            auto run_exec = std::filesystem::path("bin") / version.long_name / "run" / benchmark;
+            if (options.sweep) {
+                if (!sweep(options, run_exec, result["scaling"])) {
+                    ++failures;
+                    continue;
+                }
+                print_scaling(result["scaling"]);
+                continue;
+            }
+            auto environment = run_environment(options, options.omp_threads, options.mkl_threads);
+            std::vector<double> times;
+            for (size_t rep = 0; rep < options.reps; ++rep) {
+                auto output = run_process({run_exec.string()}, environment, options.cpus);
+                if (!output.success || !parse_times(output.out, times)) {
+                    std::cerr << "Could not read the time of " << run_exec << std::endl;
+                    ++failures;
+                    break;
+                }
+            }
+            result["data"] = times;
+        }
+    }
+
+    // Sweeps go to their own folder, results.py expects the fixed thread settings
+    auto out_path = std::filesystem::path(options.out_path);
+    if (options.sweep) {
+        out_path /= "scaling";
+        std::filesystem::create_directories(out_path);
+    }
+    for (auto& version : options.versions) {
+        auto path = out_path / (version.short_name + ".json");
+        std::ofstream out(path);
+        out << results[version.short_name].dump(1) << std::endl;
+        std::cout << "Output written to file " << path.string() << std::endl;
+    }
+
+    return failures;
+}
@@ -0,0 +1,248 @@
+#include "dump.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char BINARY_MAGIC[] = "PBDUMP1\n";
+
+template <typename T>
+bool read_value(std::ifstream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+std::string shape_string(const std::vector<uint64_t>& shape) {
+    std::stringstream stream;
+    for (size_t i = 0; i < shape.size(); ++i) stream << (i > 0 ? "x" : "") << shape.at(i);
+    return stream.str();
+}
+
+// The reference sources do not record shapes, their arrays are dumped as one dimension
+bool same_shape(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b) {
+    return a == b || a.size() == 1 || b.size() == 1;
+}
+
+void print_usage() {
+    std::cerr << "Usage: dump_compare <dump> [reference dump] [options]" << std::endl
+              << "With one dump the checksums of its arrays are printed." << std::endl
+              << "Options:" << std::endl
+              << "  --abs <x>   absolute tolerance" << std::endl
+              << "  --rel <x>   relative tolerance" << std::endl
+              << "  --ulps <n>  tolerance in units in the last place" << std::endl;
+}
+
+}  // namespace
+
+bool parse_text_dump(const std::string& text, Dump& dump) {
+    const std::string begin = "==BEGIN DUMP_ARRAYS==\n";
+    const std::string end = "==END   DUMP_ARRAYS==";
+    size_t begin_pos = text.find(begin);
+    if (begin_pos == std::string::npos) return false;
+    begin_pos += begin.size();
+    size_t end_pos = text.find(end, begin_pos);
+    if (end_pos == std::string::npos) return false;
+
+    const std::string marker = "begin dump: ";
+    std::string region = text.substr(begin_pos, end_pos - begin_pos);
+    size_t pos = region.find(marker);
+    while (pos != std::string::npos) {
+        size_t next = region.find(marker, pos + marker.size());
+        std::istringstream stream(region.substr(pos + marker.size(), next - pos - marker.size()));
+        std::vector<std::string> tokens;
+        std::string token;
+        while (stream >> token) tokens.push_back(token);
+
+        // <name> <values...> end dump: <name>
+        if (tokens.size() < 4 || tokens.front() != tokens.back()) {
+            std::cerr << "Variable at beginning and end of dump do not match" << std::endl;
+            return false;
+        }
+        auto& array = dump[tokens.front()];
+        for (size_t i = 1; i + 3 < tokens.size(); ++i) {
+            try {
+                array.values.push_back(std::stod(tokens.at(i)));
+            } catch (const std::exception&) {
+                array.values.push_back(NAN);
+            }
+        }
+        array.shape = {array.values.size()};
+        pos = next;
+    }
+    return true;
+}
+
+bool read_binary_dump(const std::filesystem::path& path, Dump& dump) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        std::cerr << "Could not open dump " << path.string() << std::endl;
+        return false;
+    }
+    std::string magic(sizeof(BINARY_MAGIC) - 1, '\0');
+    if (!in.read(magic.data(), magic.size()) || magic != BINARY_MAGIC) {
+        std::cerr << path.string() << " is not a binary dump" << std::endl;
+        return false;
+    }
+
+    uint32_t name_length;
+    while (read_value(in, name_length)) {
+        std::string name(name_length, '\0');
+        uint32_t nb_dims;
+        uint64_t count;
+        if (!in.read(name.data(), name_length) || !read_value(in, nb_dims)) return false;
+        auto& array = dump[name];
+        array.shape.resize(nb_dims);
+        if (!in.read(reinterpret_cast<char*>(array.shape.data()), nb_dims * sizeof(uint64_t)) ||
+            !read_value(in, count))
+            return false;
+        array.values.resize(count);
+        if (!in.read(reinterpret_cast<char*>(array.values.data()), count * sizeof(double))) {
+            std::cerr << path.string() << ": " << name << " is truncated" << std::endl;
+            return false;
+        }
+    }
+    return in.eof();
+}
+
+uint64_t checksum(const std::vector<double>& values) {
+    uint64_t hash = 14695981039346656037ull;
+    for (double value : values) {
+        uint64_t bits = std::bit_cast<uint64_t>(value);
+        for (size_t i = 0; i < sizeof(bits); ++i) {
+            hash ^= (bits >> (8 * i)) & 0xff;
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+uint64_t ulp_distance(double a, double b) {
+    if (std::isnan(a) || std::isnan(b)) return std::numeric_limits<uint64_t>::max();
+    // Map the sign-magnitude bit patterns onto a monotonic integer line
+    auto ordered = [](double value) {
+        int64_t bits = std::bit_cast<int64_t>(value);
+        return bits < 0 ? std::numeric_limits<int64_t>::min() - bits : bits;
+    };
+    int64_t x = ordered(a), y = ordered(b);
+    return x > y ? static_cast<uint64_t>(x) - static_cast<uint64_t>(y)
+                 : static_cast<uint64_t>(y) - static_cast<uint64_t>(x);
+}
+
+bool compare_dumps(const Dump& reference, const Dump& dump, const Tolerance& tolerance,
+                   std::vector<ArrayComparison>& comparisons) {
+    bool all_match = reference.size() == dump.size();
+    for (auto& array : dump) {
+        if (!reference.contains(array.first)) {
+            std::cerr << "Variable " << array.first << " does not occur in the reference"
+                      << std::endl;
+        }
+    }
+
+    for (auto& array : reference) {
+        ArrayComparison comparison;
+        comparison.name = array.first;
+        auto it = dump.find(array.first);
+        if (it == dump.end()) {
+            std::cerr << "Variable " << array.first << " does not occur in both outputs"
+                      << std::endl;
+            comparison.match = false;
+        } else if (it->second.values.size() != array.second.values.size() ||
+                   !same_shape(array.second.shape, it->second.shape)) {
+            std::cerr << array.first << ": Different shapes (" << shape_string(array.second.shape)
+                      << " != " << shape_string(it->second.shape) << ")" << std::endl;
+            comparison.match = false;
+        } else {
+            for (size_t i = 0; i < array.second.values.size(); ++i) {
+                double a = array.second.values.at(i), b = it->second.values.at(i);
+                if (a == b || (std::isnan(a) && std::isnan(b))) continue;
+                double absolute = std::abs(a - b);
+                double relative = absolute / std::max(std::abs(a), std::abs(b));
+                uint64_t ulps = ulp_distance(a, b);
+                comparison.max_absolute_error = std::max(comparison.max_absolute_error, absolute);
+                comparison.max_relative_error = std::max(comparison.max_relative_error, relative);
+                comparison.max_ulps = std::max(comparison.max_ulps, ulps);
+                if (absolute <= tolerance.absolute || relative <= tolerance.relative ||
+                    ulps <= tolerance.ulps)
+                    continue;
+                if (comparison.mismatches++ == 0) {
+                    comparison.first_mismatch = i;
+                    std::cerr << array.first << ": Values do not match at " << i << " ("
+                              << std::setprecision(17) << a << " != " << b << ")" << std::endl;
+                }
+                comparison.match = false;
+            }
+        }
+        all_match &= comparison.match;
+        comparisons.push_back(comparison);
+    }
+    return all_match;
+}
+
+int dump_compare(int argc, char* argv[]) {
+    std::vector<std::filesystem::path> paths;
+    Tolerance tolerance;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg.starts_with("--")) {
+            if (i + 1 >= argc) {
+                print_usage();
+                return 2;
+            }
+            try {
+                if (arg == "--abs") {
+                    tolerance.absolute = std::stod(argv[++i]);
+                } else if (arg == "--rel") {
+                    tolerance.relative = std::stod(argv[++i]);
+                } else if (arg == "--ulps") {
+                    tolerance.ulps = std::stoull(argv[++i]);
+                } else {
+                    print_usage();
+                    return 2;
+                }
+            } catch (const std::exception&) {
+                print_usage();
+                return 2;
+            }
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty() || paths.size() > 2) {
+        print_usage();
+        return 2;
+    }
+
+    std::vector<Dump> dumps(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!read_binary_dump(paths.at(i), dumps.at(i))) return 2;
+    }
+
+    for (auto& array : dumps.front()) {
+        std::cout << array.first << " " << shape_string(array.second.shape) << " "
+                  << std::hex << std::setw(16) << std::setfill('0')
+                  << checksum(array.second.values) << std::dec << std::setfill(' ') << std::endl;
+    }
+    if (paths.size() == 1) return 0;
+
+    std::vector<ArrayComparison> comparisons;
+    bool match = compare_dumps(dumps.at(1), dumps.at(0), tolerance, comparisons);
+    for (auto& comparison : comparisons) {
+        std::cout << comparison.name << ": " << (comparison.match ? "match" : "mismatch")
+                  << ", mismatches " << comparison.mismatches << ", max abs error "
+                  << comparison.max_absolute_error << ", max rel error "
+                  << comparison.max_relative_error << ", max ulps " << comparison.max_ulps
+                  << std::endl;
+    }
+    return match ? 0 : 1;
+}
@@ -4,6 +4,8 @@
 #include <sdfg/analysis/loop_analysis.h>
 #include <sdfg/builder/structured_sdfg_builder.h>
 #include <sdfg/codegen/utils.h>
+#include <sdfg/data_flow/access_node.h>
+#include <sdfg/data_flow/library_node.h>
 #include <sdfg/einsum/einsum_node.h>
 #include <sdfg/passes/pass.h>
 #include <sdfg/passes/structured_control_flow/block_fusion.h>
@@ -21,20 +23,162 @@
 #include <sdfg/transformations/einsum_lift.h>
 #include <sdfg/transformations/loop_distribute.h>
 
+#include <algorithm>
+#include <chrono>
+#include <exception>
 #include <functional>
 #include <iostream>
 #include <list>
+#include <set>
+#include <nlohmann/json.hpp>
 #include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "blas_batching.h"
+#include "blas_output_expansion.h"
+#include "blas_scaling_fusion.h"
+#include "compile_profile.h"
 #include "loop_consume_assignments.h"
+#include "loop_fusion.h"
+#include "loop_vectorize.h"
 #include "my_loop_distribute.h"
 
 namespace sdfg {
 namespace passes {
 
+namespace {
+
+// Checks and applies a transformation, both steps are recorded in the compile profile and
+// applied transformations in the recipe
+template <typename T>
+bool try_apply(T& transformation, const std::string& name,
+               builder::StructuredSDFGBuilder& builder,
+               analysis::AnalysisManager& analysis_manager, nlohmann::json& recipe) {
+    auto& profile = CompileProfile::instance();
+    auto start = std::chrono::steady_clock::now();
+    bool applicable = transformation.can_be_applied(builder, analysis_manager);
+    profile.record_check(name, elapsed_seconds(start));
+    if (!applicable) return false;
+
+    // The description refers to elements that applying may remove
+    nlohmann::json step;
+    step["transformation"] = name;
+    transformation.to_json(step["description"]);
+    recipe["steps"].push_back(step);
+
+    start = std::chrono::steady_clock::now();
+    transformation.apply(builder, analysis_manager);
+    profile.record_apply(name, elapsed_seconds(start));
+    std::cout << "Applied " << name << std::endl;
+    return true;
+}
+
+analysis::LoopAnalysis& loop_analysis(analysis::AnalysisManager& analysis_manager) {
+    auto start = std::chrono::steady_clock::now();
+    auto& result = analysis_manager.get<analysis::LoopAnalysis>();
+    CompileProfile::instance().record_analysis("LoopAnalysis", elapsed_seconds(start));
+    return result;
+}
+
+bool run_nested(Pass& pass, builder::StructuredSDFGBuilder& builder,
+                analysis::AnalysisManager& analysis_manager) {
+    bool applied = pass.run(builder, analysis_manager);
+    if (applied) CompileProfile::instance().invalidate_analyses();
+    return applied;
+}
+
+// Applies one recorded transformation, a single check guards against recipes of another SDFG
+template <typename T>
+bool replay_step(const std::string& name, const nlohmann::json& description,
+                 builder::StructuredSDFGBuilder& builder,
+                 analysis::AnalysisManager& analysis_manager) {
+    auto& profile = CompileProfile::instance();
+    auto start = std::chrono::steady_clock::now();
+    auto transformation = T::from_json(builder, description);
+    bool applicable = transformation.can_be_applied(builder, analysis_manager);
+    profile.record_check(name, elapsed_seconds(start));
+    if (!applicable) return false;
+
+    start = std::chrono::steady_clock::now();
+    transformation.apply(builder, analysis_manager);
+    profile.record_apply(name, elapsed_seconds(start));
+    std::cout << "Replayed " << name << std::endl;
+    return true;
+}
+
+// BlockFusion orders the fused blocks by the containers one writes and the next reads. Containers
+// of reference memlets are not ordered otherwise, e.g. a write through a pointer may move in front
+// of the block that sets the pointer. Runs of consecutive blocks fuse into one, so every pair of a
+// run is checked.
+bool block_fusion_legal(structured_control_flow::Sequence& sequence) {
+    struct Accesses {
+        std::set<std::string> reads;
+        std::set<std::string> writes;
+        std::set<std::string> references;
+        // Earlier blocks of the run the block reads the results of, directly or transitively
+        std::vector<bool> after;
+    };
+    auto accessed = [](const Accesses& accesses, const std::string& container) {
+        return accesses.reads.contains(container) || accesses.writes.contains(container);
+    };
+
+    std::vector<Accesses> run;
+    for (size_t i = 0; i < sequence.size(); ++i) {
+        auto* block = dynamic_cast<structured_control_flow::Block*>(&sequence.at(i).first);
+        if (!block) {
+            run.clear();
+            continue;
+        }
+
+        Accesses accesses;
+        auto& dataflow = block->dataflow();
+        for (auto& node : dataflow.nodes()) {
+            auto* access_node = dynamic_cast<data_flow::AccessNode*>(&node);
+            if (!access_node) continue;
+            for (auto& oedge : dataflow.out_edges(*access_node)) {
+                accesses.reads.insert(access_node->data());
+                if (oedge.src_conn() == "refs" || oedge.dst_conn() == "refs")
+                    accesses.references.insert(access_node->data());
+            }
+            for (auto& iedge : dataflow.in_edges(*access_node)) {
+                accesses.writes.insert(access_node->data());
+                if (iedge.src_conn() == "refs" || iedge.dst_conn() == "refs")
+                    accesses.references.insert(access_node->data());
+            }
+        }
+
+        accesses.after.resize(run.size(), false);
+        for (size_t j = run.size(); j-- > 0;) {
+            for (auto& container : accesses.reads) {
+                if (run.at(j).writes.contains(container)) accesses.after.at(j) = true;
+            }
+            if (!accesses.after.at(j)) continue;
+            for (size_t k = 0; k < j; ++k) {
+                if (run.at(j).after.at(k)) accesses.after.at(k) = true;
+            }
+        }
+
+        // A container referenced by either block, written by either and accessed by both
+        for (size_t j = 0; j < run.size(); ++j) {
+            auto& earlier = run.at(j);
+            if (accesses.after.at(j)) continue;
+            std::set<std::string> references = earlier.references;
+            references.insert(accesses.references.begin(), accesses.references.end());
+            for (auto& container : references) {
+                if (!accessed(earlier, container) || !accessed(accesses, container)) continue;
+                if (earlier.writes.contains(container) || accesses.writes.contains(container))
+                    return false;
+            }
+        }
+        run.push_back(accesses);
+    }
+    return true;
+}
+
+}  // namespace
+
 std::vector<std::pair<std::vector<std::reference_wrapper<structured_control_flow::StructuredLoop>>,
                       structured_control_flow::Block&>>
 EinsumPipeline::get_einsum_loops(builder::StructuredSDFGBuilder& builder) {
@@ -189,12 +333,155 @@ std::vector<std::reference_wrapper<einsum::EinsumNode>> EinsumPipeline::get_eins
     return result;
 }
 
+std::vector<std::pair<structured_control_flow::StructuredLoop&, data_flow::LibraryNode&>>
+EinsumPipeline::get_library_node_predecessor_loops(builder::StructuredSDFGBuilder& builder) {
+    std::vector<std::pair<structured_control_flow::StructuredLoop&, data_flow::LibraryNode&>>
+        result;
+
+    std::list<structured_control_flow::ControlFlowNode*> queue = {&builder.subject().root()};
+    while (!queue.empty()) {
+        auto* current = queue.front();
+        queue.pop_front();
+
+        if (auto* loop = dynamic_cast<structured_control_flow::StructuredLoop*>(current)) {
+            queue.push_back(&loop->root());
+        } else if (dynamic_cast<structured_control_flow::Block*>(current)) {
+            continue;
+        } else if (auto* sequence = dynamic_cast<structured_control_flow::Sequence*>(current)) {
+            for (size_t i = 0; i < sequence->size(); ++i) {
+                queue.push_back(&sequence->at(i).first);
+                if (i + 1 >= sequence->size()) continue;
+                auto* loop =
+                    dynamic_cast<structured_control_flow::StructuredLoop*>(&sequence->at(i).first);
+                auto* block =
+                    dynamic_cast<structured_control_flow::Block*>(&sequence->at(i + 1).first);
+                if (!loop || !block) continue;
+                for (auto& node : block->dataflow().nodes()) {
+                    if (auto* library_node = dynamic_cast<data_flow::LibraryNode*>(&node))
+                        result.push_back({*loop, *library_node});
+                }
+            }
+        } else if (auto* if_else = dynamic_cast<structured_control_flow::IfElse*>(current)) {
+            for (size_t i = 0; i < if_else->size(); ++i) {
+                queue.push_back(&if_else->at(i).first);
+            }
+        } else if (auto* while_loop = dynamic_cast<structured_control_flow::While*>(current)) {
+            queue.push_back(&while_loop->root());
+        } else if (dynamic_cast<structured_control_flow::Break*>(current)) {
+            continue;
+        } else if (dynamic_cast<structured_control_flow::Continue*>(current)) {
+            continue;
+        } else if (dynamic_cast<structured_control_flow::Return*>(current)) {
+            continue;
+        } else {
+            throw std::runtime_error("Unsupported control flow node type");
+        }
+    }
+
+    return result;
+}
+
+std::vector<std::pair<structured_control_flow::StructuredLoop&,
+                      structured_control_flow::StructuredLoop&>>
+EinsumPipeline::get_adjacent_loops(builder::StructuredSDFGBuilder& builder) {
+    std::vector<std::pair<structured_control_flow::StructuredLoop&,
+                          structured_control_flow::StructuredLoop&>>
+        result;
+
+    std::list<structured_control_flow::ControlFlowNode*> queue = {&builder.subject().root()};
+    while (!queue.empty()) {
+        auto* current = queue.front();
+        queue.pop_front();
+
+        if (auto* loop = dynamic_cast<structured_control_flow::StructuredLoop*>(current)) {
+            queue.push_back(&loop->root());
+        } else if (dynamic_cast<structured_control_flow::Block*>(current)) {
+            continue;
+        } else if (auto* sequence = dynamic_cast<structured_control_flow::Sequence*>(current)) {
+            for (size_t i = 0; i < sequence->size(); ++i) {
+                queue.push_back(&sequence->at(i).first);
+                if (i + 1 >= sequence->size()) continue;
+                auto* first_loop = dynamic_cast<structured_control_flow::StructuredLoop*>(
+                    &sequence->at(i).first);
+                auto* second_loop = dynamic_cast<structured_control_flow::StructuredLoop*>(
+                    &sequence->at(i + 1).first);
+                if (first_loop && second_loop) result.push_back({*first_loop, *second_loop});
+            }
+        } else if (auto* if_else = dynamic_cast<structured_control_flow::IfElse*>(current)) {
+            for (size_t i = 0; i < if_else->size(); ++i) {
+                queue.push_back(&if_else->at(i).first);
+            }
+        } else if (auto* while_loop = dynamic_cast<structured_control_flow::While*>(current)) {
+            queue.push_back(&while_loop->root());
+        } else if (dynamic_cast<structured_control_flow::Break*>(current)) {
+            continue;
+        } else if (dynamic_cast<structured_control_flow::Continue*>(current)) {
+            continue;
+        } else if (dynamic_cast<structured_control_flow::Return*>(current)) {
+            continue;
+        } else {
+            throw std::runtime_error("Unsupported control flow node type");
+        }
+    }
+
+    return result;
+}
+
+std::vector<std::reference_wrapper<structured_control_flow::StructuredLoop>>
+EinsumPipeline::get_loops(builder::StructuredSDFGBuilder& builder) {
+    std::vector<std::reference_wrapper<structured_control_flow::StructuredLoop>> result;
+
+    std::list<structured_control_flow::ControlFlowNode*> queue = {&builder.subject().root()};
+    while (!queue.empty()) {
+        auto* current = queue.front();
+        queue.pop_front();
+
+        if (auto* loop = dynamic_cast<structured_control_flow::StructuredLoop*>(current)) {
+            result.push_back(*loop);
+            queue.push_back(&loop->root());
+        } else if (dynamic_cast<structured_control_flow::Block*>(current)) {
+            continue;
+        } else if (auto* sequence = dynamic_cast<structured_control_flow::Sequence*>(current)) {
+            for (size_t i = 0; i < sequence->size(); ++i) {
+                queue.push_back(&sequence->at(i).first);
+            }
+        } else if (auto* if_else = dynamic_cast<structured_control_flow::IfElse*>(current)) {
+            for (size_t i = 0; i < if_else->size(); ++i) {
+                queue.push_back(&if_else->at(i).first);
+            }
+        } else if (auto* while_loop = dynamic_cast<structured_control_flow::While*>(current)) {
+            queue.push_back(&while_loop->root());
+        } else if (dynamic_cast<structured_control_flow::Break*>(current)) {
+            continue;
+        } else if (dynamic_cast<structured_control_flow::Continue*>(current)) {
+            continue;
+        } else if (dynamic_cast<structured_control_flow::Return*>(current)) {
+            continue;
+        } else {
+            throw std::runtime_error("Unsupported control flow node type");
+        }
+    }
+
+    return result;
+}
+
 void EinsumPipeline::block_fusion(builder::StructuredSDFGBuilder& builder,
                                   analysis::AnalysisManager& analysis_manager,
                                   structured_control_flow::Sequence& parent,
                                   structured_control_flow::Sequence& node) {
-    BlockFusion block_fusion(builder, analysis_manager);
-    if (block_fusion.accept(parent, node)) std::cout << "Applied BlockFusion" << std::endl;
+    // The visitor checks and applies in one call, the profile attributes it to the check. It does
+    // not check the dependences between the blocks, sequences it could reorder keep their blocks.
+    auto start = std::chrono::steady_clock::now();
+    bool fused = false;
+    if (block_fusion_legal(node)) {
+        BlockFusion block_fusion(builder, analysis_manager);
+        fused = block_fusion.accept(parent, node);
+    }
+    CompileProfile::instance().record_check("BlockFusion", elapsed_seconds(start));
+    if (fused) {
+        CompileProfile::instance().record_apply("BlockFusion", 0.0);
+        std::cout << "Applied BlockFusion" << std::endl;
+    }
 
     std::list<structured_control_flow::ControlFlowNode*> queue;
     for (size_t i = 0; i < node.size(); ++i) queue.push_back(&node.at(i).first);
@@ -226,144 +513,357 @@ void EinsumPipeline::block_fusion(builder::StructuredSDFGBuilder& builder,
     }
 }
 
-EinsumPipeline::EinsumPipeline(BLASImplementation impl) : Pass(), impl_(impl) {}
-
-std::string EinsumPipeline::name() { return "EinsumPipeline"; }
-
-bool EinsumPipeline::run_pass(builder::StructuredSDFGBuilder& builder,
-                              analysis::AnalysisManager& analysis_manager) {
+bool EinsumPipeline::search(builder::StructuredSDFGBuilder& builder,
+                            analysis::AnalysisManager& analysis_manager) {
     bool applied;
 
     // LoopNormalization
-    LoopNormalization loop_normalization;
-    if (loop_normalization.run(builder, analysis_manager))
-        std::cout << "Applied LoopNormalization" << std::endl;
+    {
+        CompileProfile::Stage stage("LoopNormalization");
+        LoopNormalization loop_normalization;
+        if (run_nested(loop_normalization, builder, analysis_manager))
+            std::cout << "Applied LoopNormalization" << std::endl;
+        this->recipe_["steps"].push_back({{"pass", "LoopNormalization"}});
+    }
 
     // LoopDistribute & MyLoopDistribute
-    do {
-        applied = false;
-        auto& loop_analysis = analysis_manager.get<analysis::LoopAnalysis>();
-        for (auto* node : loop_analysis.loops()) {
-            if (auto* loop = dynamic_cast<structured_control_flow::StructuredLoop*>(node)) {
-                transformations::LoopDistribute transformation(*loop);
-                if (transformation.can_be_applied(builder, analysis_manager)) {
-                    transformation.apply(builder, analysis_manager);
-                    std::cout << "Applied LoopDistribute" << std::endl;
-                    applied = true;
-                    break;
-                }
-                transformations::MyLoopDistribute my_transformation(*loop);
-                if (my_transformation.can_be_applied(builder, analysis_manager)) {
-                    my_transformation.apply(builder, analysis_manager);
-                    std::cout << "Applied MyLoopDistribute" << std::endl;
-                    applied = true;
-                    break;
+    {
+        CompileProfile::Stage stage("LoopDistribute");
+        do {
+            applied = false;
+            for (auto* node : loop_analysis(analysis_manager).loops()) {
+                if (auto* loop = dynamic_cast<structured_control_flow::StructuredLoop*>(node)) {
+                    transformations::LoopDistribute transformation(*loop);
+                    if (try_apply(transformation, "LoopDistribute", builder,
+                                  analysis_manager, this->recipe_)) {
+                        applied = true;
+                        break;
+                    }
+                    transformations::MyLoopDistribute my_transformation(*loop);
+                    if (try_apply(my_transformation, "MyLoopDistribute", builder,
+                                  analysis_manager, this->recipe_)) {
+                        applied = true;
+                        break;
+                    }
                 }
             }
-        }
-    } while (applied);
+        } while (applied);
+    }
 
     // BlockFusion
-    this->block_fusion(builder, analysis_manager, builder.subject().root(),
-                       builder.subject().root());
+    {
+        CompileProfile::Stage stage("BlockFusion");
+        this->block_fusion(builder, analysis_manager, builder.subject().root(),
+                           builder.subject().root());
+        this->recipe_["steps"].push_back({{"pass", "BlockFusion"}});
+    }
 
     // LoopConsumeAssignments
-    do {
-        applied = false;
-        auto& loop_analysis = analysis_manager.get<analysis::LoopAnalysis>();
-        for (auto* node : loop_analysis.loops()) {
-            if (auto* loop = dynamic_cast<structured_control_flow::StructuredLoop*>(node)) {
-                transformations::LoopConsumeAssignments transformation(*loop);
-                if (transformation.can_be_applied(builder, analysis_manager)) {
-                    transformation.apply(builder, analysis_manager);
-                    std::cout << "Applied LoopConsumeAssignment" << std::endl;
-                    applied = true;
-                    break;
+    {
+        CompileProfile::Stage stage("LoopConsumeAssignments");
+        do {
+            applied = false;
+            for (auto* node : loop_analysis(analysis_manager).loops()) {
+                if (auto* loop = dynamic_cast<structured_control_flow::StructuredLoop*>(node)) {
+                    transformations::LoopConsumeAssignments transformation(*loop);
+                    if (try_apply(transformation, "LoopConsumeAssignments", builder,
+                                  analysis_manager, this->recipe_)) {
+                        applied = true;
+                        break;
+                    }
                 }
             }
-        }
-    } while (applied);
+        } while (applied);
+    }
 
     // DeadCFGElimination
-    passes::DeadCFGElimination dead_cfg_elimination;
-    if (dead_cfg_elimination.run(builder, analysis_manager)) {
-        std::cout << "DeadCFGElimination" << std::endl;
+    {
+        CompileProfile::Stage stage("DeadCFGElimination");
+        passes::DeadCFGElimination dead_cfg_elimination;
+        if (run_nested(dead_cfg_elimination, builder, analysis_manager)) {
+            std::cout << "DeadCFGElimination" << std::endl;
+        }
+        this->recipe_["steps"].push_back({{"pass", "DeadCFGElimination"}});
     }
 
     // EinsumLift
-    do {
-        applied = false;
-        auto einsum_loops = this->get_einsum_loops(builder);
-        for (auto& einsum_loop : einsum_loops) {
-            transformations::EinsumLift transformation(einsum_loop.first, einsum_loop.second);
-            if (transformation.can_be_applied(builder, analysis_manager)) {
-                transformation.apply(builder, analysis_manager);
-                std::cout << "Applied EinsumLift" << std::endl;
-                applied = true;
-                break;
+    {
+        CompileProfile::Stage stage("EinsumLift");
+        do {
+            applied = false;
+            auto einsum_loops = this->get_einsum_loops(builder);
+            for (auto& einsum_loop : einsum_loops) {
+                transformations::EinsumLift transformation(einsum_loop.first, einsum_loop.second);
+                if (try_apply(transformation, "EinsumLift", builder,
+                              analysis_manager, this->recipe_)) {
+                    applied = true;
+                    break;
+                }
             }
-        }
-    } while (applied);
+        } while (applied);
+    }
 
     // EinsumExpand
-    do {
-        applied = false;
-        auto einsum_node_loops = this->get_einsum_node_loops(builder);
-        for (auto& einsum_node_loop : einsum_node_loops) {
-            transformations::EinsumExpand transformation(einsum_node_loop.first,
-                                                         einsum_node_loop.second);
-            if (transformation.can_be_applied(builder, analysis_manager)) {
-                transformation.apply(builder, analysis_manager);
-                std::cout << "Applied EinsumExpand" << std::endl;
-                applied = true;
-                break;
+    {
+        CompileProfile::Stage stage("EinsumExpand");
+        do {
+            applied = false;
+            auto einsum_node_loops = this->get_einsum_node_loops(builder);
+            for (auto& einsum_node_loop : einsum_node_loops) {
+                transformations::EinsumExpand transformation(einsum_node_loop.first,
+                                                             einsum_node_loop.second);
+                if (try_apply(transformation, "EinsumExpand", builder,
+                              analysis_manager, this->recipe_)) {
+                    applied = true;
+                    break;
+                }
             }
-        }
-    } while (applied);
+        } while (applied);
+    }
 
     // Einsum2BLAS
-    do {
-        applied = false;
-        auto einsum_nodes = this->get_einsum_nodes(builder);
-        for (auto einsum_node : einsum_nodes) {
-            if (this->impl_ == MKL3) {
-                transformations::Einsum2BLASGemm transformation_gemm(einsum_node.get());
-                if (transformation_gemm.can_be_applied(builder, analysis_manager)) {
-                    transformation_gemm.apply(builder, analysis_manager);
-                    std::cout << "Applied Einsum2BLAS" << std::endl;
+    {
+        CompileProfile::Stage stage("Einsum2BLAS");
+        // Candidates of the autotuner, skipping one of them keeps its loop nest. They are numbered
+        // in the order they are found, element ids differ between the check and run SDFGs
+        std::vector<size_t> candidates;
+        do {
+            applied = false;
+            auto einsum_nodes = this->get_einsum_nodes(builder);
+            for (auto einsum_node : einsum_nodes) {
+                size_t element_id = einsum_node.get().element_id();
+                auto position = std::find(candidates.begin(), candidates.end(), element_id);
+                size_t candidate = position - candidates.begin();
+                if (position == candidates.end()) candidates.push_back(element_id);
+                if (this->config_.skipped_einsums.contains(candidate)) continue;
+                // BUILTIN implements the level 3 calls as well, the other einsums fall back to
+                // Einsum2BLAS
+                if (this->impl_ == MKL3 || this->impl_ == BUILTIN) {
+                    for (auto& lowering : this->config_.lowerings) {
+                        if (lowering == "Gemm") {
+                            transformations::Einsum2BLASGemm transformation(einsum_node.get());
+                            applied = try_apply(transformation, "Einsum2BLASGemm", builder,
+                                                analysis_manager, this->recipe_);
+                        } else if (lowering == "Symm") {
+                            transformations::Einsum2BLASSymm transformation(einsum_node.get());
+                            applied = try_apply(transformation, "Einsum2BLASSymm", builder,
+                                                analysis_manager, this->recipe_);
+                        } else if (lowering == "Syrk") {
+                            transformations::Einsum2BLASSyrk transformation(einsum_node.get());
+                            applied = try_apply(transformation, "Einsum2BLASSyrk", builder,
+                                                analysis_manager, this->recipe_);
+                        }
+                        if (applied) break;
+                    }
+                    if (applied) break;
+                    if (this->impl_ == MKL3) continue;
+                }
+                transformations::Einsum2BLAS transformation(einsum_node.get());
+                if (try_apply(transformation, "Einsum2BLAS", builder,
+                              analysis_manager, this->recipe_)) {
                     applied = true;
                     break;
                 }
-                transformations::Einsum2BLASSymm transformation_symm(einsum_node.get());
-                if (transformation_symm.can_be_applied(builder, analysis_manager)) {
-                    transformation_symm.apply(builder, analysis_manager);
-                    std::cout << "Applied Einsum2BLAS" << std::endl;
+            }
+        } while (applied);
+        this->recipe_["einsum_candidates"] = candidates.size();
+    }
+
+    // BLASScalingFusion
+    {
+        CompileProfile::Stage stage("BLASScalingFusion");
+        do {
+            applied = false;
+            auto library_node_loops = this->get_library_node_predecessor_loops(builder);
+            for (auto& library_node_loop : library_node_loops) {
+                transformations::BLASScalingFusion transformation(library_node_loop.first,
+                                                                  library_node_loop.second);
+                if (try_apply(transformation, "BLASScalingFusion", builder,
+                              analysis_manager, this->recipe_)) {
                     applied = true;
                     break;
                 }
-                transformations::Einsum2BLASSyrk transformation_syrk(einsum_node.get());
-                if (transformation_syrk.can_be_applied(builder, analysis_manager)) {
-                    transformation_syrk.apply(builder, analysis_manager);
-                    std::cout << "Applied Einsum2BLAS" << std::endl;
+            }
+        } while (applied);
+    }
+
+    // LoopFusion
+    if (this->config_.loop_fusion) {
+        CompileProfile::Stage stage("LoopFusion");
+        do {
+            applied = false;
+            auto adjacent_loops = this->get_adjacent_loops(builder);
+            for (auto& adjacent_loop : adjacent_loops) {
+                transformations::LoopFusion transformation(adjacent_loop.first,
+                                                           adjacent_loop.second);
+                if (try_apply(transformation, "LoopFusion", builder,
+                              analysis_manager, this->recipe_)) {
                     applied = true;
                     break;
                 }
-            } else {
-                transformations::Einsum2BLAS transformation(einsum_node.get());
-                if (transformation.can_be_applied(builder, analysis_manager)) {
-                    transformation.apply(builder, analysis_manager);
-                    std::cout << "Applied Einsum2BLAS" << std::endl;
+            }
+        } while (applied);
+    }
+
+    // LoopVectorize
+    if (this->config_.vectorize) {
+        CompileProfile::Stage stage("LoopVectorize");
+        do {
+            applied = false;
+            for (auto* node : loop_analysis(analysis_manager).loops()) {
+                if (auto* loop = dynamic_cast<structured_control_flow::StructuredLoop*>(node)) {
+                    transformations::LoopVectorize transformation(*loop);
+                    if (try_apply(transformation, "LoopVectorize", builder,
+                                  analysis_manager, this->recipe_)) {
+                        applied = true;
+                        break;
+                    }
+                }
+            }
+        } while (applied);
+    }
+
+    // BLASBatching, last since the batched loops must stay as they are. An output shared by the
+    // iterations gets a row per iteration first
+    if (this->config_.batch_blas && this->impl_ != CUBLAS) {
+        CompileProfile::Stage stage("BLASBatching");
+        do {
+            applied = false;
+            for (auto& loop : this->get_loops(builder)) {
+                transformations::BLASOutputExpansion transformation(loop.get());
+                if (try_apply(transformation, "BLASOutputExpansion", builder,
+                              analysis_manager, this->recipe_)) {
                     applied = true;
                     break;
                 }
             }
-        }
-    } while (applied);
+        } while (applied);
+        do {
+            applied = false;
+            for (auto& loop : this->get_loops(builder)) {
+                transformations::BLASBatching transformation(loop.get());
+                if (try_apply(transformation, "BLASBatching", builder,
+                              analysis_manager, this->recipe_)) {
+                    applied = true;
+                    break;
+                }
+            }
+        } while (applied);
+    }
 
     // std::cout << dump_sdfg(builder.subject().root());
 
     return true;
 }
 
+bool EinsumPipeline::replay(builder::StructuredSDFGBuilder& builder,
+                            analysis::AnalysisManager& analysis_manager) {
+    CompileProfile::Stage stage("Replay");
+    for (auto& step : this->recipe_.at("steps")) {
+        // Passes are deterministic and cheap, they are rerun instead of recorded in detail
+        if (step.contains("pass")) {
+            auto pass = step.at("pass").get<std::string>();
+            if (pass == "LoopNormalization") {
+                LoopNormalization loop_normalization;
+                run_nested(loop_normalization, builder, analysis_manager);
+            } else if (pass == "BlockFusion") {
+                this->block_fusion(builder, analysis_manager, builder.subject().root(),
+                                   builder.subject().root());
+            } else if (pass == "DeadCFGElimination") {
+                passes::DeadCFGElimination dead_cfg_elimination;
+                run_nested(dead_cfg_elimination, builder, analysis_manager);
+            } else {
+                std::cerr << "Unknown pass in recipe: " << pass << std::endl;
+                return false;
+            }
+            continue;
+        }
+
+        auto name = step.at("transformation").get<std::string>();
+        auto& description = step.at("description");
+        bool applied;
+        try {
+            if (name == "LoopDistribute") {
+                applied = replay_step<transformations::LoopDistribute>(name, description, builder,
+                                                                       analysis_manager);
+            } else if (name == "MyLoopDistribute") {
+                applied = replay_step<transformations::MyLoopDistribute>(
+                    name, description, builder, analysis_manager);
+            } else if (name == "LoopConsumeAssignments") {
+                applied = replay_step<transformations::LoopConsumeAssignments>(
+                    name, description, builder, analysis_manager);
+            } else if (name == "EinsumLift") {
+                applied = replay_step<transformations::EinsumLift>(name, description, builder,
+                                                                   analysis_manager);
+            } else if (name == "EinsumExpand") {
+                applied = replay_step<transformations::EinsumExpand>(name, description, builder,
+                                                                     analysis_manager);
+            } else if (name == "Einsum2BLAS") {
+                applied = replay_step<transformations::Einsum2BLAS>(name, description, builder,
+                                                                    analysis_manager);
+            } else if (name == "Einsum2BLASGemm") {
+                applied = replay_step<transformations::Einsum2BLASGemm>(name, description, builder,
+                                                                        analysis_manager);
+            } else if (name == "Einsum2BLASSymm") {
+                applied = replay_step<transformations::Einsum2BLASSymm>(name, description, builder,
+                                                                        analysis_manager);
+            } else if (name == "Einsum2BLASSyrk") {
+                applied = replay_step<transformations::Einsum2BLASSyrk>(name, description, builder,
+                                                                        analysis_manager);
+            } else if (name == "BLASScalingFusion") {
+                applied = replay_step<transformations::BLASScalingFusion>(
+                    name, description, builder, analysis_manager);
+            } else if (name == "LoopFusion") {
+                applied = replay_step<transformations::LoopFusion>(name, description, builder,
+                                                                   analysis_manager);
+            } else if (name == "LoopVectorize") {
+                applied = replay_step<transformations::LoopVectorize>(name, description, builder,
+                                                                      analysis_manager);
+            } else if (name == "BLASOutputExpansion") {
+                applied = replay_step<transformations::BLASOutputExpansion>(
+                    name, description, builder, analysis_manager);
+            } else if (name == "BLASBatching") {
+                applied = replay_step<transformations::BLASBatching>(name, description, builder,
+                                                                     analysis_manager);
+            } else {
+                std::cerr << "Unknown transformation in recipe: " << name << std::endl;
+                return false;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Invalid recipe step " << name << ": " << e.what() << std::endl;
+            return false;
+        }
+        if (!applied) {
+            std::cerr << "Recipe step " << name << " does not apply, the recipe is stale"
+                      << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+EinsumPipeline::EinsumPipeline(BLASImplementation impl)
+    : Pass(), impl_(impl), recipe_({{"steps", nlohmann::json::array()}}), replay_(false) {}
+
+EinsumPipeline::EinsumPipeline(BLASImplementation impl, const PipelineConfig& config)
+    : Pass(),
+      impl_(impl),
+      config_(config),
+      recipe_({{"steps", nlohmann::json::array()}}),
+      replay_(false) {}
+
+EinsumPipeline::EinsumPipeline(BLASImplementation impl, const nlohmann::json& recipe)
+    : Pass(), impl_(impl), recipe_(recipe), replay_(true) {}
+
+std::string EinsumPipeline::name() { return "EinsumPipeline"; }
+
+bool EinsumPipeline::run_pass(builder::StructuredSDFGBuilder& builder,
+                              analysis::AnalysisManager& analysis_manager) {
+    if (this->replay_) return this->replay(builder, analysis_manager);
+    return this->search(builder, analysis_manager);
+}
+
+const nlohmann::json& EinsumPipeline::recipe() const { return this->recipe_; }
+
 }  // namespace passes
 }  // namespace sdfg
@@ -0,0 +1,163 @@
+#include "init_parallelization.h"
+
+#include <sdfg/analysis/analysis.h>
+#include <sdfg/builder/structured_sdfg_builder.h>
+#include <sdfg/data_flow/access_node.h>
+#include <sdfg/data_flow/library_node.h>
+#include <sdfg/structured_control_flow/block.h>
+#include <sdfg/structured_control_flow/control_flow_node.h>
+#include <sdfg/structured_control_flow/if_else.h>
+#include <sdfg/structured_control_flow/map.h>
+#include <sdfg/structured_control_flow/sequence.h>
+#include <sdfg/structured_control_flow/structured_loop.h>
+#include <sdfg/symbolic/symbolic.h>
+
+#include <cstddef>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "parallel_dispatcher.h"
+#include "polybench_node.h"
+
+namespace sdfg {
+namespace passes {
+
+bool InitParallelization::independent(structured_control_flow::ControlFlowNode& node,
+                                      const symbolic::Symbol& indvar, const StructuredSDFG& sdfg,
+                                      std::unordered_set<std::string>& written) const {
+    if (auto* block = dynamic_cast<structured_control_flow::Block*>(&node)) {
+        for (auto& dataflow_node : block->dataflow().nodes()) {
+            if (dynamic_cast<data_flow::LibraryNode*>(&dataflow_node)) return false;
+            auto* access_node = dynamic_cast<data_flow::AccessNode*>(&dataflow_node);
+            if (!access_node) continue;
+
+            // Scalars are privatized, arrays must be written at the iteration's own row
+            for (auto& iedge : block->dataflow().in_edges(dataflow_node)) {
+                if (iedge.subset().empty()) {
+                    if (!sdfg.is_transient(access_node->data())) return false;
+                } else {
+                    if (!symbolic::eq(iedge.subset().front(), indvar)) return false;
+                    written.insert(access_node->data());
+                }
+            }
+        }
+        return true;
+    } else if (auto* sequence = dynamic_cast<structured_control_flow::Sequence*>(&node)) {
+        for (size_t i = 0; i < sequence->size(); ++i) {
+            if (!this->independent(sequence->at(i).first, indvar, sdfg, written)) return false;
+        }
+        return true;
+    } else if (auto* loop = dynamic_cast<structured_control_flow::StructuredLoop*>(&node)) {
+        return this->independent(loop->root(), indvar, sdfg, written);
+    } else if (auto* if_else = dynamic_cast<structured_control_flow::IfElse*>(&node)) {
+        for (size_t i = 0; i < if_else->size(); ++i) {
+            if (!this->independent(if_else->at(i).first, indvar, sdfg, written)) return false;
+        }
+        return true;
+    }
+
+    // While loops, Break, Continue and Return
+    return false;
+}
+
+bool InitParallelization::parallelizable(structured_control_flow::Map& map,
+                                         const StructuredSDFG& sdfg) const {
+    if (map.schedule_type().value() != structured_control_flow::ScheduleType_Sequential.value())
+        return false;
+
+    std::unordered_set<std::string> written;
+    if (!this->independent(map.root(), map.indvar(), sdfg, written)) return false;
+
+    // Arrays written by the nest may only be read at the iteration's own row as well
+    std::vector<structured_control_flow::ControlFlowNode*> stack = {&map.root()};
+    while (!stack.empty()) {
+        auto* current = stack.back();
+        stack.pop_back();
+
+        if (auto* block = dynamic_cast<structured_control_flow::Block*>(current)) {
+            for (auto& dataflow_node : block->dataflow().nodes()) {
+                auto* access_node = dynamic_cast<data_flow::AccessNode*>(&dataflow_node);
+                if (!access_node || !written.contains(access_node->data())) continue;
+                for (auto& oedge : block->dataflow().out_edges(dataflow_node)) {
+                    if (oedge.subset().empty()) return false;
+                    if (!symbolic::eq(oedge.subset().front(), map.indvar())) return false;
+                }
+            }
+        } else if (auto* sequence = dynamic_cast<structured_control_flow::Sequence*>(current)) {
+            for (size_t i = 0; i < sequence->size(); ++i) {
+                stack.push_back(&sequence->at(i).first);
+            }
+        } else if (auto* loop = dynamic_cast<structured_control_flow::StructuredLoop*>(current)) {
+            stack.push_back(&loop->root());
+        } else if (auto* if_else = dynamic_cast<structured_control_flow::IfElse*>(current)) {
+            for (size_t i = 0; i < if_else->size(); ++i) {
+                stack.push_back(&if_else->at(i).first);
+            }
+        }
+    }
+
+    return true;
+}
+
+InitParallelization::InitParallelization() : Pass() {};
+
+std::string InitParallelization::name() { return "InitParallelization"; }
+
+bool InitParallelization::run_pass(builder::StructuredSDFGBuilder& builder,
+                                   analysis::AnalysisManager& analysis_manager) {
+    auto& root = builder.subject().root();
+
+    // Initialization happens in front of the timed region
+    std::vector<structured_control_flow::Map*> maps;
+    for (size_t i = 0; i < root.size(); ++i) {
+        auto& child = root.at(i).first;
+        bool scop = false;
+        if (auto* block = dynamic_cast<structured_control_flow::Block*>(&child)) {
+            for (auto& node : block->dataflow().nodes()) {
+                auto* polybench_node = dynamic_cast<polybench::PolyBenchNode*>(&node);
+                if (polybench_node && polybench_node->type() == polybench::StartInstruments)
+                    scop = true;
+            }
+        }
+        if (scop) break;
+
+        auto* map = dynamic_cast<structured_control_flow::Map*>(&child);
+        if (map && this->parallelizable(*map, builder.subject())) maps.push_back(map);
+    }
+
+    for (auto* map : maps) {
+        auto& parallel_map = builder
+                                 .add_map_before(root, *map, map->indvar(), map->condition(),
+                                                 map->init(), map->update(),
+                                                 codegen::ScheduleType_Parallel, {},
+                                                 map->debug_info())
+                                 .first;
+
+        // Move the body including the assignments of its transitions
+        auto& body = map->root();
+        while (body.size() > 0) {
+            auto& child = body.at(0).first;
+            auto assignments = body.at(0).second.assignments();
+            builder.insert(child, body, parallel_map.root(), child.debug_info());
+            auto& transition = parallel_map.root().at(parallel_map.root().size() - 1).second;
+            transition.assignments().insert(assignments.begin(), assignments.end());
+        }
+
+        // Remove the old map but keep the assignments of its transition
+        size_t map_index;
+        for (map_index = 0; map_index < root.size(); ++map_index) {
+            if (root.at(map_index).first.element_id() == map->element_id()) break;
+        }
+        auto& assignments = root.at(map_index).second.assignments();
+        root.at(map_index - 1).second.assignments().insert(assignments.begin(),
+                                                            assignments.end());
+        builder.remove_child(root, map_index);
+    }
+
+    if (!maps.empty()) analysis_manager.invalidate_all();
+    return !maps.empty();
+}
+
+}  // namespace passes
+}  // namespace sdfg
@@ -0,0 +1,277 @@
+#include "loop_fusion.h"
+
+#include <sdfg/analysis/analysis.h>
+#include <sdfg/analysis/scope_analysis.h>
+#include <sdfg/builder/structured_sdfg_builder.h>
+#include <sdfg/data_flow/access_node.h>
+#include <sdfg/data_flow/memlet.h>
+#include <sdfg/structured_control_flow/block.h>
+#include <sdfg/structured_control_flow/control_flow_node.h>
+#include <sdfg/structured_control_flow/if_else.h>
+#include <sdfg/structured_control_flow/map.h>
+#include <sdfg/structured_control_flow/sequence.h>
+#include <sdfg/structured_control_flow/structured_loop.h>
+#include <sdfg/structured_control_flow/while.h>
+#include <sdfg/symbolic/symbolic.h>
+#include <sdfg/transformations/transformation.h>
+#include <symengine/basic.h>
+
+#include <cstddef>
+#include <list>
+#include <string>
+#include <utility>
+
+namespace sdfg {
+namespace transformations {
+
+bool LoopFusion::collect_accesses(structured_control_flow::ControlFlowNode& node,
+                                  Accesses& accesses, symbolic::SymbolSet& indvars) {
+    std::list<structured_control_flow::ControlFlowNode*> queue = {&node};
+    while (!queue.empty()) {
+        auto* current = queue.front();
+        queue.pop_front();
+
+        if (auto* block = dynamic_cast<structured_control_flow::Block*>(current)) {
+            for (auto& dataflow_node : block->dataflow().nodes()) {
+                auto* access_node = dynamic_cast<data_flow::AccessNode*>(&dataflow_node);
+                if (!access_node) continue;
+                for (auto& iedge : block->dataflow().in_edges(dataflow_node)) {
+                    accesses[access_node->data()].push_back({iedge.subset(), true});
+                }
+                for (auto& oedge : block->dataflow().out_edges(dataflow_node)) {
+                    accesses[access_node->data()].push_back({oedge.subset(), false});
+                }
+            }
+        } else if (auto* sequence = dynamic_cast<structured_control_flow::Sequence*>(current)) {
+            for (size_t i = 0; i < sequence->size(); ++i) {
+                queue.push_back(&sequence->at(i).first);
+                for (auto& assign : sequence->at(i).second.assignments()) {
+                    accesses[assign.first->get_name()].push_back({{}, true});
+                    for (auto& atom : symbolic::atoms(assign.second)) {
+                        accesses[atom->get_name()].push_back({{}, false});
+                    }
+                }
+            }
+        } else if (auto* loop = dynamic_cast<structured_control_flow::StructuredLoop*>(current)) {
+            indvars.insert(loop->indvar());
+            queue.push_back(&loop->root());
+        } else if (auto* if_else = dynamic_cast<structured_control_flow::IfElse*>(current)) {
+            for (size_t i = 0; i < if_else->size(); ++i) {
+                queue.push_back(&if_else->at(i).first);
+            }
+        } else if (auto* while_loop = dynamic_cast<structured_control_flow::While*>(current)) {
+            queue.push_back(&while_loop->root());
+        } else {
+            // Break, Continue and Return change the iteration space
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LoopFusion::conflicting(const Accesses& first, const Accesses& second,
+                             const std::string& container, const symbolic::SymbolSet& indvars) {
+    auto first_it = first.find(container);
+    auto second_it = second.find(container);
+    if (first_it == first.end() || second_it == second.end()) return false;
+
+    bool written = false;
+    for (auto& access : first_it->second) written |= access.second;
+    for (auto& access : second_it->second) written |= access.second;
+    if (!written) return false;
+
+    // Every access must touch the same element in the same iteration, i.e., iteration i of the
+    // second loop only depends on iteration i of the first loop. One dimension must be the index
+    // variable with a constant offset, C[i + j] or C[2 * i] reach elements of other iterations
+    auto indvar = this->first_loop_.indvar();
+    auto& reference = first_it->second.front().first;
+    bool selects_iteration = false;
+    for (auto& expr : reference) {
+        if (!symbolic::uses(expr, indvar)) continue;
+        auto offset = symbolic::sub(expr, indvar);
+        bool constant_offset = !symbolic::uses(offset, indvar);
+        for (auto& other : indvars) {
+            if (symbolic::uses(offset, other)) constant_offset = false;
+        }
+        selects_iteration |= constant_offset;
+    }
+    if (!selects_iteration) return true;
+
+    for (auto& access : first_it->second) {
+        if (access.first.size() != reference.size()) return true;
+        for (size_t i = 0; i < reference.size(); ++i) {
+            if (!symbolic::eq(access.first.at(i), reference.at(i))) return true;
+        }
+    }
+    for (auto& access : second_it->second) {
+        if (access.first.size() != reference.size()) return true;
+        for (size_t i = 0; i < reference.size(); ++i) {
+            auto renamed =
+                symbolic::subs(access.first.at(i), this->second_loop_.indvar(), indvar);
+            if (!symbolic::eq(renamed, reference.at(i))) return true;
+        }
+    }
+
+    return false;
+}
+
+LoopFusion::LoopFusion(structured_control_flow::StructuredLoop& first_loop,
+                       structured_control_flow::StructuredLoop& second_loop)
+    : first_loop_(first_loop), second_loop_(second_loop) {}
+
+std::string LoopFusion::name() const { return "LoopFusion"; }
+
+bool LoopFusion::can_be_applied(builder::StructuredSDFGBuilder& builder,
+                                analysis::AnalysisManager& analysis_manager) {
+    // Both loops must be of the same kind
+    auto* first_map = dynamic_cast<structured_control_flow::Map*>(&this->first_loop_);
+    auto* second_map = dynamic_cast<structured_control_flow::Map*>(&this->second_loop_);
+    if ((first_map == nullptr) != (second_map == nullptr)) return false;
+    if (first_map &&
+        first_map->schedule_type().value() != second_map->schedule_type().value())
+        return false;
+
+    // Both loops must be direct neighbors in the same sequence
+    auto& scope_analysis = analysis_manager.get<analysis::ScopeAnalysis>();
+    auto* parent = static_cast<structured_control_flow::Sequence*>(
+        scope_analysis.parent_scope(&this->first_loop_));
+    if (!parent) return false;
+    if (scope_analysis.parent_scope(&this->second_loop_) != parent) return false;
+    size_t first_index;
+    for (first_index = 0; first_index < parent->size(); ++first_index) {
+        if (parent->at(first_index).first.element_id() == this->first_loop_.element_id()) break;
+    }
+    if (first_index + 1 >= parent->size()) return false;
+    if (parent->at(first_index + 1).first.element_id() != this->second_loop_.element_id())
+        return false;
+    if (!parent->at(first_index).second.assignments().empty()) return false;
+
+    // Both loops must have the same iteration space
+    auto first_indvar = this->first_loop_.indvar();
+    auto second_indvar = this->second_loop_.indvar();
+    if (!symbolic::eq(this->first_loop_.init(), this->second_loop_.init())) return false;
+    if (!symbolic::eq(this->first_loop_.update(),
+                      symbolic::subs(this->second_loop_.update(), second_indvar, first_indvar)))
+        return false;
+    SymEngine::map_basic_basic indvar_map;
+    indvar_map[second_indvar] = first_indvar;
+    if (!symbolic::eq(this->first_loop_.condition(),
+                      this->second_loop_.condition()->subs(indvar_map)))
+        return false;
+
+    // Collect all accesses of both loop bodies and the index variables of their nested loops
+    Accesses first_accesses, second_accesses;
+    symbolic::SymbolSet indvars;
+    if (!this->collect_accesses(this->first_loop_.root(), first_accesses, indvars)) return false;
+    if (!this->collect_accesses(this->second_loop_.root(), second_accesses, indvars))
+        return false;
+
+    // The index variable of one loop must not be accessed by the other one
+    for (auto& access : first_accesses) {
+        if (symbolic::eq(symbolic::symbol(access.first), second_indvar)) return false;
+    }
+    for (auto& access : second_accesses) {
+        if (symbolic::eq(symbolic::symbol(access.first), first_indvar)) return false;
+    }
+
+    // Check all containers accessed by both loops
+    for (auto& access : first_accesses) {
+        if (this->conflicting(first_accesses, second_accesses, access.first, indvars))
+            return false;
+    }
+
+    // Check that no written container is used as a symbol by the other loop
+    for (auto& [container, container_accesses] : first_accesses) {
+        bool written = false;
+        for (auto& access : container_accesses) written |= access.second;
+        if (!written) continue;
+        auto sym = symbolic::symbol(container);
+        for (auto& other : second_accesses) {
+            for (auto& access : other.second) {
+                for (auto& expr : access.first) {
+                    if (symbolic::uses(expr, sym)) return false;
+                }
+            }
+        }
+    }
+    for (auto& [container, container_accesses] : second_accesses) {
+        bool written = false;
+        for (auto& access : container_accesses) written |= access.second;
+        if (!written) continue;
+        auto sym = symbolic::symbol(container);
+        for (auto& other : first_accesses) {
+            for (auto& access : other.second) {
+                for (auto& expr : access.first) {
+                    if (symbolic::uses(expr, sym)) return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+void LoopFusion::apply(builder::StructuredSDFGBuilder& builder,
+                       analysis::AnalysisManager& analysis_manager) {
+    auto& scope_analysis = analysis_manager.get<analysis::ScopeAnalysis>();
+    auto* parent = static_cast<structured_control_flow::Sequence*>(
+        scope_analysis.parent_scope(&this->first_loop_));
+
+    // Rename the index variable of the second loop
+    auto& second_body = this->second_loop_.root();
+    second_body.replace(this->second_loop_.indvar(), this->first_loop_.indvar());
+
+    // Move the body of the second loop to the end of the first one
+    auto& first_body = this->first_loop_.root();
+    while (second_body.size() > 0) {
+        auto& child = second_body.at(0).first;
+        auto assignments = second_body.at(0).second.assignments();
+        builder.insert(child, second_body, first_body, child.debug_info());
+        auto& transition = first_body.at(first_body.size() - 1).second;
+        transition.assignments().insert(assignments.begin(), assignments.end());
+    }
+
+    // Remove the second loop but keep the assignments of its transition
+    size_t second_index;
+    for (second_index = 0; second_index < parent->size(); ++second_index) {
+        if (parent->at(second_index).first.element_id() == this->second_loop_.element_id())
+            break;
+    }
+    auto& assignments = parent->at(second_index).second.assignments();
+    parent->at(second_index - 1)
+        .second.assignments()
+        .insert(assignments.begin(), assignments.end());
+    builder.remove_child(*parent, second_index);
+
+    analysis_manager.invalidate_all();
+}
+
+void LoopFusion::to_json(nlohmann::json& j) const {
+    j["transformation_type"] = this->name();
+    j["first_loop_element_id"] = this->first_loop_.element_id();
+    j["second_loop_element_id"] = this->second_loop_.element_id();
+}
+
+LoopFusion LoopFusion::from_json(builder::StructuredSDFGBuilder& builder,
+                                 const nlohmann::json& desc) {
+    auto first_loop_id = desc["first_loop_element_id"].get<size_t>();
+    auto first_element = builder.find_element_by_id(first_loop_id);
+    if (!first_element) {
+        throw InvalidTransformationDescriptionException(
+            "Element with ID " + std::to_string(first_loop_id) + " not found.");
+    }
+    auto first_loop = dynamic_cast<structured_control_flow::StructuredLoop*>(first_element);
+
+    auto second_loop_id = desc["second_loop_element_id"].get<size_t>();
+    auto second_element = builder.find_element_by_id(second_loop_id);
+    if (!second_element) {
+        throw InvalidTransformationDescriptionException(
+            "Element with ID " + std::to_string(second_loop_id) + " not found.");
+    }
+    auto second_loop = dynamic_cast<structured_control_flow::StructuredLoop*>(second_element);
+
+    return LoopFusion(*first_loop, *second_loop);
+}
+
+}  // namespace transformations
+}  // namespace sdfg
@@ -0,0 +1,141 @@
+#include "loop_vectorize.h"
+
+#include <sdfg/analysis/analysis.h>
+#include <sdfg/analysis/scope_analysis.h>
+#include <sdfg/builder/structured_sdfg_builder.h>
+#include <sdfg/data_flow/access_node.h>
+#include <sdfg/data_flow/library_node.h>
+#include <sdfg/data_flow/memlet.h>
+#include <sdfg/structured_control_flow/block.h>
+#include <sdfg/structured_control_flow/map.h>
+#include <sdfg/structured_control_flow/sequence.h>
+#include <sdfg/structured_control_flow/structured_loop.h>
+#include <sdfg/symbolic/symbolic.h>
+#include <sdfg/transformations/transformation.h>
+
+#include <cstddef>
+#include <string>
+
+#include "simd_dispatcher.h"
+
+namespace sdfg {
+namespace transformations {
+
+bool LoopVectorize::unit_stride(const data_flow::Subset& subset, const symbolic::Symbol& indvar) {
+    if (subset.empty()) return true;
+
+    // Only the innermost dimension may depend on the index variable
+    for (size_t i = 0; i + 1 < subset.size(); ++i) {
+        if (symbolic::uses(subset.at(i), indvar)) return false;
+    }
+
+    // ... and only with a constant offset
+    auto& last = subset.back();
+    if (!symbolic::uses(last, indvar)) return true;
+    return !symbolic::uses(symbolic::sub(last, indvar), indvar);
+}
+
+LoopVectorize::LoopVectorize(structured_control_flow::StructuredLoop& loop) : loop_(loop) {}
+
+std::string LoopVectorize::name() const { return "LoopVectorize"; }
+
+bool LoopVectorize::can_be_applied(builder::StructuredSDFGBuilder& builder,
+                                   analysis::AnalysisManager& analysis_manager) {
+    // Only maps are free of loop-carried dependencies
+    auto* map_stmt = dynamic_cast<structured_control_flow::Map*>(&this->loop_);
+    if (!map_stmt) return false;
+    if (map_stmt->schedule_type().value() !=
+        structured_control_flow::ScheduleType_Sequential.value())
+        return false;
+
+    // Unit stride
+    auto indvar = this->loop_.indvar();
+    if (!symbolic::eq(this->loop_.update(), symbolic::add(indvar, symbolic::one()))) return false;
+
+    // Innermost loop with element-wise computations only
+    auto& body = this->loop_.root();
+    if (body.size() == 0) return false;
+    for (size_t i = 0; i < body.size(); ++i) {
+        auto* block = dynamic_cast<structured_control_flow::Block*>(&body.at(i).first);
+        if (!block) return false;
+
+        for (auto& node : block->dataflow().nodes()) {
+            if (dynamic_cast<data_flow::LibraryNode*>(&node)) return false;
+            auto* access_node = dynamic_cast<data_flow::AccessNode*>(&node);
+            if (!access_node) continue;
+
+            for (auto& oedge : block->dataflow().out_edges(node)) {
+                if (!this->unit_stride(oedge.subset(), indvar)) return false;
+            }
+            for (auto& iedge : block->dataflow().in_edges(node)) {
+                if (!this->unit_stride(iedge.subset(), indvar)) return false;
+
+                // Scalar writes are privatized, array writes must be distinct per iteration
+                if (iedge.subset().empty()) {
+                    if (!builder.subject().is_transient(access_node->data())) return false;
+                } else if (!symbolic::uses(iedge.subset().back(), indvar)) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+void LoopVectorize::apply(builder::StructuredSDFGBuilder& builder,
+                          analysis::AnalysisManager& analysis_manager) {
+    auto& scope_analysis = analysis_manager.get<analysis::ScopeAnalysis>();
+    auto* parent =
+        static_cast<structured_control_flow::Sequence*>(scope_analysis.parent_scope(&this->loop_));
+
+    // Add SIMD map in front of the loop
+    auto& simd_loop =
+        builder
+            .add_map_before(*parent, this->loop_, this->loop_.indvar(), this->loop_.condition(),
+                            this->loop_.init(), this->loop_.update(), codegen::ScheduleType_SIMD,
+                            {}, this->loop_.debug_info())
+            .first;
+
+    // Move the body including the assignments of its transitions
+    auto& body = this->loop_.root();
+    while (body.size() > 0) {
+        auto& child = body.at(0).first;
+        auto assignments = body.at(0).second.assignments();
+        builder.insert(child, body, simd_loop.root(), child.debug_info());
+        auto& transition = simd_loop.root().at(simd_loop.root().size() - 1).second;
+        transition.assignments().insert(assignments.begin(), assignments.end());
+    }
+
+    // Remove the old loop but keep the assignments of its transition
+    size_t loop_index;
+    for (loop_index = 0; loop_index < parent->size(); ++loop_index) {
+        if (parent->at(loop_index).first.element_id() == this->loop_.element_id()) break;
+    }
+    auto& assignments = parent->at(loop_index).second.assignments();
+    parent->at(loop_index - 1).second.assignments().insert(assignments.begin(), assignments.end());
+    builder.remove_child(*parent, loop_index);
+
+    analysis_manager.invalidate_all();
+}
+
+void LoopVectorize::to_json(nlohmann::json& j) const {
+    j["transformation_type"] = this->name();
+    j["loop_element_id"] = this->loop_.element_id();
+}
+
+LoopVectorize LoopVectorize::from_json(builder::StructuredSDFGBuilder& builder,
+                                       const nlohmann::json& desc) {
+    auto loop_id = desc["loop_element_id"].get<size_t>();
+    auto element = builder.find_element_by_id(loop_id);
+    if (!element) {
+        throw InvalidTransformationDescriptionException("Element with ID " +
+                                                        std::to_string(loop_id) + " not found.");
+    }
+    auto loop = dynamic_cast<structured_control_flow::StructuredLoop*>(element);
+
+    return LoopVectorize(*loop);
+}
+
+}  // namespace transformations
+}  // namespace sdfg
@@ -10,19 +10,37 @@
 #include <sdfg/einsum/einsum_dispatcher.h>
 #include <sdfg/serializer/json_serializer.h>
 
+#include <cstddef>
+#include <exception>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
-#include <nlohmann/json_fwd.hpp>
+#include <memory>
+#include <nlohmann/json.hpp>
 #include <string>
+#include <unordered_set>
 
 #include "benchmarks.h"
+#include "blas_backend.h"
+#include "blas_batch_dispatcher.h"
+#include "blas_task_dispatcher.h"
+#include "blas_task_scheduling.h"
+#include "compile_profile.h"
+#include "cublas_residency.h"
 #include "einsum_pipeline.h"
+#include "init_parallelization.h"
+#include "parallel_dispatcher.h"
 #include "polybench_node.h"
+#include "scratch_analysis.h"
+#include "simd_dispatcher.h"
+#include "thread_budgeting.h"
 #include "timer.h"
+#include "tuning.h"
 
 void generate_main(sdfg::codegen::PrettyPrinter& stream, Benchmark* benchmark,
-                   const sdfg::StructuredSDFG& sdfg, bool check, BLASImplementation impl) {
+                   const sdfg::StructuredSDFG& sdfg, bool check, BLASImplementation impl,
+                   const std::unordered_set<size_t>& scratch_variables,
+                   const MainOptions& options) {
     if (impl == CUBLAS) {
         stream << "#include <cstdio>" << std::endl
                << "#include <cstring>" << std::endl
@@ -85,6 +103,12 @@ void generate_main(sdfg::codegen::PrettyPrinter& stream, Benchmark* benchmark,
     for (size_t print_variable : benchmark->print_variables()) {
         const Variable& variable = benchmark->variables().at(print_variable);
         stream << "POLYBENCH_DUMP_BEGIN(\"" << variable.name() << "\");" << std::endl;
+        if (variable.dimensions().size() > 0) {
+            stream << "POLYBENCH_DUMP_SHAPE(" << std::to_string(variable.dimensions().size());
+            for (size_t dim : variable.dimensions())
+                stream << ", " << benchmark->dataset_sizes().at(dim).name;
+            stream << ");" << std::endl;
+        }
         for (size_t i = 0; i < variable.dimensions().size(); ++i) {
             stream << "for (int i_" << std::to_string(i) << " = 0; i_" << std::to_string(i) << " < "
                    << benchmark->dataset_sizes().at(variable.dimensions().at(i)).name << "; i_"
@@ -107,9 +131,9 @@ void generate_main(sdfg::codegen::PrettyPrinter& stream, Benchmark* benchmark,
                 }
                 stream << ")";
             }
-            stream << " % 20 == 0) fprintf(POLYBENCH_DUMP_TARGET, \"\\n\");" << std::endl;
+            stream << " % 20 == 0) POLYBENCH_DUMP_NEWLINE;" << std::endl;
         }
-        stream << "fprintf(POLYBENCH_DUMP_TARGET, DATA_PRINTF_MODIFIER, " << variable.name();
+        stream << "POLYBENCH_DUMP_VALUE(" << variable.name();
         for (size_t i = 0; i < variable.dimensions().size(); ++i)
             stream << "[i_" << std::to_string(i) << "]";
         stream << ");" << std::endl;
@@ -123,13 +147,42 @@ void generate_main(sdfg::codegen::PrettyPrinter& stream, Benchmark* benchmark,
     stream.setIndent(0);
     stream << "}" << std::endl << std::endl << "int main(int argc, char** argv) {" << std::endl;
     stream.setIndent(2);
+    if (impl != CUBLAS && options.counters) {
+        stream << "/* Open the counters before any thread is created. */" << std::endl
+               << "polybench_counters_init();" << std::endl
+               << std::endl;
+    }
     stream << "/* Retrieve problem size. */" << std::endl;
     for (auto& dataset_size : benchmark->dataset_sizes()) {
         stream << "int " << dataset_size.name << " = " << dataset_size.macroName << ";"
                << std::endl;
     }
+    stream << std::endl << "/* Work of the kernel, see its performance model. */" << std::endl
+           << "polybench_set_program_flops(" << std::to_string(benchmark->flops(check)) << ");"
+           << std::endl
+           << "polybench_set_program_bytes(" << std::to_string(benchmark->elements(check))
+           << " * sizeof(DATA_TYPE));" << std::endl;
+    if (impl != CUBLAS && options.allocation != DefaultAllocation) {
+        stream << std::endl << "/* Allocation policy. */" << std::endl;
+        stream << "polybench_set_alloc_policy(";
+        if (options.allocation == HugePageAllocation)
+            stream << "POLYBENCH_ALLOC_HUGE_PAGES";
+        else
+            stream << "POLYBENCH_ALLOC_ALIGNED";
+        stream << ", " << options.inter_array_offset << ");" << std::endl;
+    }
+    if (impl != CUBLAS) {
+        stream << std::endl << "/* Threads of OpenMP and the BLAS library. */" << std::endl
+               << "polybench_thread_budget_init();" << std::endl;
+    }
+    if (impl != CUBLAS && options.numa == InterleavePlacement) {
+        stream << std::endl << "/* Spread the pages over all NUMA nodes. */" << std::endl;
+        stream << "polybench_numa_interleave();" << std::endl;
+    }
     stream << std::endl << "/* Variable declaration/allocation. */" << std::endl;
-    for (auto& variable : benchmark->variables()) {
+    for (size_t i = 0; i < benchmark->variables().size(); ++i) {
+        const Variable& variable = benchmark->variables().at(i);
+        if (scratch_variables.contains(i)) continue;
         if (variable.type() == Scalar) {
             stream << "DATA_TYPE " << variable.name() << ";" << std::endl;
         } else {
@@ -142,10 +195,62 @@ void generate_main(sdfg::codegen::PrettyPrinter& stream, Benchmark* benchmark,
             stream << ");" << std::endl;
         }
     }
-    stream << std::endl
-           << "/* Call generated function. */" << std::endl
-           << sdfg.name() << "(" << std::endl;
-    stream.setIndent(10);
+    if (!scratch_variables.empty()) {
+        stream << std::endl
+               << "/* Temporaries only live inside the kernel. */" << std::endl
+               << "polybench_reserve_scratch(";
+        bool first = true;
+        for (size_t i = 0; i < benchmark->variables().size(); ++i) {
+            if (!scratch_variables.contains(i)) continue;
+            const Variable& variable = benchmark->variables().at(i);
+            if (!first) stream << " + ";
+            first = false;
+            stream << "POLYBENCH_SCRATCH_SIZE(";
+            for (size_t j = 0; j < variable.dimensions().size(); ++j) {
+                auto& size = benchmark->dataset_sizes().at(variable.dimensions().at(j));
+                if (j > 0) stream << " * ";
+                stream << "(" << size.macroName << " + POLYBENCH_PADDING_FACTOR)";
+            }
+            stream << ", DATA_TYPE)";
+        }
+        stream << ");" << std::endl;
+        for (size_t i = 0; i < benchmark->variables().size(); ++i) {
+            if (!scratch_variables.contains(i)) continue;
+            const Variable& variable = benchmark->variables().at(i);
+            stream << "POLYBENCH_" << std::to_string(variable.arity()) << "D_SCRATCH_DECL("
+                   << variable.name() << ", DATA_TYPE";
+            for (size_t dim : variable.dimensions())
+                stream << ", " << benchmark->dataset_sizes().at(dim).macroName;
+            for (size_t dim : variable.dimensions())
+                stream << ", " << benchmark->dataset_sizes().at(dim).name;
+            stream << ");" << std::endl;
+        }
+    }
+    if (impl != CUBLAS && options.numa != DefaultPlacement) {
+        stream << std::endl << "/* First touch by the threads of the kernel. */" << std::endl;
+        for (auto& variable : benchmark->variables()) {
+            if (variable.type() == Scalar) continue;
+            stream << "polybench_first_touch(POLYBENCH_ARRAY(" << variable.name()
+                   << "), sizeof(POLYBENCH_ARRAY(" << variable.name() << ")));" << std::endl;
+        }
+    }
+    bool repeat = impl != CUBLAS && options.runs > 0;
+    if (repeat) {
+        stream << std::endl
+               << "/* Repeat in-process, the kernel re-initializes its inputs outside the timed "
+                  "region. */"
+               << std::endl
+               << "polybench_set_repetitions(" << options.runs << ", " << options.warmup << ", "
+               << (options.flush_cache ? 1 : 0) << ");" << std::endl
+               << "for (int run = 0; run < " << options.warmup + options.runs << "; run++) {"
+               << std::endl;
+        stream.setIndent(4);
+        stream << "polybench_next_run();" << std::endl;
+    } else {
+        stream << std::endl;
+    }
+    stream << "/* Call generated function. */" << std::endl << sdfg.name() << "(" << std::endl;
+    stream.setIndent(stream.indent() + 8);
     if (impl == CUBLAS) {
         sdfg::codegen::CPPLanguageExtension le;
         for (size_t i = 0; i < benchmark->call_variables().size(); ++i) {
@@ -164,6 +269,9 @@ void generate_main(sdfg::codegen::PrettyPrinter& stream, Benchmark* benchmark,
     }
     stream << ");" << std::endl;
     stream.setIndent(2);
+    if (repeat) {
+        stream << "}" << std::endl << "polybench_report_repetitions();" << std::endl;
+    }
     stream << std::endl
            << "/* Prevent dead-code elimination. All live-out data must be printed" << std::endl
            << "   by the function call in argument. */" << std::endl
@@ -181,10 +289,12 @@ void generate_main(sdfg::codegen::PrettyPrinter& stream, Benchmark* benchmark,
     stream << "));" << std::endl;
     stream.setIndent(2);
     stream << std::endl << "/* Be clean. */" << std::endl;
-    for (auto& variable : benchmark->variables()) {
-        if (variable.type() == Scalar) continue;
+    for (size_t i = 0; i < benchmark->variables().size(); ++i) {
+        const Variable& variable = benchmark->variables().at(i);
+        if (variable.type() == Scalar || scratch_variables.contains(i)) continue;
         stream << "POLYBENCH_FREE_ARRAY(" << variable.name() << ");" << std::endl;
     }
+    if (!scratch_variables.empty()) stream << "polybench_release_scratch();" << std::endl;
     stream << std::endl << "return 0;" << std::endl;
     stream.setIndent(0);
     stream << "}" << std::endl;
@@ -192,10 +302,6 @@ void generate_main(sdfg::codegen::PrettyPrinter& stream, Benchmark* benchmark,
 
 sdfg::blas::BLASImplementation convert_blas_impl(BLASImplementation impl) {
     switch (impl) {
-        case MKL:
-            return sdfg::blas::BLASImplementation_CBLAS;
-        case MKL3:
-            return sdfg::blas::BLASImplementation_CBLAS;
         case CUBLAS:
             return sdfg::blas::BLASImplementation_CUBLAS;
         default:
@@ -203,13 +309,147 @@ sdfg::blas::BLASImplementation convert_blas_impl(BLASImplementation impl) {
     }
 }
 
+void print_usage() {
+    std::cerr << "Usage: optimize [check|run] [benchmark name] [options]" << std::endl
+              << "Options:" << std::endl
+              << "  --alloc default|aligned|hugepage  allocation policy of the arrays" << std::endl
+              << "  --alloc-offset <bytes>            shift between consecutive arrays"
+              << std::endl
+              << "  --numa interleave|local           page placement of the arrays" << std::endl
+              << "  --regions                         per loop nest and library call timing"
+              << std::endl
+              << "  --counters                        hardware counters through perf_event"
+              << std::endl
+              << "  --runs <n>                        measured in-process repetitions" << std::endl
+              << "  --warmup <n>                      unmeasured runs before them" << std::endl
+              << "  --no-flush                        keep the caches warm between runs"
+              << std::endl
+              << "  --profile                         compile-time profile of the passes as JSON"
+              << std::endl
+              << "  --replay <recipe.json>            apply a recorded recipe without searching"
+              << std::endl
+              << "  --config <config.json>            search with a pipeline configuration"
+              << std::endl
+              << "  --tuning-db <db.json>             database of tuned configurations"
+              << std::endl
+              << "  --no-tuning                       ignore the tuning database" << std::endl
+              << "Available benchmarks: " << BenchmarkRegistry::instance().dump_benchmarks()
+              << std::endl;
+}
+
+// An explicit configuration wins over the tuning database, both check and run binaries use the
+// tuned configuration so that the check verifies what is timed
+bool read_pipeline_config(const MainOptions& options, Benchmark* benchmark,
+                          BLASImplementation impl, PipelineConfig& config) {
+    if (!options.pipeline_config.empty()) {
+        std::ifstream stream(options.pipeline_config);
+        if (!stream.good()) {
+            std::cerr << "Could not open file: " << options.pipeline_config << std::endl;
+            return false;
+        }
+        try {
+            config = nlohmann::json::parse(stream).get<PipelineConfig>();
+        } catch (const std::exception& e) {
+            std::cerr << "Invalid configuration " << options.pipeline_config << ": " << e.what()
+                      << std::endl;
+            return false;
+        }
+        return true;
+    }
+    if (!options.tuning) return true;
+
+    TuningDatabase database(options.tuning_database);
+    auto key = TuningDatabase::key(benchmark->name(), impl);
+    if (auto tuned = database.lookup(key)) {
+        config = *tuned;
+        std::cout << "Using tuned configuration " << key << std::endl;
+    }
+    return true;
+}
+
+bool parse_main_options(int argc, char* argv[], MainOptions& options) {
+    bool offset_given = false;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "--regions") {
+            options.regions = true;
+            continue;
+        }
+        if (arg == "--counters") {
+            options.counters = true;
+            continue;
+        }
+        if (arg == "--no-flush") {
+            options.flush_cache = false;
+            continue;
+        }
+        if (arg == "--profile") {
+            options.profile = true;
+            continue;
+        }
+        if (arg == "--no-tuning") {
+            options.tuning = false;
+            continue;
+        }
+        if (i + 1 >= argc) return false;
+        std::string value(argv[++i]);
+        if (arg == "--alloc") {
+            if (value == "default") {
+                options.allocation = DefaultAllocation;
+            } else if (value == "aligned") {
+                options.allocation = AlignedAllocation;
+            } else if (value == "hugepage") {
+                options.allocation = HugePageAllocation;
+            } else {
+                return false;
+            }
+        } else if (arg == "--alloc-offset") {
+            try {
+                options.inter_array_offset = std::stoul(value);
+            } catch (const std::exception&) {
+                return false;
+            }
+            offset_given = true;
+        } else if (arg == "--runs" || arg == "--warmup") {
+            size_t count;
+            try {
+                count = std::stoul(value);
+            } catch (const std::exception&) {
+                return false;
+            }
+            if (arg == "--runs")
+                options.runs = count;
+            else
+                options.warmup = count;
+        } else if (arg == "--replay") {
+            options.replay_recipe = value;
+        } else if (arg == "--config") {
+            options.pipeline_config = value;
+        } else if (arg == "--tuning-db") {
+            options.tuning_database = value;
+        } else if (arg == "--numa") {
+            if (value == "interleave") {
+                options.numa = InterleavePlacement;
+            } else if (value == "local") {
+                options.numa = LocalPlacement;
+            } else {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    // Five cache lines: consecutive arrays start in different L1 and L2 sets
+    if (options.allocation != DefaultAllocation && !offset_given)
+        options.inter_array_offset = 5 * 64;
+    return true;
+}
+
 int optimize(BLASImplementation impl, int argc, char* argv[]) {
     register_benchmarks(impl);
 
-    if (argc != 3) {
-        std::cerr << "Usage: optimize [check|run] [benchmark name]" << std::endl
-                  << "Available benchmarks: " << BenchmarkRegistry::instance().dump_benchmarks()
-                  << std::endl;
+    if (argc < 3) {
+        print_usage();
         return 1;
     }
 
@@ -220,9 +460,13 @@ int optimize(BLASImplementation impl, int argc, char* argv[]) {
     } else if (argv_1 == "run") {
         check = false;
     } else {
-        std::cerr << "Usage: optimize [check|run] [benchmark name]" << std::endl
-                  << "Available benchmarks: " << BenchmarkRegistry::instance().dump_benchmarks()
-                  << std::endl;
+        print_usage();
+        return 1;
+    }
+
+    MainOptions options;
+    if (!parse_main_options(argc, argv, options)) {
+        print_usage();
         return 1;
     }
 
@@ -241,6 +485,10 @@ int optimize(BLASImplementation impl, int argc, char* argv[]) {
     sdfg::blas::register_blas_dispatchers(convert_blas_impl(impl));
 
     sdfg::polybench::register_polybench_dispatcher();
+    sdfg::codegen::register_simd_dispatcher();
+    sdfg::codegen::register_parallel_dispatcher();
+    sdfg::codegen::register_blas_batch_dispatcher();
+    sdfg::codegen::register_blas_task_dispatcher();
 
     const std::string jsonFile(benchmark->json_path(check));
     std::ifstream stream(jsonFile);
@@ -251,72 +499,171 @@ int optimize(BLASImplementation impl, int argc, char* argv[]) {
     nlohmann::json json = nlohmann::json::parse(stream);
 
     sdfg::serializer::JSONSerializer serializer;
-    auto sdfg = serializer.deserialize(json);
+    auto sdfg = [&]() {
+        CompileProfile::Stage stage("Deserialize");
+        return serializer.deserialize(json);
+    }();
 
     sdfg::builder::StructuredSDFGBuilder builder(sdfg);
     sdfg::analysis::AnalysisManager analysis_manager(builder.subject());
 
-    sdfg::passes::PolyBenchTimerInstrumentation pass(benchmark->code_region());
-    if (!pass.run(builder, analysis_manager)) {
-        std::cerr << "Error: Could not add polybench instrumentation to SDFG" << std::endl;
-        return 1;
+    {
+        CompileProfile::Stage stage("PolyBenchTimerInstrumentation");
+        sdfg::passes::PolyBenchTimerInstrumentation pass(benchmark->code_region());
+        if (!pass.run(builder, analysis_manager)) {
+            std::cerr << "Error: Could not add polybench instrumentation to SDFG" << std::endl;
+            return 1;
+        }
+        CompileProfile::instance().invalidate_analyses();
     }
 
-    sdfg::passes::EinsumPipeline einsum_pipeline(impl);
-    einsum_pipeline.run(builder, analysis_manager);
-
-    if (impl == CUBLAS) {
-        sdfg::codegen::CPPCodeGenerator generator(builder.subject());
-        if (!generator.generate()) {
-            std::cerr << "Error: Could not generate CUDA sources" << std::endl;
+    // Searching records the applied transformations, later runs can replay them directly
+    nlohmann::json recipe;
+    {
+        CompileProfile::Stage stage("EinsumPipeline");
+        std::unique_ptr<sdfg::passes::EinsumPipeline> einsum_pipeline;
+        if (options.replay_recipe.empty()) {
+            PipelineConfig config;
+            if (!read_pipeline_config(options, benchmark, impl, config)) return 1;
+            einsum_pipeline = std::make_unique<sdfg::passes::EinsumPipeline>(impl, config);
+        } else {
+            std::ifstream recipe_stream(options.replay_recipe);
+            if (!recipe_stream.good()) {
+                std::cerr << "Could not open file: " << options.replay_recipe << std::endl;
+                return 1;
+            }
+            einsum_pipeline = std::make_unique<sdfg::passes::EinsumPipeline>(
+                impl, nlohmann::json::parse(recipe_stream));
+        }
+        if (!einsum_pipeline->run(builder, analysis_manager)) {
+            std::cerr << "Error: Could not replay " << options.replay_recipe << std::endl;
             return 1;
         }
+        recipe = einsum_pipeline->recipe();
+    }
+
+    // The inputs are computed by the initialization in front of the timed region
+    if (impl != CUBLAS) {
+        CompileProfile::Stage stage("InitParallelization");
+        sdfg::passes::InitParallelization init_parallelization;
+        if (init_parallelization.run(builder, analysis_manager))
+            std::cout << "Applied InitParallelization" << std::endl;
+    }
+
+    // Independent library calls of the timed region share the BLAS threads
+    if (impl != CUBLAS) {
+        CompileProfile::Stage stage("BLASTaskScheduling");
+        sdfg::passes::BLASTaskScheduling task_scheduling;
+        if (task_scheduling.run(builder, analysis_manager))
+            std::cout << "Applied BLASTaskScheduling" << std::endl;
+    }
 
-        std::filesystem::create_directories(benchmark->out_path(check));
+    // Replaces the fixed OMP_NUM_THREADS and MKL_NUM_THREADS of the whole run
+    if (impl != CUBLAS) {
+        CompileProfile::Stage stage("ThreadBudgeting");
+        sdfg::passes::ThreadBudgeting thread_budgeting;
+        if (thread_budgeting.run(builder, analysis_manager))
+            std::cout << "Applied ThreadBudgeting" << std::endl;
+    }
 
-        if (!generator.as_source(benchmark->out_header_path(check),
-                                 benchmark->out_source_path(check))) {
-            std::cerr << "Error: Could not output CUDA sources" << std::endl;
-            std::cerr << benchmark->out_header_path(check) << std::endl;
+    // The arrays stay on the device between the calls, the host gets them back when it needs them
+    if (impl == CUBLAS) {
+        CompileProfile::Stage stage("CUBLASResidency");
+        sdfg::passes::CUBLASResidency residency(*benchmark, check);
+        if (residency.run(builder, analysis_manager))
+            std::cout << "Applied CUBLASResidency" << std::endl;
+    }
+
+    if (options.counters && impl != CUBLAS) {
+        CompileProfile::Stage stage("PolyBenchCounterInstrumentation");
+        sdfg::passes::PolyBenchCounterInstrumentation counter_instrumentation;
+        if (!counter_instrumentation.run(builder, analysis_manager)) {
+            std::cerr << "Error: Could not add hardware counters to SDFG" << std::endl;
             return 1;
         }
+    }
 
-        std::ofstream out_header;
-        out_header.open(benchmark->out_header_path(check), std::ios_base::app);
-        out_header << std::endl
-                   << "#include <cstdio>" << std::endl
-                   << "#include <polybench.cuh>" << std::endl
-                   << "#include <cuda.h>" << std::endl
-                   << "#include <cublas_v2.h>" << std::endl
-                   << generator.function_definition() << ";" << std::endl;
-        out_header.close();
-    } else {
-        sdfg::codegen::CCodeGenerator generator(builder.subject());
-        if (!generator.generate()) {
-            std::cerr << "Error: Could not generate C sources" << std::endl;
+    if (options.regions && impl != CUBLAS) {
+        CompileProfile::Stage stage("PolyBenchRegionInstrumentation");
+        sdfg::passes::PolyBenchRegionInstrumentation region_instrumentation;
+        if (!region_instrumentation.run(builder, analysis_manager)) {
+            std::cerr << "Error: Could not add timing regions to SDFG" << std::endl;
             return 1;
         }
+    }
 
-        std::filesystem::create_directories(benchmark->out_path(check));
+    {
+        CompileProfile::Stage stage("CodeGeneration");
+        if (impl == CUBLAS) {
+            sdfg::codegen::CPPCodeGenerator generator(builder.subject());
+            if (!generator.generate()) {
+                std::cerr << "Error: Could not generate CUDA sources" << std::endl;
+                return 1;
+            }
 
-        if (!generator.as_source(benchmark->out_header_path(check),
-                                 benchmark->out_source_path(check))) {
-            std::cerr << "Error: Could not output C sources" << std::endl;
-            std::cerr << benchmark->out_header_path(check) << std::endl;
-            return 1;
+            std::filesystem::create_directories(benchmark->out_path(check));
+
+            if (!generator.as_source(benchmark->out_header_path(check),
+                                     benchmark->out_source_path(check))) {
+                std::cerr << "Error: Could not output CUDA sources" << std::endl;
+                std::cerr << benchmark->out_header_path(check) << std::endl;
+                return 1;
+            }
+
+            std::ofstream out_header;
+            out_header.open(benchmark->out_header_path(check), std::ios_base::app);
+            out_header << std::endl
+                       << "#include <cstdio>" << std::endl
+                       << "#include <polybench.cuh>" << std::endl;
+            for (auto& header : blas_backend(impl).headers)
+                out_header << "#include <" << header << ">" << std::endl;
+            out_header << "#include <cuda_residency.cuh>" << std::endl;
+            out_header << generator.function_definition() << ";" << std::endl;
+            out_header.close();
+        } else {
+            sdfg::codegen::CCodeGenerator generator(builder.subject());
+            if (!generator.generate()) {
+                std::cerr << "Error: Could not generate C sources" << std::endl;
+                return 1;
+            }
+
+            std::filesystem::create_directories(benchmark->out_path(check));
+
+            if (!generator.as_source(benchmark->out_header_path(check),
+                                     benchmark->out_source_path(check))) {
+                std::cerr << "Error: Could not output C sources" << std::endl;
+                std::cerr << benchmark->out_header_path(check) << std::endl;
+                return 1;
+            }
+
+            std::ofstream out_header;
+            out_header.open(benchmark->out_header_path(check), std::ios_base::app);
+            out_header << std::endl << "#include <polybench.h>" << std::endl;
+            for (auto& header : blas_backend(impl).headers)
+                out_header << "#include <" << header << ">" << std::endl;
+            if (!blas_backend(impl).set_num_threads.empty()) {
+                out_header << "#define POLYBENCH_BLAS_SET_NUM_THREADS "
+                           << blas_backend(impl).set_num_threads << std::endl;
+            }
+            out_header << "#include <thread_budget.h>" << std::endl;
+            out_header << "#include <blas_batch.h>" << std::endl;
+            out_header << "#include <blas_tasks.h>" << std::endl;
+            out_header << generator.function_definition() << ";" << std::endl;
+            out_header.close();
         }
+    }
 
-        std::ofstream out_header;
-        out_header.open(benchmark->out_header_path(check), std::ios_base::app);
-        out_header << std::endl
-                   << "#include <polybench.h>" << std::endl
-                   << "#include <mkl.h>" << std::endl
-                   << generator.function_definition() << ";" << std::endl;
-        out_header.close();
+    // Temporaries of the kernel are placed in a scratch arena, CUBLAS handles its own buffers
+    std::unordered_set<size_t> scratch_variables;
+    if (impl != CUBLAS) {
+        CompileProfile::Stage stage("ScratchArrayAnalysis");
+        sdfg::analysis::ScratchArrayAnalysis scratch_analysis(*benchmark);
+        scratch_variables = scratch_analysis.run(builder.subject());
     }
 
     sdfg::codegen::PrettyPrinter main_stream;
-    generate_main(main_stream, benchmark, builder.subject(), check, impl);
+    generate_main(main_stream, benchmark, builder.subject(), check, impl, scratch_variables,
+                  options);
     std::ofstream out_main;
     out_main.open(benchmark->out_main_path(check));
     if (!out_main.good()) {
@@ -325,5 +672,18 @@ int optimize(BLASImplementation impl, int argc, char* argv[]) {
     out_main << main_stream.str();
     out_main.close();
 
+    std::ofstream out_recipe(std::filesystem::path(benchmark->out_path(check)) / "recipe.json");
+    out_recipe << recipe.dump(1) << std::endl;
+    out_recipe.close();
+
+    if (options.profile) {
+        auto profile_path =
+            std::filesystem::path(benchmark->out_path(check)) / "compile_profile.json";
+        if (!CompileProfile::instance().write(profile_path)) {
+            std::cerr << "Error: Could not write " << profile_path.string() << std::endl;
+            return 1;
+        }
+    }
+
     return 0;
 }
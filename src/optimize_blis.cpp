@@ -0,0 +1,3 @@
+#include "optimize.h"
+
+int main(int argc, char* argv[]) { return optimize(BLIS, argc, argv); }
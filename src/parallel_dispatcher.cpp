@@ -0,0 +1,101 @@
+#include "parallel_dispatcher.h"
+
+#include <sdfg/codegen/dispatchers/node_dispatcher.h>
+#include <sdfg/codegen/dispatchers/sequence_dispatcher.h>
+#include <sdfg/codegen/instrumentation/instrumentation.h>
+#include <sdfg/codegen/language_extension.h>
+#include <sdfg/codegen/utils.h>
+#include <sdfg/data_flow/access_node.h>
+#include <sdfg/structured_control_flow/block.h>
+#include <sdfg/structured_control_flow/if_else.h>
+#include <sdfg/structured_control_flow/map.h>
+#include <sdfg/structured_control_flow/sequence.h>
+#include <sdfg/structured_control_flow/structured_loop.h>
+#include <sdfg/structured_sdfg.h>
+
+#include <cstddef>
+#include <set>
+#include <string>
+
+namespace sdfg {
+namespace codegen {
+
+ParallelMapDispatcher::ParallelMapDispatcher(LanguageExtension& language_extension,
+                                             StructuredSDFG& sdfg,
+                                             structured_control_flow::Map& node,
+                                             Instrumentation& instrumentation)
+    : NodeDispatcher(language_extension, sdfg, node, instrumentation), node_(node) {}
+
+void ParallelMapDispatcher::private_containers(structured_control_flow::Sequence& sequence,
+                                               std::set<std::string>& result) const {
+    for (size_t i = 0; i < sequence.size(); ++i) {
+        for (auto& assign : sequence.at(i).second.assignments()) {
+            result.insert(assign.first->get_name());
+        }
+
+        auto& child = sequence.at(i).first;
+        if (auto* block = dynamic_cast<structured_control_flow::Block*>(&child)) {
+            for (auto& node : block->dataflow().nodes()) {
+                auto* access_node = dynamic_cast<data_flow::AccessNode*>(&node);
+                if (!access_node) continue;
+                for (auto& iedge : block->dataflow().in_edges(node)) {
+                    if (iedge.subset().empty()) result.insert(access_node->data());
+                }
+            }
+        } else if (auto* loop = dynamic_cast<structured_control_flow::StructuredLoop*>(&child)) {
+            // Index variables of inner loops are declared at function scope
+            result.insert(loop->indvar()->get_name());
+            this->private_containers(loop->root(), result);
+        } else if (auto* if_else = dynamic_cast<structured_control_flow::IfElse*>(&child)) {
+            for (size_t j = 0; j < if_else->size(); ++j) {
+                this->private_containers(if_else->at(j).first, result);
+            }
+        }
+    }
+}
+
+void ParallelMapDispatcher::dispatch_node(PrettyPrinter& main_stream,
+                                          PrettyPrinter& globals_stream,
+                                          PrettyPrinter& library_stream) {
+    // Everything written per iteration must not be shared between threads
+    std::string clauses;
+    std::set<std::string> private_containers;
+    this->private_containers(this->node_.root(), private_containers);
+    private_containers.erase(this->node_.indvar()->get_name());
+    if (!private_containers.empty()) {
+        clauses += " lastprivate(";
+        for (auto& container : private_containers) {
+            if (clauses.back() != '(') clauses += ", ";
+            clauses += container;
+        }
+        clauses += ")";
+    }
+
+    // A static schedule keeps the iteration-to-thread mapping stable across loops
+    main_stream << "#pragma omp parallel for schedule(static)" << clauses << std::endl;
+
+    main_stream << "for";
+    main_stream << "(";
+    main_stream << this->node_.indvar()->get_name();
+    main_stream << " = ";
+    main_stream << this->language_extension_.expression(this->node_.init());
+    main_stream << ";";
+    main_stream << this->language_extension_.expression(this->node_.condition());
+    main_stream << ";";
+    main_stream << this->node_.indvar()->get_name();
+    main_stream << " = ";
+    main_stream << this->language_extension_.expression(this->node_.update());
+    main_stream << ")" << std::endl;
+    main_stream << "{" << std::endl;
+
+    main_stream.setIndent(main_stream.indent() + 4);
+    SequenceDispatcher dispatcher(this->language_extension_, this->sdfg_, this->node_.root(),
+                                  this->instrumentation_);
+    dispatcher.dispatch(main_stream, globals_stream, library_stream);
+    main_stream.setIndent(main_stream.indent() - 4);
+
+    main_stream << "}" << std::endl;
+}
+
+}  // namespace codegen
+}  // namespace sdfg
@@ -20,17 +20,20 @@ namespace polybench {
 
 PolyBenchNode::PolyBenchNode(size_t element_id, const DebugInfo& debug_info,
                              const graph::Vertex vertex, data_flow::DataFlowGraph& parent,
-                             const PolyBenchNodeType type)
+                             const PolyBenchNodeType type, const std::string& region)
     : data_flow::LibraryNode(element_id, debug_info, vertex, parent, LibraryNodeType_PolyBench, {},
                              {}, false),
-      type_(type) {}
+      type_(type),
+      region_(region) {}
 
 PolyBenchNodeType PolyBenchNode::type() const { return this->type_; }
 
+const std::string& PolyBenchNode::region() const { return this->region_; }
+
 std::unique_ptr<data_flow::DataFlowNode> PolyBenchNode::clone(
     size_t element_id, const graph::Vertex vertex, data_flow::DataFlowGraph& parent) const {
     return std::make_unique<PolyBenchNode>(element_id, this->debug_info(), vertex, parent,
-                                           this->type());
+                                           this->type(), this->region());
 }
 
 symbolic::SymbolSet PolyBenchNode::symbols() const { return {}; }
@@ -46,6 +49,28 @@ std::string PolyBenchNode::toStr() const {
             return "PolyBenchStartInstruments";
         case StopAndPrintInstruments:
             return "PolyBenchStopAndPrintInstruments";
+        case StartRegion:
+            return "PolyBenchStartRegion(" + this->region() + ")";
+        case StopRegion:
+            return "PolyBenchStopRegion(" + this->region() + ")";
+        case PrintRegions:
+            return "PolyBenchPrintRegions";
+        case StartCounters:
+            return "PolyBenchStartCounters";
+        case StopAndPrintCounters:
+            return "PolyBenchStopAndPrintCounters";
+        case ThreadBudget:
+            return "PolyBenchThreadBudget";
+        case NestedThreadBudget:
+            return "PolyBenchNestedThreadBudget";
+        case CUDARegister:
+            return "PolyBenchCUDARegister(" + this->region() + ")";
+        case CUDADownload:
+            return "PolyBenchCUDADownload(" + this->region() + ")";
+        case CUDAHostWrite:
+            return "PolyBenchCUDAHostWrite(" + this->region() + ")";
+        case CUDARelease:
+            return "PolyBenchCUDARelease";
     }
 }
 
@@ -66,6 +91,44 @@ void PolyBenchDispatcher::dispatch(codegen::PrettyPrinter& stream) {
             stream << "polybench_stop_instruments;" << std::endl
                    << "polybench_print_instruments;" << std::endl;
             break;
+        case StartRegion:
+            stream << "polybench_region_start(\"" << polybench_node.region() << "\");"
+                   << std::endl;
+            break;
+        case StopRegion:
+            stream << "polybench_region_stop(\"" << polybench_node.region() << "\");"
+                   << std::endl;
+            break;
+        case PrintRegions:
+            stream << "polybench_region_print();" << std::endl;
+            break;
+        case StartCounters:
+            stream << "polybench_counters_start();" << std::endl;
+            break;
+        case StopAndPrintCounters:
+            stream << "polybench_counters_stop();" << std::endl
+                   << "polybench_counters_print();" << std::endl;
+            break;
+        case ThreadBudget:
+            stream << "polybench_thread_budget(POLYBENCH_THREADS_ALL, POLYBENCH_THREADS_ALL);"
+                   << std::endl;
+            break;
+        case NestedThreadBudget:
+            stream << "polybench_thread_budget(POLYBENCH_THREADS_ALL, 1);" << std::endl;
+            break;
+        case CUDARegister:
+            stream << "polybench_cuda_register(" << polybench_node.region() << ");" << std::endl;
+            break;
+        case CUDADownload:
+            stream << "polybench_cuda_download(" << polybench_node.region() << ");" << std::endl;
+            break;
+        case CUDAHostWrite:
+            stream << "polybench_cuda_host_write(" << polybench_node.region() << ");"
+                   << std::endl;
+            break;
+        case CUDARelease:
+            stream << "polybench_cuda_release();" << std::endl;
+            break;
     }
 }
 
@@ -0,0 +1,103 @@
+#include "process.h"
+
+#include <poll.h>
+#include <sched.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+ProcessOutput run_process(const std::vector<std::string>& command,
+                          const std::vector<std::pair<std::string, std::string>>& environment,
+                          const std::vector<int>& cpus) {
+    int out_pipe[2], err_pipe[2];
+    if (pipe(out_pipe) != 0) return {false, "", ""};
+    if (pipe(err_pipe) != 0) {
+        close(out_pipe[0]);
+        close(out_pipe[1]);
+        return {false, "", ""};
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(out_pipe[0]);
+        close(out_pipe[1]);
+        close(err_pipe[0]);
+        close(err_pipe[1]);
+        return {false, "", ""};
+    }
+    if (pid == 0) {
+        dup2(out_pipe[1], STDOUT_FILENO);
+        dup2(err_pipe[1], STDERR_FILENO);
+        close(out_pipe[0]);
+        close(out_pipe[1]);
+        close(err_pipe[0]);
+        close(err_pipe[1]);
+        for (auto& variable : environment) {
+            setenv(variable.first.c_str(), variable.second.c_str(), 1);
+        }
+        if (!cpus.empty()) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu : cpus) CPU_SET(cpu, &set);
+            sched_setaffinity(0, sizeof(set), &set);
+        }
+        std::vector<char*> args;
+        for (auto& arg : command) args.push_back(const_cast<char*>(arg.c_str()));
+        args.push_back(nullptr);
+        execvp(args.front(), args.data());
+        _exit(127);
+    }
+    close(out_pipe[1]);
+    close(err_pipe[1]);
+
+    // Drain both pipes together, the dumps easily exceed the pipe buffer
+    ProcessOutput result{true, "", ""};
+    struct pollfd fds[2] = {{out_pipe[0], POLLIN, 0}, {err_pipe[0], POLLIN, 0}};
+    std::string* targets[2] = {&result.out, &result.err};
+    size_t open_fds = 2;
+    char buffer[65536];
+    while (open_fds > 0) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (size_t i = 0; i < 2; ++i) {
+            if (fds[i].fd < 0 || !(fds[i].revents & (POLLIN | POLLHUP))) continue;
+            ssize_t count = read(fds[i].fd, buffer, sizeof(buffer));
+            if (count > 0) {
+                targets[i]->append(buffer, count);
+            } else {
+                close(fds[i].fd);
+                fds[i].fd = -1;
+                --open_fds;
+            }
+        }
+    }
+
+    // After a failed poll the output is incomplete, closing the pipes keeps the child from
+    // blocking on a full one
+    for (auto& fd : fds) {
+        if (fd.fd >= 0) close(fd.fd);
+    }
+
+    int status;
+    waitpid(pid, &status, 0);
+    result.success = open_fds == 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    return result;
+}
+
+std::vector<std::pair<std::string, std::string>> thread_environment(size_t omp_threads,
+                                                                    size_t mkl_threads) {
+    return {{"OMP_NUM_THREADS", std::to_string(omp_threads)},
+            {"MKL_NUM_THREADS", std::to_string(mkl_threads)},
+            {"POLYBENCH_THREADS", std::to_string(omp_threads)},
+            {"POLYBENCH_BLAS_THREADS", std::to_string(mkl_threads)},
+            {"OMP_PROC_BIND", "close"},
+            {"OMP_PLACES", "cores"}};
+}
@@ -0,0 +1,99 @@
+#include "scratch_analysis.h"
+
+#include <sdfg/data_flow/access_node.h>
+#include <sdfg/structured_control_flow/block.h>
+#include <sdfg/structured_control_flow/control_flow_node.h>
+#include <sdfg/structured_control_flow/if_else.h>
+#include <sdfg/structured_control_flow/sequence.h>
+#include <sdfg/structured_control_flow/structured_loop.h>
+#include <sdfg/structured_control_flow/while.h>
+#include <sdfg/structured_sdfg.h>
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "benchmarks.h"
+#include "polybench_node.h"
+
+namespace sdfg {
+namespace analysis {
+
+ScratchArrayAnalysis::ScratchArrayAnalysis(const Benchmark& benchmark)
+    : benchmark_(benchmark), in_scop_(false) {}
+
+void ScratchArrayAnalysis::access(const std::string& container, bool write) {
+    auto& state = this->states_[container];
+    if (state != Unaccessed) return;
+    if (this->in_scop_ && write)
+        state = ScopWrittenFirst;
+    else
+        state = Escaping;
+}
+
+void ScratchArrayAnalysis::visit(const structured_control_flow::ControlFlowNode& node) {
+    if (auto* block = dynamic_cast<const structured_control_flow::Block*>(&node)) {
+        // Reads of a block happen before its writes
+        std::vector<std::string> writes;
+        for (auto& dataflow_node : block->dataflow().nodes()) {
+            if (auto* polybench_node =
+                    dynamic_cast<const polybench::PolyBenchNode*>(&dataflow_node)) {
+                if (polybench_node->type() == polybench::StartInstruments) this->in_scop_ = true;
+                if (polybench_node->type() == polybench::StopAndPrintInstruments)
+                    this->in_scop_ = false;
+                continue;
+            }
+            auto* access_node = dynamic_cast<const data_flow::AccessNode*>(&dataflow_node);
+            if (!access_node) continue;
+            if (block->dataflow().out_degree(*access_node) > 0)
+                this->access(access_node->data(), false);
+            if (block->dataflow().in_degree(*access_node) > 0)
+                writes.push_back(access_node->data());
+        }
+        for (auto& container : writes) this->access(container, true);
+    } else if (auto* sequence = dynamic_cast<const structured_control_flow::Sequence*>(&node)) {
+        for (size_t i = 0; i < sequence->size(); ++i) this->visit(sequence->at(i).first);
+    } else if (auto* loop = dynamic_cast<const structured_control_flow::StructuredLoop*>(&node)) {
+        this->visit(loop->root());
+    } else if (auto* if_else = dynamic_cast<const structured_control_flow::IfElse*>(&node)) {
+        for (size_t i = 0; i < if_else->size(); ++i) this->visit(if_else->at(i).first);
+    } else if (auto* while_loop = dynamic_cast<const structured_control_flow::While*>(&node)) {
+        this->visit(while_loop->root());
+    }
+}
+
+std::unordered_set<size_t> ScratchArrayAnalysis::run(const StructuredSDFG& sdfg) {
+    this->in_scop_ = false;
+    this->states_.clear();
+    this->visit(sdfg.root());
+
+    // A variable may be passed as several arguments
+    std::unordered_map<size_t, bool> candidates;
+    for (size_t i = 0; i < this->benchmark_.call_variables().size(); ++i) {
+        size_t variable = this->benchmark_.call_variables().at(i);
+        auto& declaration = this->benchmark_.variables().at(variable);
+        // The polybench scratch macros exist up to three dimensions
+        if (declaration.type() == Scalar || declaration.arity() > 3) continue;
+        auto it = this->states_.find(sdfg.arguments().at(i));
+        bool scratch = it != this->states_.end() && it->second == ScopWrittenFirst;
+        if (candidates.contains(variable))
+            candidates[variable] = candidates[variable] && scratch;
+        else
+            candidates[variable] = scratch;
+    }
+
+    std::unordered_set<size_t> result;
+    for (auto& candidate : candidates) {
+        if (!candidate.second) continue;
+        bool printed = false;
+        for (size_t print_variable : this->benchmark_.print_variables())
+            printed |= print_variable == candidate.first;
+        if (!printed) result.insert(candidate.first);
+    }
+    return result;
+}
+
+}  // namespace analysis
+}  // namespace sdfg
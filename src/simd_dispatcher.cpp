@@ -0,0 +1,93 @@
+#include "simd_dispatcher.h"
+
+#include <sdfg/codegen/dispatchers/node_dispatcher.h>
+#include <sdfg/codegen/dispatchers/sequence_dispatcher.h>
+#include <sdfg/codegen/instrumentation/instrumentation.h>
+#include <sdfg/codegen/language_extension.h>
+#include <sdfg/codegen/utils.h>
+#include <sdfg/data_flow/access_node.h>
+#include <sdfg/structured_control_flow/block.h>
+#include <sdfg/structured_control_flow/map.h>
+#include <sdfg/structured_sdfg.h>
+
+#include <cstddef>
+#include <set>
+#include <string>
+
+namespace sdfg {
+namespace codegen {
+
+SIMDMapDispatcher::SIMDMapDispatcher(LanguageExtension& language_extension, StructuredSDFG& sdfg,
+                                     structured_control_flow::Map& node,
+                                     Instrumentation& instrumentation)
+    : NodeDispatcher(language_extension, sdfg, node, instrumentation), node_(node) {}
+
+std::set<std::string> SIMDMapDispatcher::private_containers() const {
+    std::set<std::string> result;
+
+    auto& body = this->node_.root();
+    for (size_t i = 0; i < body.size(); ++i) {
+        for (auto& assign : body.at(i).second.assignments()) {
+            result.insert(assign.first->get_name());
+        }
+
+        auto* block = dynamic_cast<structured_control_flow::Block*>(&body.at(i).first);
+        if (!block) continue;
+        for (auto& node : block->dataflow().nodes()) {
+            auto* access_node = dynamic_cast<data_flow::AccessNode*>(&node);
+            if (!access_node) continue;
+            for (auto& iedge : block->dataflow().in_edges(node)) {
+                if (iedge.subset().empty()) result.insert(access_node->data());
+            }
+        }
+    }
+
+    return result;
+}
+
+void SIMDMapDispatcher::dispatch_node(PrettyPrinter& main_stream, PrettyPrinter& globals_stream,
+                                      PrettyPrinter& library_stream) {
+    // Scalars written per iteration must not be shared between SIMD lanes
+    std::string clauses;
+    auto private_containers = this->private_containers();
+    if (!private_containers.empty()) {
+        clauses += " lastprivate(";
+        for (auto& container : private_containers) {
+            if (clauses.back() != '(') clauses += ", ";
+            clauses += container;
+        }
+        clauses += ")";
+    }
+
+    // The vector length can be fixed at compile time for a specific target
+    main_stream << "#ifdef POLYBENCH_SIMDLEN" << std::endl
+                << "#pragma omp simd simdlen(POLYBENCH_SIMDLEN)" << clauses << std::endl
+                << "#else" << std::endl
+                << "#pragma omp simd" << clauses << std::endl
+                << "#endif" << std::endl;
+
+    main_stream << "for";
+    main_stream << "(";
+    main_stream << this->node_.indvar()->get_name();
+    main_stream << " = ";
+    main_stream << this->language_extension_.expression(this->node_.init());
+    main_stream << ";";
+    main_stream << this->language_extension_.expression(this->node_.condition());
+    main_stream << ";";
+    main_stream << this->node_.indvar()->get_name();
+    main_stream << " = ";
+    main_stream << this->language_extension_.expression(this->node_.update());
+    main_stream << ")" << std::endl;
+    main_stream << "{" << std::endl;
+
+    main_stream.setIndent(main_stream.indent() + 4);
+    SequenceDispatcher dispatcher(this->language_extension_, this->sdfg_, this->node_.root(),
+                                  this->instrumentation_);
+    dispatcher.dispatch(main_stream, globals_stream, library_stream);
+    main_stream.setIndent(main_stream.indent() - 4);
+
+    main_stream << "}" << std::endl;
+}
+
+}  // namespace codegen
+}  // namespace sdfg
@@ -0,0 +1,101 @@
+#include "thread_budgeting.h"
+
+#include <sdfg/analysis/analysis.h>
+#include <sdfg/builder/structured_sdfg_builder.h>
+#include <sdfg/data_flow/library_node.h>
+#include <sdfg/element.h>
+#include <sdfg/structured_control_flow/block.h>
+#include <sdfg/structured_control_flow/control_flow_node.h>
+#include <sdfg/structured_control_flow/if_else.h>
+#include <sdfg/structured_control_flow/map.h>
+#include <sdfg/structured_control_flow/sequence.h>
+#include <sdfg/structured_control_flow/structured_loop.h>
+#include <sdfg/structured_control_flow/while.h>
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+#include "blas_batch_dispatcher.h"
+#include "parallel_dispatcher.h"
+#include "polybench_node.h"
+
+namespace sdfg {
+namespace passes {
+
+ThreadBudgeting::ThreadBudgeting() : Pass() {};
+
+std::string ThreadBudgeting::name() { return "ThreadBudgeting"; }
+
+void ThreadBudgeting::needs(structured_control_flow::ControlFlowNode& node, bool parallel,
+                            Needs& result) const {
+    if (auto* block = dynamic_cast<structured_control_flow::Block*>(&node)) {
+        for (auto& dataflow_node : block->dataflow().nodes()) {
+            if (dynamic_cast<polybench::PolyBenchNode*>(&dataflow_node)) continue;
+            if (!dynamic_cast<data_flow::LibraryNode*>(&dataflow_node)) continue;
+            if (parallel)
+                result.nested_calls = true;
+            else
+                result.sequential_calls = true;
+        }
+    } else if (auto* sequence = dynamic_cast<structured_control_flow::Sequence*>(&node)) {
+        for (size_t i = 0; i < sequence->size(); ++i) {
+            this->needs(sequence->at(i).first, parallel, result);
+        }
+    } else if (auto* map_stmt = dynamic_cast<structured_control_flow::Map*>(&node)) {
+        // Batches issue their calls from sequential code and fall back to a parallel loop that
+        // sets its own budget, task regions split the budget of their calls
+        auto schedule_type = map_stmt->schedule_type().value();
+        if (schedule_type == codegen::ScheduleType_Parallel.value()) {
+            result.parallel_loops = true;
+            this->needs(map_stmt->root(), true, result);
+        } else {
+            if (schedule_type == codegen::ScheduleType_BLASBatch.value())
+                result.parallel_loops = true;
+            this->needs(map_stmt->root(), parallel, result);
+        }
+    } else if (auto* loop = dynamic_cast<structured_control_flow::StructuredLoop*>(&node)) {
+        this->needs(loop->root(), parallel, result);
+    } else if (auto* if_else = dynamic_cast<structured_control_flow::IfElse*>(&node)) {
+        for (size_t i = 0; i < if_else->size(); ++i) {
+            this->needs(if_else->at(i).first, parallel, result);
+        }
+    } else if (auto* while_loop = dynamic_cast<structured_control_flow::While*>(&node)) {
+        this->needs(while_loop->root(), parallel, result);
+    }
+}
+
+bool ThreadBudgeting::run_pass(builder::StructuredSDFGBuilder& builder,
+                               analysis::AnalysisManager& analysis_manager) {
+    auto& root = builder.subject().root();
+
+    bool applied = false;
+    std::optional<polybench::PolyBenchNodeType> current;
+    for (size_t i = 0; i < root.size(); ++i) {
+        Needs needs;
+        this->needs(root.at(i).first, false, needs);
+
+        // Parallel loops without calls get all threads under either budget
+        std::optional<polybench::PolyBenchNodeType> budget;
+        if (needs.sequential_calls)
+            budget = polybench::ThreadBudget;
+        else if (needs.nested_calls)
+            budget = polybench::NestedThreadBudget;
+        else if (needs.parallel_loops && !current)
+            budget = polybench::ThreadBudget;
+        if (!budget || budget == current) continue;
+
+        auto& block = builder.add_block_before(root, root.at(i).first).first;
+        builder.add_library_node<polybench::PolyBenchNode, const polybench::PolyBenchNodeType>(
+            block, DebugInfo(), *budget);
+        current = budget;
+        ++i;
+        applied = true;
+    }
+
+    if (applied) analysis_manager.invalidate_all();
+    return applied;
+}
+
+}  // namespace passes
+}  // namespace sdfg
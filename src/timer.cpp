@@ -2,13 +2,21 @@
 
 #include <sdfg/analysis/analysis.h>
 #include <sdfg/builder/structured_sdfg_builder.h>
+#include <sdfg/data_flow/library_node.h>
 #include <sdfg/element.h>
 #include <sdfg/structured_control_flow/block.h>
+#include <sdfg/structured_control_flow/control_flow_node.h>
+#include <sdfg/structured_control_flow/if_else.h>
+#include <sdfg/structured_control_flow/map.h>
+#include <sdfg/structured_control_flow/sequence.h>
+#include <sdfg/structured_control_flow/structured_loop.h>
+#include <sdfg/structured_control_flow/while.h>
 
 #include <cstddef>
 #include <string>
 
 #include "benchmarks.h"
+#include "blas_task_dispatcher.h"
 #include "polybench_node.h"
 
 namespace sdfg {
@@ -59,5 +67,167 @@ bool PolyBenchTimerInstrumentation::run_pass(builder::StructuredSDFGBuilder& bui
     return true;
 }
 
+namespace {
+
+polybench::PolyBenchNode* find_polybench_node(structured_control_flow::ControlFlowNode& node,
+                                              polybench::PolyBenchNodeType type) {
+    auto* block = dynamic_cast<structured_control_flow::Block*>(&node);
+    if (!block) return nullptr;
+    for (auto& dataflow_node : block->dataflow().nodes()) {
+        auto* polybench_node = dynamic_cast<polybench::PolyBenchNode*>(&dataflow_node);
+        if (polybench_node && polybench_node->type() == type) return polybench_node;
+    }
+    return nullptr;
+}
+
+data_flow::LibraryNode* find_library_node(structured_control_flow::ControlFlowNode& node) {
+    auto* block = dynamic_cast<structured_control_flow::Block*>(&node);
+    if (!block) return nullptr;
+    for (auto& dataflow_node : block->dataflow().nodes()) {
+        if (dynamic_cast<polybench::PolyBenchNode*>(&dataflow_node)) continue;
+        if (auto* library_node = dynamic_cast<data_flow::LibraryNode*>(&dataflow_node))
+            return library_node;
+    }
+    return nullptr;
+}
+
+std::string region_name(const std::string& prefix, const Element& element) {
+    std::string name = prefix + "#" + std::to_string(element.element_id());
+    if (element.debug_info().has())
+        name += "@" + std::to_string(element.debug_info().start_line());
+    return name;
+}
+
+}  // namespace
+
+bool find_instruments(structured_control_flow::Sequence& root, size_t& scop_index,
+                      size_t& endscop_index) {
+    bool seen_scop = false, seen_endscop = false;
+    for (size_t i = 0; i < root.size(); ++i) {
+        if (!seen_scop && find_polybench_node(root.at(i).first, polybench::StartInstruments)) {
+            scop_index = i;
+            seen_scop = true;
+        }
+        if (!seen_endscop &&
+            find_polybench_node(root.at(i).first, polybench::StopAndPrintInstruments)) {
+            endscop_index = i;
+            seen_endscop = true;
+        }
+    }
+    return seen_scop && seen_endscop && scop_index < endscop_index;
+}
+
+PolyBenchRegionInstrumentation::PolyBenchRegionInstrumentation() : Pass() {};
+
+std::string PolyBenchRegionInstrumentation::name() { return "PolyBenchRegionInstrumentation"; }
+
+void PolyBenchRegionInstrumentation::wrap(builder::StructuredSDFGBuilder& builder,
+                                          structured_control_flow::Sequence& sequence,
+                                          size_t index, const std::string& region) {
+    structured_control_flow::Block* stop_block;
+    if (index + 1 == sequence.size()) {
+        stop_block = &builder.add_block(sequence);
+    } else {
+        stop_block = &builder.add_block_before(sequence, sequence.at(index + 1).first).first;
+    }
+    builder.add_library_node<polybench::PolyBenchNode, const polybench::PolyBenchNodeType,
+                             const std::string>(*stop_block, DebugInfo(), polybench::StopRegion,
+                                                region);
+
+    auto& start_block = builder.add_block_before(sequence, sequence.at(index).first).first;
+    builder.add_library_node<polybench::PolyBenchNode, const polybench::PolyBenchNodeType,
+                             const std::string>(start_block, DebugInfo(), polybench::StartRegion,
+                                                region);
+}
+
+void PolyBenchRegionInstrumentation::instrument(builder::StructuredSDFGBuilder& builder,
+                                                structured_control_flow::Sequence& sequence,
+                                                size_t begin, size_t end, bool top_level) {
+    // Back to front, wrapping only shifts the children that are already instrumented
+    for (size_t i = end; i > begin; --i) {
+        auto& child = sequence.at(i - 1).first;
+
+        if (auto* library_node = find_library_node(child)) {
+            if (top_level)
+                this->wrap(builder, sequence, i - 1,
+                           region_name(library_node->code().value(), child));
+            continue;
+        }
+
+        std::string prefix;
+        auto* map_stmt = dynamic_cast<structured_control_flow::Map*>(&child);
+        if (map_stmt &&
+            map_stmt->schedule_type().value() == codegen::ScheduleType_BLASTasks.value()) {
+            // The tasks run concurrently, the region timers are not thread-safe
+            if (!top_level) continue;
+            prefix = "tasks";
+        } else if (auto* loop = dynamic_cast<structured_control_flow::StructuredLoop*>(&child)) {
+            this->instrument(builder, loop->root(), 0, loop->root().size(), false);
+            prefix = "loop";
+        } else if (auto* while_loop = dynamic_cast<structured_control_flow::While*>(&child)) {
+            this->instrument(builder, while_loop->root(), 0, while_loop->root().size(), false);
+            prefix = "loop";
+        } else if (auto* if_else = dynamic_cast<structured_control_flow::IfElse*>(&child)) {
+            for (size_t j = 0; j < if_else->size(); ++j) {
+                auto& branch = if_else->at(j).first;
+                this->instrument(builder, branch, 0, branch.size(), false);
+            }
+            prefix = "branch";
+        } else if (auto* nested = dynamic_cast<structured_control_flow::Sequence*>(&child)) {
+            this->instrument(builder, *nested, 0, nested->size(), top_level);
+        }
+
+        // Timing every iteration of inner loops would distort the measurement
+        if (top_level && !prefix.empty())
+            this->wrap(builder, sequence, i - 1, region_name(prefix, child));
+    }
+}
+
+bool PolyBenchRegionInstrumentation::run_pass(builder::StructuredSDFGBuilder& builder,
+                                              analysis::AnalysisManager& analysis_manager) {
+    auto& root = builder.subject().root();
+
+    size_t scop_index, endscop_index;
+    if (!find_instruments(root, scop_index, endscop_index)) return false;
+
+    // Print the breakdown right after the instruments of the whole region
+    structured_control_flow::Block* print_block;
+    if (endscop_index + 1 == root.size()) {
+        print_block = &builder.add_block(root);
+    } else {
+        print_block = &builder.add_block_before(root, root.at(endscop_index + 1).first).first;
+    }
+    builder.add_library_node<polybench::PolyBenchNode, const polybench::PolyBenchNodeType>(
+        *print_block, DebugInfo(), polybench::PrintRegions);
+
+    this->instrument(builder, root, scop_index + 1, endscop_index, true);
+
+    analysis_manager.invalidate_all();
+    return true;
+}
+
+PolyBenchCounterInstrumentation::PolyBenchCounterInstrumentation() : Pass() {};
+
+std::string PolyBenchCounterInstrumentation::name() { return "PolyBenchCounterInstrumentation"; }
+
+bool PolyBenchCounterInstrumentation::run_pass(builder::StructuredSDFGBuilder& builder,
+                                               analysis::AnalysisManager& analysis_manager) {
+    auto& root = builder.subject().root();
+
+    size_t scop_index, endscop_index;
+    if (!find_instruments(root, scop_index, endscop_index)) return false;
+
+    auto& stop_block = builder.add_block_before(root, root.at(endscop_index).first).first;
+    builder.add_library_node<polybench::PolyBenchNode, const polybench::PolyBenchNodeType>(
+        stop_block, DebugInfo(), polybench::StopAndPrintCounters);
+
+    auto& start_block = builder.add_block_before(root, root.at(scop_index + 1).first).first;
+    builder.add_library_node<polybench::PolyBenchNode, const polybench::PolyBenchNodeType>(
+        start_block, DebugInfo(), polybench::StartCounters);
+
+    analysis_manager.invalidate_all();
+    return true;
+}
+
 }  // namespace passes
-}  // namespace sdfg
\ No newline at end of file
+}  // namespace sdfg
@@ -0,0 +1,115 @@
+#include "tuning.h"
+
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "blas_backend.h"
+
+void to_json(nlohmann::json& json, const PipelineConfig& config) {
+    json["skipped_einsums"] = config.skipped_einsums;
+    json["lowerings"] = config.lowerings;
+    json["loop_fusion"] = config.loop_fusion;
+    json["vectorize"] = config.vectorize;
+    json["batch_blas"] = config.batch_blas;
+}
+
+void from_json(const nlohmann::json& json, PipelineConfig& config) {
+    // Missing knobs keep their defaults, older databases stay readable
+    if (json.contains("skipped_einsums"))
+        config.skipped_einsums = json.at("skipped_einsums").get<std::set<size_t>>();
+    if (json.contains("lowerings"))
+        config.lowerings = json.at("lowerings").get<std::vector<std::string>>();
+    if (json.contains("loop_fusion")) config.loop_fusion = json.at("loop_fusion").get<bool>();
+    if (json.contains("vectorize")) config.vectorize = json.at("vectorize").get<bool>();
+    if (json.contains("batch_blas")) config.batch_blas = json.at("batch_blas").get<bool>();
+}
+
+std::string implementation_name(BLASImplementation impl) { return blas_backend(impl).name; }
+
+std::string machine_fingerprint() {
+    std::string cpu = "unknown", memory = "0";
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.starts_with("model name")) {
+            auto pos = line.find(':');
+            if (pos != std::string::npos) cpu = line.substr(line.find_first_not_of(" ", pos + 1));
+            break;
+        }
+    }
+    std::ifstream meminfo("/proc/meminfo");
+    while (std::getline(meminfo, line)) {
+        if (line.starts_with("MemTotal")) {
+            std::istringstream fields(line.substr(line.find(':') + 1));
+            fields >> memory;
+            break;
+        }
+    }
+    std::string key =
+        cpu + "|" + std::to_string(std::thread::hardware_concurrency()) + "|" + memory;
+
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : key) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    std::stringstream stream;
+    stream << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return stream.str();
+}
+
+TuningDatabase::TuningDatabase(const std::filesystem::path& path)
+    : path_(path), entries_(nlohmann::json::object()) {
+    std::ifstream in(path);
+    if (!in.good()) return;
+    try {
+        this->entries_ = nlohmann::json::parse(in).at("entries");
+    } catch (const std::exception& e) {
+        std::cerr << "Ignoring invalid tuning database " << path.string() << ": " << e.what()
+                  << std::endl;
+    }
+}
+
+std::string TuningDatabase::key(const std::string& benchmark, BLASImplementation impl) {
+    return benchmark + "/" + implementation_name(impl) + "/" + TUNING_DATASET + "/" +
+           machine_fingerprint();
+}
+
+std::optional<PipelineConfig> TuningDatabase::lookup(const std::string& key) const {
+    if (!this->entries_.contains(key)) return std::nullopt;
+    try {
+        return this->entries_.at(key).at("config").get<PipelineConfig>();
+    } catch (const std::exception& e) {
+        std::cerr << "Ignoring invalid tuning entry " << key << ": " << e.what() << std::endl;
+        return std::nullopt;
+    }
+}
+
+void TuningDatabase::store(const std::string& key, const PipelineConfig& config, double seconds,
+                           double default_seconds) {
+    auto& entry = this->entries_[key];
+    entry["config"] = config;
+    entry["seconds"] = seconds;
+    entry["default_seconds"] = default_seconds;
+}
+
+bool TuningDatabase::save() const {
+    if (this->path_.has_parent_path())
+        std::filesystem::create_directories(this->path_.parent_path());
+    std::ofstream out(this->path_);
+    if (!out.good()) return false;
+    nlohmann::json json;
+    json["entries"] = this->entries_;
+    out << json.dump(1) << std::endl;
+    return out.good();
+}